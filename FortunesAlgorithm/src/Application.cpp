@@ -1,15 +1,22 @@
+#include "algo/BreakpointBatch.h"
 #include "algo/FortunesAlgorithm.h"
+#include "algo/SelfCheck.h"
 #include "types/Point.h";
 #include "utils/Conversion.h"
 #include "utils/PriorityQueue.h"
+#include "utils/SnapshotBuffer.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <direct.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <thread>
 #include <time.h>
 
-void drawBeachLine(const std::vector<BL::Arc*>& beachLine, const double h);
+void computeLoop();
+void drawBeachLine(const SweepSnapshot& snapshot, const double h);
 void drawParabola(const Point& point, const double lh, double x1, double x2);
 void drawLine(const Point& p1, const Point& p2);
 void drawPoints(const std::vector<Point>& points);
@@ -20,12 +27,19 @@ VoronoiDiagram* voronoi;
 bool showTri = false, pause = true;
 double speed = 5.0;
 
+// The algorithm runs on its own thread and hands finished frames over through snapshots
+SnapshotBuffer<SweepSnapshot> snapshots;
+std::atomic<double> targetHeight(0.0);
+std::atomic<bool> runToEnd(false), computeDone(false), quit(false);
+
 char currentPath[FILENAME_MAX];
 
 int main(int argc, char* argv[])
 {
     if (argc < 2)
         return -1;
+    if (std::string(argv[1]) == "--check")
+        return RunSelfChecks(std::cout) ? 0 : 1;
     GLFWwindow* window;
 
     /* Initialize the library */
@@ -54,6 +68,7 @@ int main(int argc, char* argv[])
 
     voronoi = new VoronoiDiagram(cPath + "\\" + argv[1]);
     //voronoi = new VoronoiDiagram(points);
+    std::cout << "Number of sites: " << voronoi->Sites.size() << std::endl;
     algorithm = new FortunesAlgorithm(*voronoi);
     FortunesAlgorithm& fA = *algorithm;
 
@@ -62,6 +77,9 @@ int main(int argc, char* argv[])
     /* Make the window's context current */
     glfwMakeContextCurrent(window);
 
+    targetHeight = PlaneBounds::GetInstance()->Upper;
+    std::thread worker(computeLoop);
+
     /* Loop until the user closes the window */
     double x, y, pastTime = 0, totalTime = 0, time;
     bool printed = false;
@@ -69,7 +87,7 @@ int main(int argc, char* argv[])
     {
 
         glClear(GL_COLOR_BUFFER_BIT);
-        double time = fA.GetHeight();
+        const SweepSnapshot& snapshot = snapshots.Read();
 
         if (!pause)
         {
@@ -83,12 +101,13 @@ int main(int argc, char* argv[])
         glColor3f(1.0f, 1.0f, 1.0f); // Set color to white
         drawPoints(voronoi->Points);
 
-        if (fA.IsComplete())
+        if (snapshot.Complete)
         {
+            // The worker has finished writing to the diagram once it publishes a complete snapshot
             //SetPlaneBounds(fA.MinX, fA.MaxX, fA.MinY, fA.MaxY);
-            for (const BL::Edge* edge : fA.GetInfiniteEdges())
+            for (const std::pair<Point, Point>& edge : snapshot.InfiniteEdges)
             {
-                drawLine(*edge->Start, *edge->End);
+                drawLine(edge.first, edge.second);
             }
 
             if(showTri) 
@@ -101,16 +120,19 @@ int main(int argc, char* argv[])
             }
 
             if (!printed)
+            {
                 voronoi->PrintToFile(cPath + "\\voronoi.txt");
+                printed = true;
+            }
 
-            time = fA.GetHeight();
+            time = snapshot.SweepHeight;
         }
         else
         {
-            fA.Continues(time);
-            drawBeachLine(fA.InOrder(), time);
+            targetHeight = time;
+            drawBeachLine(snapshot, time);
             if (time < PlaneBounds::GetInstance()->Lower)
-                fA.Run();
+                runToEnd = true;
         }
 
         //Drawing Sweep Line
@@ -118,9 +140,9 @@ int main(int argc, char* argv[])
         drawLine(Point({ PlaneBounds::GetInstance()->Left, time }), Point(PlaneBounds::GetInstance()->Right, time));
 
         glColor3f(1.0f, 1.0f, 1.0f); // Set color to white
-        for (const BL::Edge* edge : fA.GetCompletedEdges())
+        for (const std::pair<Point, Point>& edge : snapshot.CompletedEdges)
         {
-            drawLine(*edge->Start, *edge->End);
+            drawLine(edge.first, edge.second);
         }
 
         // Drawing Vertices
@@ -134,6 +156,9 @@ int main(int argc, char* argv[])
         glfwPollEvents();
     }
 
+    quit = true;
+    worker.join();
+
     glfwTerminate();
     delete algorithm;
     delete voronoi;
@@ -144,9 +169,9 @@ int main(int argc, char* argv[])
 // Key callback function
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action == GLFW_PRESS) {
-        if (key == 257 && !algorithm->IsComplete())
+        if (key == 257)
         {
-            algorithm->Run();
+            runToEnd = true;
         }
         else if (key == 32)
         {
@@ -159,6 +184,14 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         else if (key == 83) {
             if(speed >= 0) speed /= 1.5;
         }
+        else if (key == 84)
+        {
+            showTri = !showTri;
+        }
+        else if (!computeDone)
+        {
+            // The remaining keys read the diagram, which the worker still owns
+        }
         else if (key == 48)
         {
             voronoi->PrintVoronoiDCEL(std::cout);
@@ -167,10 +200,6 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         {
             voronoi->PrintDelaunayTriangulation(std::cout);
         }
-        else if (key == 84)
-        {
-            showTri = !showTri;
-        }
         else if (key == 49)
         {
             std::cout << algorithm->MinX << ", " << algorithm->MaxX << std::endl;
@@ -180,42 +209,69 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
-void drawBeachLine(const std::vector<BL::Arc*>& beachLine, const double h)
+// Runs the sweep behind the render loop, following the height the viewer asks for
+void computeLoop()
+{
+    while (!quit)
+    {
+        if (runToEnd)
+        {
+            algorithm->Run();
+            algorithm->TakeSnapshot(snapshots.WriteBuffer());
+            snapshots.Publish();
+            computeDone = true;
+            return;
+        }
+
+        // Publish at least once a frame even when a lot of events are waiting
+        double height = targetHeight;
+        size_t remaining = algorithm->AdvanceTo(height, 0, 1.0 / 60.0);
+        algorithm->TakeSnapshot(snapshots.WriteBuffer());
+        snapshots.Publish();
+
+        // Nothing left above the sweep line until the viewer moves it further
+        if (0 == remaining && height == targetHeight)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void drawBeachLine(const SweepSnapshot& snapshot, const double h)
 {
     double lastBreakPointX = PlaneBounds::GetInstance()->Left;
-    double nextBreakPoint = PlaneBounds::GetInstance()->Right;
-    if (0 == beachLine.size())
+    if (0 == snapshot.Arcs.size())
         return;
 
-    if (1 == beachLine.size())
-    {
-        drawParabola(beachLine[0]->Site->point, h, lastBreakPointX, nextBreakPoint);
-        return;
-    }
+    // Place every breakpoint for this frame in one batch
+    static std::vector<double> breakpointX;
+    BreakpointsAt(snapshot.Breakpoints, h, breakpointX);
 
-    for (int i = 1; i < beachLine.size(); i += 2)
+    for (size_t i = 0; i < snapshot.Breakpoints.size(); i++)
     {
-        if (nullptr == beachLine[i]->Edge)
-            continue;
-        if (beachLine[i]->Edge->IsVertical)
-            nextBreakPoint = (beachLine[i]->Edge->Left->point.x + beachLine[i]->Edge->Right->point.x) / 2.0;
-        else
-            nextBreakPoint = IntersectionX(beachLine[i]->Edge->Left->point, beachLine[i]->Edge->Right->point, h);
-        drawParabola(beachLine[i - 1]->Site->point, h, lastBreakPointX, nextBreakPoint);
-        drawLine(*beachLine[i]->Edge->Start,
-            Point({ nextBreakPoint, CalculateParabolaY(nextBreakPoint, h, beachLine[i - 1]->Site->point) }));
+        const SnapshotBreakpoint& breakpoint = snapshot.Breakpoints[i];
+        const double nextBreakPoint = breakpointX[i];
+        drawParabola(breakpoint.Left, h, lastBreakPointX, nextBreakPoint);
+        if (breakpoint.Traced)
+            drawLine(breakpoint.Start, Point({ nextBreakPoint, CalculateParabolaY(nextBreakPoint, h, breakpoint.Left) }));
         lastBreakPointX = nextBreakPoint;
     }
 
-    drawParabola(beachLine[beachLine.size() - 1]->Site->point, h, lastBreakPointX, PlaneBounds::GetInstance()->Right);
+    drawParabola(snapshot.Arcs.back(), h, lastBreakPointX, PlaneBounds::GetInstance()->Right);
 }
 
 void drawParabola(const Point& point, const double lh, double x1, double x2) {
+    static std::vector<double> xs, ys;
+    xs.clear();
+    for (double x = x1; x <= x2 && x <= PlaneBounds::GetInstance()->Right; x += 0.2)
+        xs.push_back(x);
+
+    ys.resize(xs.size());
+    CalculateParabolaYBatch(xs.data(), lh, point, ys.data(), xs.size());
+
     glBegin(GL_LINE_STRIP);
 
     double xo, yo;
-    for (double x = x1; x <= x2 && x <= PlaneBounds::GetInstance()->Right; x += 0.2) {
-        PointToScreen(Point(x, CalculateParabolaY(x, lh, point)), xo, yo);
+    for (size_t i = 0; i < xs.size(); i++) {
+        PointToScreen(Point(xs[i], ys[i]), xo, yo);
         glVertex2f(GLfloat(xo), GLfloat(yo));
     }
     glEnd();
@@ -0,0 +1,548 @@
+#include "BTreeBeachLine.h"
+
+#include "BreakpointBatch.h"
+#include "FortunesAlgorithm.h"
+#include "../types/Event.h"
+
+#include <type_traits>
+
+using namespace BL;
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BTreeBeachLine<T>::BTreeBeachLine()
+	: Nodes()
+	, Arcs()
+	, FreeNodes()
+	, FreeArcs()
+	, Root(NullIndex)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::Clear()
+{
+	Nodes.clear();
+	Arcs.clear();
+	FreeNodes.clear();
+	FreeArcs.clear();
+	Root = NullIndex;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::Start(VoronoiSite* site)
+{
+	Root = NewNode(true);
+	ArcRef arc = NewArc(site);
+	Nodes[Root].Count = 1;
+	SetSlot(Root, 0, arc);
+	return arc;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::FindArcAtX(Real x, Real lh) const
+{
+	if (NullIndex == Root)
+		return NullArc;
+
+	NodeIndex node = Root;
+	while (!Nodes[node].IsLeaf)
+	{
+		node = Nodes[node].Slots[SearchNode(Nodes[node], x, lh)];
+	}
+	return Nodes[node].Slots[SearchNode(Nodes[node], x, lh)];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::SplitArc(ArcRef arc, VoronoiSite* left, VoronoiSite* right, const Edge& edge,
+	ArcRef& leftArc, ArcRef& rightArc)
+{
+	leftArc = NewArc(left);
+	rightArc = NewArc(right);
+
+	const ArcRef arcs[2] = { leftArc, rightArc };
+	ReplaceArc(arc, arcs, &edge, 2);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::InsertArc(ArcRef arc, VoronoiSite* site, const Edge& leftEdge, const Edge& rightEdge,
+	ArcRef& leftArc, ArcRef& middleArc, ArcRef& rightArc)
+{
+	VoronoiSite* arcSite = Arcs[arc].Site;
+	leftArc = NewArc(arcSite);
+	middleArc = NewArc(site);
+	rightArc = NewArc(arcSite);
+
+	const ArcRef arcs[3] = { leftArc, middleArc, rightArc };
+	const Edge keys[2] = { leftEdge, rightEdge };
+	ReplaceArc(arc, arcs, keys, 3);
+}
+
+////////////////////////////////////////////////////////////////////
+// The arc always has breakpoints on both sides. Whichever of them is stored in
+// the arc's own leaf leaves with it, the other one takes the new edge.
+template<typename T>
+void BTreeBeachLine<T>::RemoveArc(ArcRef arc, const Edge& edge)
+{
+	const NodeIndex leaf = Arcs[arc].Leaf;
+	const int slot = Arcs[arc].Slot;
+
+	NodeIndex owner;
+	int key;
+	if (slot + 1 < Nodes[leaf].Count)
+	{
+		if (slot > 0)
+			SetKey(Nodes[leaf], slot - 1, edge);
+		else if (FindSeparator(leaf, true, owner, key))
+			SetKey(Nodes[owner], key, edge);
+
+		RemoveEntry(leaf, slot, slot);
+	}
+	else
+	{
+		if (FindSeparator(leaf, false, owner, key))
+			SetKey(Nodes[owner], key, edge);
+
+		RemoveEntry(leaf, slot, slot - 1);
+	}
+
+	FreeArcs.push_back(arc);
+
+	if (leaf != Root && Nodes[leaf].Count < MinWidth)
+		Rebalance(leaf);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::First() const
+{
+	if (NullIndex == Root)
+		return NullArc;
+
+	NodeIndex node = Root;
+	while (!Nodes[node].IsLeaf)
+		node = Nodes[node].Slots[0];
+	return Nodes[node].Slots[0];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::LeftArc(ArcRef arc) const
+{
+	const Node& leaf = Nodes[Arcs[arc].Leaf];
+	const int slot = Arcs[arc].Slot;
+	if (slot > 0)
+		return leaf.Slots[slot - 1];
+
+	if (NullIndex == leaf.Prev)
+		return NullArc;
+
+	const Node& prev = Nodes[leaf.Prev];
+	return prev.Slots[prev.Count - 1];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::RightArc(ArcRef arc) const
+{
+	const Node& leaf = Nodes[Arcs[arc].Leaf];
+	const int slot = Arcs[arc].Slot;
+	if (slot + 1 < leaf.Count)
+		return leaf.Slots[slot + 1];
+
+	if (NullIndex == leaf.Next)
+		return NullArc;
+
+	return Nodes[leaf.Next].Slots[0];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BTreeBeachLine<T>::Edge BTreeBeachLine<T>::LeftBreakpoint(ArcRef arc) const
+{
+	const NodeIndex leaf = Arcs[arc].Leaf;
+	const int slot = Arcs[arc].Slot;
+	if (slot > 0)
+		return Nodes[leaf].Keys[slot - 1];
+
+	NodeIndex owner;
+	int key;
+	return FindSeparator(leaf, true, owner, key) ? Nodes[owner].Keys[key] : Edge();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BTreeBeachLine<T>::Edge BTreeBeachLine<T>::RightBreakpoint(ArcRef arc) const
+{
+	const NodeIndex leaf = Arcs[arc].Leaf;
+	const int slot = Arcs[arc].Slot;
+	if (slot + 1 < Nodes[leaf].Count)
+		return Nodes[leaf].Keys[slot];
+
+	NodeIndex owner;
+	int key;
+	return FindSeparator(leaf, false, owner, key) ? Nodes[owner].Keys[key] : Edge();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef BTreeBeachLine<T>::NewArc(VoronoiSite* site)
+{
+	ArcRecord record = { site, nullptr, NullIndex, 0 };
+	if (!FreeArcs.empty())
+	{
+		ArcRef arc = FreeArcs.back();
+		FreeArcs.pop_back();
+		Arcs[arc] = record;
+		return arc;
+	}
+
+	Arcs.push_back(record);
+	return ArcRef(Arcs.size() - 1);
+}
+
+////////////////////////////////////////////////////////////////////
+// Any reference into Nodes is invalid after this call
+template<typename T>
+typename BTreeBeachLine<T>::NodeIndex BTreeBeachLine<T>::NewNode(bool isLeaf)
+{
+	NodeIndex index;
+	if (!FreeNodes.empty())
+	{
+		index = FreeNodes.back();
+		FreeNodes.pop_back();
+	}
+	else
+	{
+		index = NodeIndex(Nodes.size());
+		Nodes.emplace_back();
+	}
+
+	Node& node = Nodes[index];
+	node.Parent = NullIndex;
+	node.Prev = NullIndex;
+	node.Next = NullIndex;
+	node.Count = 0;
+	node.IsLeaf = isLeaf;
+	return index;
+}
+
+////////////////////////////////////////////////////////////////////
+// The same test the red-black tree makes at each breakpoint
+template<typename T>
+bool BTreeBeachLine<T>::GoesLeft(const Node& node, int key, Real x, Real lh) const
+{
+	const bool isVertical = node.LeftY[key] == node.RightY[key];
+	return (isVertical && x < node.Keys[key].Start()->x) ||
+		x < IntersectionX(BasicPoint<Real>(node.LeftX[key], node.LeftY[key]), BasicPoint<Real>(node.RightX[key], node.RightY[key]), lh);
+}
+
+////////////////////////////////////////////////////////////////////
+// Returns the slot of the first breakpoint right of x, the last slot if there is none.
+// With vector units every breakpoint of the node is placed in one batch and scanned,
+// otherwise a binary search keeps the number of scalar evaluations down. The batch
+// kernels only exist for double.
+template<typename T>
+int BTreeBeachLine<T>::SearchNode(const Node& node, Real x, Real lh) const
+{
+	const int keys = node.Count - 1;
+	if constexpr (std::is_same<Real, double>::value)
+	{
+		if (SimdLevel::Scalar != GetSimdLevel())
+		{
+			double breakpointX[Width + 1];
+			IntersectionXBatch(node.LeftX, node.LeftY, node.RightX, node.RightY, lh, breakpointX, keys);
+			for (int i = 0; i < keys; i++)
+			{
+				const bool isVertical = node.LeftY[i] == node.RightY[i];
+				if ((isVertical && x < node.Keys[i].Start()->x) || x < breakpointX[i])
+					return i;
+			}
+			return keys;
+		}
+	}
+
+	int low = 0;
+	int high = keys;
+	while (low < high)
+	{
+		const int middle = (low + high) / 2;
+		if (GoesLeft(node, middle, x, lh))
+			high = middle;
+		else
+			low = middle + 1;
+	}
+	return low;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::SetKey(Node& node, int key, const Edge& edge)
+{
+	node.Keys[key] = edge;
+	node.LeftX[key] = edge.Left()->point.x;
+	node.LeftY[key] = edge.Left()->point.y;
+	node.RightX[key] = edge.Right()->point.x;
+	node.RightY[key] = edge.Right()->point.y;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::CopyKey(Node& to, int toKey, const Node& from, int fromKey)
+{
+	to.Keys[toKey] = from.Keys[fromKey];
+	to.LeftX[toKey] = from.LeftX[fromKey];
+	to.LeftY[toKey] = from.LeftY[fromKey];
+	to.RightX[toKey] = from.RightX[fromKey];
+	to.RightY[toKey] = from.RightY[fromKey];
+}
+
+////////////////////////////////////////////////////////////////////
+// Places an arc or a child in a slot and points it back at its new position
+template<typename T>
+void BTreeBeachLine<T>::SetSlot(NodeIndex node, int slot, uint32_t value)
+{
+	Nodes[node].Slots[slot] = value;
+	if (Nodes[node].IsLeaf)
+	{
+		Arcs[value].Leaf = node;
+		Arcs[value].Slot = slot;
+	}
+	else
+		Nodes[value].Parent = node;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+int BTreeBeachLine<T>::ChildIndex(NodeIndex parent, NodeIndex child) const
+{
+	const Node& node = Nodes[parent];
+	for (int i = 0; i < node.Count; i++)
+	{
+		if (node.Slots[i] == child)
+			return i;
+	}
+	return -1;
+}
+
+////////////////////////////////////////////////////////////////////
+// Finds the breakpoint just outside a node's range, it belongs to the first
+// ancestor where the node's subtree is not the outermost child on that side.
+template<typename T>
+bool BTreeBeachLine<T>::FindSeparator(NodeIndex node, bool left, NodeIndex& owner, int& key) const
+{
+	NodeIndex child = node;
+	NodeIndex parent = Nodes[node].Parent;
+	while (NullIndex != parent)
+	{
+		const int index = ChildIndex(parent, child);
+		if (left && index > 0)
+		{
+			owner = parent;
+			key = index - 1;
+			return true;
+		}
+		if (!left && index + 1 < Nodes[parent].Count)
+		{
+			owner = parent;
+			key = index;
+			return true;
+		}
+
+		child = parent;
+		parent = Nodes[parent].Parent;
+	}
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////
+// Replaces the arc with count arcs separated by count - 1 breakpoints
+template<typename T>
+void BTreeBeachLine<T>::ReplaceArc(ArcRef arc, const ArcRef* arcs, const Edge* keys, int count)
+{
+	const NodeIndex leaf = Arcs[arc].Leaf;
+	const int slot = Arcs[arc].Slot;
+	const int extra = count - 1;
+	Node& node = Nodes[leaf];
+
+	for (int i = node.Count - 1; i > slot; i--)
+		SetSlot(leaf, i + extra, node.Slots[i]);
+	for (int i = node.Count - 2; i >= slot; i--)
+		CopyKey(node, i + extra, node, i);
+
+	for (int i = 0; i < count; i++)
+		SetSlot(leaf, slot + i, arcs[i]);
+	for (int i = 0; i < extra; i++)
+		SetKey(node, slot + i, keys[i]);
+
+	node.Count += extra;
+	FreeArcs.push_back(arc);
+
+	if (node.Count > Width)
+		Split(leaf);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BTreeBeachLine<T>::RemoveEntry(NodeIndex node, int slot, int key)
+{
+	Node& entry = Nodes[node];
+	for (int i = slot; i + 1 < entry.Count; i++)
+		SetSlot(node, i, entry.Slots[i + 1]);
+	for (int i = key; i + 2 < entry.Count; i++)
+		CopyKey(entry, i, entry, i + 1);
+
+	entry.Count--;
+}
+
+////////////////////////////////////////////////////////////////////
+// Moves the upper half of an overfull node into a new sibling, the breakpoint
+// between the halves moves up into the parent.
+template<typename T>
+void BTreeBeachLine<T>::Split(NodeIndex node)
+{
+	const NodeIndex sibling = NewNode(Nodes[node].IsLeaf);
+	Node& left = Nodes[node];
+	Node& right = Nodes[sibling];
+
+	const int half = left.Count / 2;
+	right.Count = left.Count - half;
+	for (int i = 0; i < right.Count; i++)
+		SetSlot(sibling, i, left.Slots[half + i]);
+	for (int i = 0; i + 1 < right.Count; i++)
+		CopyKey(right, i, left, half + i);
+
+	const Edge separator = left.Keys[half - 1];
+	left.Count = half;
+
+	if (left.IsLeaf)
+	{
+		right.Prev = node;
+		right.Next = left.Next;
+		if (NullIndex != left.Next)
+			Nodes[left.Next].Prev = sibling;
+		left.Next = sibling;
+	}
+
+	NodeIndex parent = left.Parent;
+	if (NullIndex == parent)
+	{
+		parent = NewNode(false);
+		Root = parent;
+		Nodes[parent].Count = 1;
+		SetSlot(parent, 0, node);
+	}
+
+	Node& above = Nodes[parent];
+	const int index = ChildIndex(parent, node);
+	for (int i = above.Count - 1; i > index; i--)
+		SetSlot(parent, i + 1, above.Slots[i]);
+	for (int i = above.Count - 2; i >= index; i--)
+		CopyKey(above, i + 1, above, i);
+
+	SetSlot(parent, index + 1, sibling);
+	SetKey(above, index, separator);
+	above.Count++;
+
+	if (above.Count > Width)
+		Split(parent);
+}
+
+////////////////////////////////////////////////////////////////////
+// Refills an underfull node from a sibling with entries to spare, rotating the
+// separating breakpoint through the parent, otherwise merges it with a sibling.
+template<typename T>
+void BTreeBeachLine<T>::Rebalance(NodeIndex node)
+{
+	const NodeIndex parent = Nodes[node].Parent;
+	const int index = ChildIndex(parent, node);
+	Node& above = Nodes[parent];
+	Node& entry = Nodes[node];
+
+	if (index > 0 && Nodes[above.Slots[index - 1]].Count > MinWidth)
+	{
+		const NodeIndex sibling = above.Slots[index - 1];
+		Node& left = Nodes[sibling];
+
+		for (int i = entry.Count - 1; i >= 0; i--)
+			SetSlot(node, i + 1, entry.Slots[i]);
+		for (int i = entry.Count - 2; i >= 0; i--)
+			CopyKey(entry, i + 1, entry, i);
+
+		SetSlot(node, 0, left.Slots[left.Count - 1]);
+		CopyKey(entry, 0, above, index - 1);
+		CopyKey(above, index - 1, left, left.Count - 2);
+		left.Count--;
+		entry.Count++;
+		return;
+	}
+
+	if (index + 1 < above.Count && Nodes[above.Slots[index + 1]].Count > MinWidth)
+	{
+		const NodeIndex sibling = above.Slots[index + 1];
+		Node& right = Nodes[sibling];
+
+		SetSlot(node, entry.Count, right.Slots[0]);
+		CopyKey(entry, entry.Count - 1, above, index);
+		CopyKey(above, index, right, 0);
+		entry.Count++;
+
+		RemoveEntry(sibling, 0, 0);
+		return;
+	}
+
+	if (index > 0)
+		Merge(above.Slots[index - 1], node);
+	else
+		Merge(node, above.Slots[index + 1]);
+}
+
+////////////////////////////////////////////////////////////////////
+// Appends the right node and the breakpoint separating them to the left node
+template<typename T>
+void BTreeBeachLine<T>::Merge(NodeIndex left, NodeIndex right)
+{
+	const NodeIndex parent = Nodes[left].Parent;
+	const int index = ChildIndex(parent, right);
+	Node& into = Nodes[left];
+	Node& from = Nodes[right];
+
+	CopyKey(into, into.Count - 1, Nodes[parent], index - 1);
+	for (int i = 0; i < from.Count; i++)
+		SetSlot(left, into.Count + i, from.Slots[i]);
+	for (int i = 0; i + 1 < from.Count; i++)
+		CopyKey(into, into.Count + i, from, i);
+	into.Count += from.Count;
+
+	if (into.IsLeaf)
+	{
+		into.Next = from.Next;
+		if (NullIndex != from.Next)
+			Nodes[from.Next].Prev = left;
+	}
+
+	RemoveEntry(parent, index, index - 1);
+	FreeNodes.push_back(right);
+
+	if (parent == Root)
+	{
+		// The root keeps at least two children, or hands over to its only one
+		if (1 == Nodes[parent].Count)
+		{
+			Root = left;
+			into.Parent = NullIndex;
+			FreeNodes.push_back(parent);
+		}
+	}
+	else if (Nodes[parent].Count < MinWidth)
+		Rebalance(parent);
+}
+
+template class BL::BTreeBeachLine<float>;
+template class BL::BTreeBeachLine<double>;
+template class BL::BTreeBeachLine<int64_t>;
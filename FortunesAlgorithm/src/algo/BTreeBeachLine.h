@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../types/BeachLine.h"
+
+#include <vector>
+
+namespace BL
+{
+	// The beach line as a B+ tree with wide nodes. The arcs sit in order in the
+	// leaves and each breakpoint is stored once, either between two arcs of a leaf
+	// or between two subtrees of an inner node. The sites either side of every
+	// breakpoint are copied next to it one coordinate per array, so a search reads
+	// a node's breakpoints from a few cache lines instead of chasing a pointer per
+	// comparison, and there are no rotations, only the odd split or merge.
+	template<typename T>
+	class BTreeBeachLine : public BasicBeachLine<T>
+	{
+	public:
+		typedef typename BasicBeachLine<T>::Real Real;
+		typedef typename BasicBeachLine<T>::VoronoiSite VoronoiSite;
+		typedef typename BasicBeachLine<T>::EventPoint EventPoint;
+		typedef typename BasicBeachLine<T>::Edge Edge;
+
+		// Arcs per leaf and children per inner node, with one breakpoint fewer
+		static const int Width = 16;
+		static const int MinWidth = Width / 2;
+
+		BTreeBeachLine();
+
+		bool IsEmpty() const override { return NullIndex == Root; }
+		void Clear() override;
+
+		ArcRef Start(VoronoiSite* site) override;
+		ArcRef FindArcAtX(Real x, Real lh) const override;
+
+		void SplitArc(ArcRef arc, VoronoiSite* left, VoronoiSite* right, const Edge& edge,
+			ArcRef& leftArc, ArcRef& rightArc) override;
+		void InsertArc(ArcRef arc, VoronoiSite* site, const Edge& leftEdge, const Edge& rightEdge,
+			ArcRef& leftArc, ArcRef& middleArc, ArcRef& rightArc) override;
+		void RemoveArc(ArcRef arc, const Edge& edge) override;
+
+		ArcRef First() const override;
+		ArcRef LeftArc(ArcRef arc) const override;
+		ArcRef RightArc(ArcRef arc) const override;
+		Edge LeftBreakpoint(ArcRef arc) const override;
+		Edge RightBreakpoint(ArcRef arc) const override;
+
+		VoronoiSite* Site(ArcRef arc) const override { return Arcs[arc].Site; }
+		EventPoint* CircleEvent(ArcRef arc) const override { return Arcs[arc].CircleEvent; }
+		void SetCircleEvent(ArcRef arc, EventPoint* event) override { Arcs[arc].CircleEvent = event; }
+
+	private:
+		typedef uint32_t NodeIndex;
+		static const NodeIndex NullIndex = 0xFFFFFFFF;
+
+		struct Node
+		{
+			NodeIndex Parent;
+			// Neighbouring leaves, unused by inner nodes
+			NodeIndex Prev;
+			NodeIndex Next;
+			int Count;
+			bool IsLeaf;
+
+			// Arcs in a leaf, child nodes otherwise. Key i separates slots i and i + 1.
+			// There is room for two extra entries as an insert can overfill a node
+			// before it is split.
+			uint32_t Slots[Width + 2];
+			Edge Keys[Width + 1];
+			Real LeftX[Width + 1];
+			Real LeftY[Width + 1];
+			Real RightX[Width + 1];
+			Real RightY[Width + 1];
+		};
+
+		struct ArcRecord
+		{
+			VoronoiSite* Site;
+			EventPoint* CircleEvent;
+			NodeIndex Leaf;
+			int Slot;
+		};
+
+		ArcRef NewArc(VoronoiSite* site);
+		NodeIndex NewNode(bool isLeaf);
+
+		bool GoesLeft(const Node& node, int key, Real x, Real lh) const;
+		int SearchNode(const Node& node, Real x, Real lh) const;
+
+		void SetKey(Node& node, int key, const Edge& edge);
+		void CopyKey(Node& to, int toKey, const Node& from, int fromKey);
+		void SetSlot(NodeIndex node, int slot, uint32_t value);
+		int ChildIndex(NodeIndex parent, NodeIndex child) const;
+		bool FindSeparator(NodeIndex node, bool left, NodeIndex& owner, int& key) const;
+
+		void ReplaceArc(ArcRef arc, const ArcRef* arcs, const Edge* keys, int count);
+		void RemoveEntry(NodeIndex node, int slot, int key);
+		void Split(NodeIndex node);
+		void Rebalance(NodeIndex node);
+		void Merge(NodeIndex left, NodeIndex right);
+
+		std::vector<Node> Nodes;
+		std::vector<ArcRecord> Arcs;
+		std::vector<NodeIndex> FreeNodes;
+		std::vector<ArcRef> FreeArcs;
+		NodeIndex Root;
+	};
+}
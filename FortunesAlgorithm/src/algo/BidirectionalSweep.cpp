@@ -0,0 +1,561 @@
+#include "BidirectionalSweep.h"
+
+#include "DualCells.h"
+#include "FortunesAlgorithm.h"
+#include "Predicates.h"
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	// A Delaunay half-edge one of the halves left without a twin, and the Voronoi edge
+	// across it, which has one end
+	struct OpenEdge
+	{
+		DCEL::HalfEdge* triangle;
+		DCEL::HalfEdge* voronoi;
+	};
+
+	// The directed edge between two sites
+	uint64_t EdgeKey(int from, int to)
+	{
+		return (uint64_t(uint32_t(from)) << 32) | uint64_t(uint32_t(to));
+	}
+
+	double SecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Turns the lower half's records back the right way up and gives its cells to the
+	// diagram's sites
+	void TurnBack(VoronoiDiagram& lower, VoronoiDiagram& diagram)
+	{
+		for (DCEL::Vertex* vertex : lower.Vertices)
+			vertex->point = Point(-vertex->point.x, -vertex->point.y);
+		for (DCEL::Vertex* vertex : lower.TriangulationVertices)
+			vertex->point = Point(-vertex->point.x, -vertex->point.y);
+
+		for (DCEL::Face* face : lower.Faces)
+		{
+			VoronoiSite* site = diagram.Sites[face->site->index - 1];
+			site->triVertex = face->site->triVertex;
+			site->face = face;
+			face->site = site;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+BidirectionalSweep::BidirectionalSweep(std::vector<Point>& points)
+	: Points(points)
+	, Diagram(Points)
+	, MeetingHeight(0.0)
+	, Merged(false)
+	, Timings({ 0.0, 0.0, 0.0, 0.0 })
+{
+}
+
+////////////////////////////////////////////////////////////////////
+void BidirectionalSweep::Run()
+{
+	Diagram.ClearDCEL();
+	Merged = false;
+	Timings = { 0.0, 0.0, 0.0, 0.0 };
+
+	if (Points.size() < 4 || !FindMeetingHeight())
+	{
+		SweepWhole();
+		return;
+	}
+
+	// The upper half builds straight into the diagram. The lower half sweeps the sites
+	// turned half a turn, which keeps every face and triangle counterclockwise, and keeps
+	// the original site numbering so its records can join the diagram's as they are.
+	FortunesAlgorithm* down = nullptr;
+	FortunesAlgorithm* up = nullptr;
+	VoronoiDiagram* lowerDiagram = nullptr;
+	std::thread downSweep([&]()
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		down = new FortunesAlgorithm(Diagram);
+		down->SetVerbose(false);
+		down->AdvanceTo(MeetingHeight);
+		down->CleanZeroLengthEdges();
+		Timings.Upper = SecondsSince(start);
+	});
+	std::thread upSweep([&]()
+	{
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::vector<Point> turnedPoints;
+		turnedPoints.reserve(Points.size());
+		for (const Point& p : Points)
+		{
+			turnedPoints.push_back(Point(-p.x, -p.y));
+		}
+		lowerDiagram = new VoronoiDiagram(turnedPoints);
+		up = new FortunesAlgorithm(*lowerDiagram);
+		up->SetVerbose(false);
+		up->AdvanceTo(-MeetingHeight);
+		up->CleanZeroLengthEdges();
+		TurnBack(*lowerDiagram, Diagram);
+		Timings.Lower = SecondsSince(start);
+	});
+	downSweep.join();
+	upSweep.join();
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	Merged = Stitch(*down, *up, *lowerDiagram);
+	Timings.Stitch = SecondsSince(start) - Timings.Seam;
+
+	delete down;
+	delete up;
+	for (VoronoiSite* site : lowerDiagram->Sites)
+		delete site;
+	delete lowerDiagram;
+
+	if (!Merged)
+	{
+		Diagram.ClearDCEL();
+		SweepWhole();
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Each half leaves a Delaunay half-edge without a twin on every edge its beach line still
+// crosses, and the Voronoi edge across it open at the far end. The triangles between the
+// two beach lines are those of the seam sweep reached from these edges without crossing
+// one, and with h edges left on the hull every one of the n sites is a corner of 2n - 2 - h
+// triangles. The vertices of the seam triangles close the open edges and each other's, and
+// the edges on the hull run out to the box.
+bool BidirectionalSweep::Stitch(FortunesAlgorithm& upper, FortunesAlgorithm& lower, VoronoiDiagram& lowerDiagram)
+{
+	const size_t n = Points.size();
+
+	// The lower half's records join the diagram, numbered on from the upper half's
+	const int upperVertices = int(Diagram.Vertices.size());
+	const int upperTriangles = int(Diagram.TriangulationFaces.size());
+	for (DCEL::Vertex* vertex : lowerDiagram.Vertices)
+		vertex->index += upperVertices;
+	for (DCEL::Face* triangle : lowerDiagram.TriangulationFaces)
+		triangle->index += upperTriangles;
+	Diagram.Faces.insert(Diagram.Faces.end(), lowerDiagram.Faces.begin(), lowerDiagram.Faces.end());
+	Diagram.Vertices.insert(Diagram.Vertices.end(), lowerDiagram.Vertices.begin(), lowerDiagram.Vertices.end());
+	Diagram.HalfEdges.insert(Diagram.HalfEdges.end(), lowerDiagram.HalfEdges.begin(), lowerDiagram.HalfEdges.end());
+	Diagram.TriangulationFaces.insert(Diagram.TriangulationFaces.end(),
+		lowerDiagram.TriangulationFaces.begin(), lowerDiagram.TriangulationFaces.end());
+	Diagram.TriangulationVertices.insert(Diagram.TriangulationVertices.end(),
+		lowerDiagram.TriangulationVertices.begin(), lowerDiagram.TriangulationVertices.end());
+	Diagram.TriangulationHalfEdges.insert(Diagram.TriangulationHalfEdges.end(),
+		lowerDiagram.TriangulationHalfEdges.begin(), lowerDiagram.TriangulationHalfEdges.end());
+	lowerDiagram.Faces.clear();
+	lowerDiagram.Vertices.clear();
+	lowerDiagram.HalfEdges.clear();
+	lowerDiagram.TriangulationFaces.clear();
+	lowerDiagram.TriangulationVertices.clear();
+	lowerDiagram.TriangulationHalfEdges.clear();
+
+	// The open edges of both halves and the sites on either beach line
+	std::unordered_map<uint64_t, OpenEdge> open;
+	std::vector<bool> onBeachLine(n + 1, false);
+	std::vector<Point> seamPoints;
+	std::vector<int> seamIndices(1, 0);
+	auto collect = [&](FortunesAlgorithm& algorithm)
+	{
+		auto add = [&](const BL::Edge& edge)
+		{
+			DCEL::HalfEdge* triangle = edge.TriHalfEdge();
+			if (nullptr != triangle && nullptr == triangle->twin && nullptr != edge.Source->HalfEdge)
+				open.insert({ EdgeKey(triangle->origin->index, triangle->dest->index), { triangle, edge.Source->HalfEdge } });
+		};
+
+		const BL::BeachLine& beachLine = algorithm.GetBeachLine();
+		for (BL::ArcRef arc : algorithm.InOrder())
+		{
+			const int site = beachLine.Site(arc)->index;
+			if (!onBeachLine[site])
+			{
+				onBeachLine[site] = true;
+				seamPoints.push_back(Points[site - 1]);
+				seamIndices.push_back(site);
+			}
+			const BL::Edge breakpoint = beachLine.RightBreakpoint(arc);
+			if (!breakpoint.IsNull())
+				add(breakpoint);
+		}
+		// A first row bisector a circle event closed is open upwards
+		for (const BL::Edge& edge : algorithm.GetFirstRowEdges())
+			add(edge);
+	};
+	collect(upper);
+	collect(lower);
+	if (seamPoints.size() < 3)
+		return false;
+
+	const std::chrono::steady_clock::time_point seamStart = std::chrono::steady_clock::now();
+	VoronoiDiagram seamDiagram(seamPoints);
+	FortunesAlgorithm seam(seamDiagram);
+	seam.SetVerbose(false);
+	seam.Run();
+	Timings.Seam = SecondsSince(seamStart);
+
+	auto global = [&](const DCEL::Vertex* vertex) { return seamIndices[vertex->index]; };
+	std::unordered_map<uint64_t, DCEL::HalfEdge*> delaunay;
+	delaunay.reserve(seamDiagram.TriangulationHalfEdges.size());
+	for (DCEL::HalfEdge* edge : seamDiagram.TriangulationHalfEdges)
+		delaunay.insert({ EdgeKey(global(edge->origin), global(edge->dest)), edge });
+
+	// Seam triangles are numbered in the order they are reached
+	std::vector<int> seamOf(seamDiagram.TriangulationFaces.size() + 1, -1);
+	std::vector<DCEL::Face*> seamTriangles;
+	auto reach = [&](DCEL::Face* triangle)
+	{
+		if (triangle->Unbounded || seamOf[triangle->index] >= 0)
+			return;
+		seamOf[triangle->index] = int(seamTriangles.size());
+		seamTriangles.push_back(triangle);
+	};
+	auto isOpen = [&](int from, int to) { return open.end() != open.find(EdgeKey(from, to)); };
+
+	size_t hull = 0;
+	for (const std::pair<const uint64_t, OpenEdge>& entry : open)
+	{
+		const int from = entry.second.triangle->origin->index, to = entry.second.triangle->dest->index;
+		// All of one half's triangles are above the line and all of the other's below
+		if (isOpen(to, from))
+			return false;
+
+		auto found = delaunay.find(EdgeKey(to, from));
+		if (delaunay.end() == found || found->second->incidentFace->Unbounded)
+			hull++;
+		else
+			reach(found->second->incidentFace);
+	}
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		const DCEL::HalfEdge* edge = seamTriangles[i]->outerComponent;
+		for (int side = 0; side < 3; side++, edge = edge->next)
+		{
+			const int from = global(edge->origin), to = global(edge->dest);
+			if (isOpen(from, to))
+				return false;
+			if (isOpen(to, from))
+				continue;
+			if (edge->twin->incidentFace->Unbounded)
+				hull++;
+			else
+				reach(edge->twin->incidentFace);
+		}
+	}
+	if (hull < 3 || Diagram.TriangulationFaces.size() + seamTriangles.size() + 2 + hull != 2 * n)
+		return false;
+
+	// The seam triangles join the diagram's, matched to the halves' across the open edges
+	auto slot = [](const DCEL::HalfEdge* edge)
+	{
+		const DCEL::HalfEdge* first = edge->incidentFace->outerComponent;
+		return (edge == first) ? 0 : (edge == first->next) ? 1 : 2;
+	};
+	std::vector<DCEL::HalfEdge*> sides(3 * seamTriangles.size(), nullptr);
+	int triangleIndex = int(Diagram.TriangulationFaces.size());
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		DCEL::Face* triangle = Diagram.NewFace({ nullptr, nullptr, nullptr, false, ++triangleIndex });
+		Diagram.TriangulationFaces.push_back(triangle);
+		const DCEL::HalfEdge* edge = seamTriangles[i]->outerComponent;
+		for (int side = 0; side < 3; side++, edge = edge->next)
+		{
+			DCEL::Vertex* from = Diagram.Sites[global(edge->origin) - 1]->triVertex;
+			DCEL::Vertex* to = Diagram.Sites[global(edge->dest) - 1]->triVertex;
+			sides[3 * i + side] = Diagram.NewHalfEdge({ from, to, nullptr, triangle, nullptr, nullptr });
+			Diagram.TriangulationHalfEdges.push_back(sides[3 * i + side]);
+			if (nullptr == from->incidentEdge)
+				from->incidentEdge = sides[3 * i + side];
+		}
+		for (int side = 0; side < 3; side++)
+		{
+			sides[3 * i + side]->next = sides[3 * i + (side + 1) % 3];
+			sides[3 * i + side]->prev = sides[3 * i + (side + 2) % 3];
+		}
+		triangle->outerComponent = sides[3 * i];
+	}
+
+	std::vector<DCEL::HalfEdge*> hullEdges;
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		const DCEL::HalfEdge* edge = seamTriangles[i]->outerComponent;
+		for (int side = 0; side < 3; side++, edge = edge->next)
+		{
+			DCEL::HalfEdge* triangleEdge = sides[3 * i + side];
+			auto reverse = open.find(EdgeKey(global(edge->dest), global(edge->origin)));
+			if (open.end() != reverse)
+			{
+				triangleEdge->twin = reverse->second.triangle;
+				triangleEdge->twin->twin = triangleEdge;
+			}
+			else if (edge->twin->incidentFace->Unbounded)
+			{
+				hullEdges.push_back(triangleEdge);
+			}
+			else
+			{
+				triangleEdge->twin = sides[3 * size_t(seamOf[edge->twin->incidentFace->index]) + slot(edge->twin)];
+			}
+		}
+	}
+	for (const std::pair<const uint64_t, OpenEdge>& entry : open)
+	{
+		if (nullptr == entry.second.triangle->twin)
+			hullEdges.push_back(entry.second.triangle);
+	}
+
+	// Edges with no twin are on the hull, their twins run clockwise around the outside
+	DCEL::Face* outside = Diagram.NewFace({ nullptr, nullptr, nullptr, true, ++triangleIndex });
+	std::unordered_map<int, DCEL::HalfEdge*> hullFrom;
+	for (DCEL::HalfEdge* inner : hullEdges)
+	{
+		inner->twin = Diagram.NewHalfEdge({ inner->dest, inner->origin, inner, outside, nullptr, nullptr });
+		Diagram.TriangulationHalfEdges.push_back(inner->twin);
+		if (!hullFrom.insert({ inner->dest->index, inner->twin }).second)
+			return false;
+	}
+	for (DCEL::HalfEdge* inner : hullEdges)
+	{
+		auto next = hullFrom.find(inner->origin->index);
+		if (hullFrom.end() == next)
+			return false;
+		inner->twin->next = next->second;
+		next->second->prev = inner->twin;
+	}
+	outside->innerComponent = hullEdges.front()->twin;
+	Diagram.TriangulationFaces.push_back(outside);
+
+	std::vector<DCEL::HalfEdge*> hullOrder;
+	DCEL::HalfEdge* outer = outside->innerComponent;
+	do
+	{
+		hullOrder.push_back(outer->twin);
+		outer = outer->prev;
+	} while (outer != outside->innerComponent && hullOrder.size() <= hullEdges.size());
+	if (hullOrder.size() != hullEdges.size())
+		return false;
+
+	// Seam triangles on one circle share a vertex
+	std::vector<size_t> parent(seamTriangles.size());
+	std::iota(parent.begin(), parent.end(), 0);
+	auto root = [&parent](size_t i)
+	{
+		while (parent[i] != i)
+		{
+			parent[i] = parent[parent[i]];
+			i = parent[i];
+		}
+		return i;
+	};
+	auto inside = [&](const DCEL::HalfEdge* edge)
+	{
+		return !edge->twin->incidentFace->Unbounded && !isOpen(global(edge->dest), global(edge->origin));
+	};
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		const DCEL::HalfEdge* edge = seamTriangles[i]->outerComponent;
+		for (int side = 0; side < 3; side++, edge = edge->next)
+		{
+			if (!inside(edge))
+				continue;
+			const size_t j = size_t(seamOf[edge->twin->incidentFace->index]);
+			if (root(i) != root(j) && 0.0 == SitePredicates<double>::InCircle(edge->origin->point, edge->dest->point,
+				edge->prev->origin->point, edge->twin->prev->origin->point))
+				parent[root(i)] = root(j);
+		}
+	}
+
+	double minX = std::min({ Diagram.MinX, upper.MinX, -lower.MaxX });
+	double minY = std::min({ Diagram.MinY, upper.MinY, -lower.MaxY });
+	double maxX = std::max({ Diagram.MaxX, upper.MaxX, -lower.MinX });
+	double maxY = std::max({ Diagram.MaxY, upper.MaxY, -lower.MinY });
+	std::vector<DCEL::Vertex*> vertexOf(seamTriangles.size(), nullptr);
+	int vertexIndex = int(Diagram.Vertices.size());
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		if (root(i) != i)
+			continue;
+		const DCEL::HalfEdge* first = seamTriangles[i]->outerComponent;
+		const Point centre = Circumcentre(first->origin->point, first->dest->point, first->prev->origin->point);
+		if (!std::isfinite(centre.x) || !std::isfinite(centre.y))
+			return false;
+		vertexOf[i] = Diagram.NewVertex({ ++vertexIndex, centre, nullptr });
+		Diagram.Vertices.push_back(vertexOf[i]);
+		minX = std::min(minX, centre.x);
+		minY = std::min(minY, centre.y);
+		maxX = std::max(maxX, centre.x);
+		maxY = std::max(maxY, centre.y);
+	}
+
+	// The Voronoi edge out of a seam vertex across one edge of the polygon its triangles
+	// make, left of which is the cell of the edge's end. Across a half it is the open edge
+	// closed here, across the seam it is made from the side reached first.
+	auto faceOf = [this](int site) { return Diagram.Sites[site - 1]->face; };
+	std::unordered_map<const DCEL::HalfEdge*, DCEL::HalfEdge*> made;
+	std::unordered_map<const DCEL::HalfEdge*, DCEL::HalfEdge*> rayOf;
+	auto edgeOut = [&](const DCEL::HalfEdge* edge, DCEL::Vertex* centre) -> DCEL::HalfEdge*
+	{
+		const int from = global(edge->origin), to = global(edge->dest);
+		auto reverse = open.find(EdgeKey(to, from));
+		if (open.end() != reverse)
+		{
+			DCEL::HalfEdge* voronoi = reverse->second.voronoi;
+			for (DCEL::HalfEdge* halfEdge : { voronoi, voronoi->twin })
+			{
+				if (nullptr == halfEdge->origin)
+					halfEdge->origin = centre;
+				else if (nullptr == halfEdge->dest)
+					halfEdge->dest = centre;
+			}
+			DCEL::HalfEdge* out = (voronoi->origin == centre) ? voronoi : voronoi->twin;
+			return (out->origin == centre && out->incidentFace == faceOf(to)) ? out : nullptr;
+		}
+
+		auto found = made.find(edge);
+		if (made.end() != found)
+			return found->second;
+
+		const bool ray = edge->twin->incidentFace->Unbounded;
+		DCEL::Vertex* far = ray ? nullptr : vertexOf[root(size_t(seamOf[edge->twin->incidentFace->index]))];
+		DCEL::HalfEdge* out = Diagram.NewHalfEdge({ centre, far, nullptr, faceOf(to), nullptr, nullptr });
+		out->twin = Diagram.NewHalfEdge({ far, centre, out, faceOf(from), nullptr, nullptr });
+		Diagram.HalfEdges.push_back(out);
+		Diagram.HalfEdges.push_back(out->twin);
+		if (nullptr == out->incidentFace->outerComponent)
+			out->incidentFace->outerComponent = out;
+		if (nullptr == out->twin->incidentFace->outerComponent)
+			out->twin->incidentFace->outerComponent = out->twin;
+
+		if (ray)
+			rayOf[sides[3 * size_t(seamOf[edge->incidentFace->index]) + slot(edge)]] = out->twin;
+		else
+			made[edge->twin] = out->twin;
+		return out;
+	};
+
+	// Round each seam vertex counterclockwise, every edge in is followed by the one out
+	// before it
+	std::vector<bool> linked(seamTriangles.size(), false);
+	std::vector<DCEL::HalfEdge*> around;
+	for (size_t i = 0; i < seamTriangles.size(); i++)
+	{
+		const size_t r = root(i);
+		if (linked[r])
+			continue;
+
+		const DCEL::HalfEdge* start = seamTriangles[i]->outerComponent;
+		int side = 0;
+		while (side < 3 && inside(start) && root(size_t(seamOf[start->twin->incidentFace->index])) == r)
+		{
+			start = start->next;
+			side++;
+		}
+		// A triangle inside a polygon of co-circular sites leaves it to another
+		if (3 == side)
+			continue;
+		linked[r] = true;
+
+		around.clear();
+		const DCEL::HalfEdge* edge = start;
+		do
+		{
+			DCEL::HalfEdge* out = edgeOut(edge, vertexOf[r]);
+			if (nullptr == out || around.size() > FanLimit)
+				return false;
+			around.push_back(out);
+
+			edge = edge->next;
+			while (inside(edge) && root(size_t(seamOf[edge->twin->incidentFace->index])) == r)
+				edge = edge->twin->next;
+		} while (edge != start);
+
+		for (size_t k = 0; k < around.size(); k++)
+		{
+			DCEL::HalfEdge* in = around[(k + 1) % around.size()]->twin;
+			in->next = around[k];
+			around[k]->prev = in;
+		}
+		vertexOf[r]->incidentEdge = around.front();
+	}
+
+	// The open edges on the hull run out from the vertex of their half
+	std::vector<DCEL::HalfEdge*> rays;
+	rays.reserve(hullOrder.size());
+	for (DCEL::HalfEdge* inner : hullOrder)
+	{
+		auto found = rayOf.find(inner);
+		if (rayOf.end() != found)
+		{
+			rays.push_back(found->second);
+			continue;
+		}
+
+		auto entry = open.find(EdgeKey(inner->origin->index, inner->dest->index));
+		if (open.end() == entry)
+			return false;
+		DCEL::HalfEdge* voronoi = entry->second.voronoi;
+		rays.push_back((voronoi->incidentFace == faceOf(inner->origin->index)) ? voronoi : voronoi->twin);
+	}
+
+	DCEL::Face* unbounded = Diagram.NewFace({ nullptr, nullptr, nullptr, true, 0 });
+	Diagram.Faces.push_back(unbounded);
+	DualCells cells(Diagram);
+	if (!cells.CloseRays(rays, minX, minY, maxX, maxY, unbounded))
+		return false;
+
+	Diagram.InvalidateMetrics();
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+void BidirectionalSweep::SweepWhole()
+{
+	FortunesAlgorithm algorithm(Diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+}
+
+////////////////////////////////////////////////////////////////////
+// Picks the gap between two site heights closest to the median so
+// that no site lies on the meeting line and neither sweep owns it.
+bool BidirectionalSweep::FindMeetingHeight()
+{
+	std::vector<double> heights;
+	for (const Point& p : Points)
+	{
+		heights.push_back(p.y);
+	}
+	std::sort(heights.begin(), heights.end());
+
+	size_t middle = heights.size() / 2;
+	for (size_t offset = 0; offset < heights.size(); offset++)
+	{
+		size_t above = middle + offset;
+		if (above < heights.size() && heights[above - 1] < heights[above])
+		{
+			MeetingHeight = (heights[above - 1] + heights[above]) / 2.0;
+			return true;
+		}
+
+		if (offset < middle - 1 && heights[middle - offset - 2] < heights[middle - offset - 1])
+		{
+			MeetingHeight = (heights[middle - offset - 2] + heights[middle - offset - 1]) / 2.0;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../types/Point.h"
+#include "../types/VoronoiDiagram.h"
+
+#include <vector>
+
+template<typename T> class BasicFortunesAlgorithm;
+typedef BasicFortunesAlgorithm<double> FortunesAlgorithm;
+
+// Seconds the last Run spent in each part. The halves run side by side, so the diagram
+// takes the slower half, then the seam sweep and the stitch.
+struct BidirectionalTimings
+{
+	double Upper;
+	double Lower;
+	double Seam;
+	double Stitch;
+};
+
+// Experimental engine that runs two sweeps at the same time: the usual top-down
+// sweep and one over the sites turned half a turn, which moves upward from the
+// bottom. Both stop at the median height of the sites. Every circle event either
+// sweep processed is a final Voronoi vertex, the only vertices missing are those
+// whose circles cross the meeting line. Those are only defined by the sites still on
+// one of the two beach lines, so they are recovered by a third, sequential sweep over
+// the beach line sites alone.
+//
+// Both halves keep what they built. The edges their beach lines leave open are closed
+// at the seam vertices or run out to the box, so only the records along the meeting
+// line are made after the halves. When the seam does not fit between them, as sites
+// on one circle split differently can leave it, the diagram is swept whole instead.
+class BidirectionalSweep
+{
+public:
+	BidirectionalSweep(std::vector<Point>& points);
+
+	void Run();
+
+	double GetMeetingHeight() { return MeetingHeight; }
+	VoronoiDiagram& GetDiagram() { return Diagram; }
+	// Whether the last Run stitched the halves rather than sweeping the diagram whole
+	bool IsMerged() { return Merged; }
+	const BidirectionalTimings& GetTimings() { return Timings; }
+
+private:
+	bool FindMeetingHeight();
+	bool Stitch(FortunesAlgorithm& upper, FortunesAlgorithm& lower, VoronoiDiagram& lowerDiagram);
+	void SweepWhole();
+
+	std::vector<Point> Points;
+	VoronoiDiagram Diagram;
+	double MeetingHeight;
+	bool Merged;
+	BidirectionalTimings Timings;
+};
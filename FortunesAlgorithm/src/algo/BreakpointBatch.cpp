@@ -0,0 +1,337 @@
+#include "BreakpointBatch.h"
+
+#include "FortunesAlgorithm.h"
+
+#include "../utils/NoContraction.h"
+
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BATCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVC compiles any intrinsic anywhere, GCC and Clang need the kernels marked
+#if defined(BATCH_X86) && !defined(_MSC_VER)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+namespace
+{
+	typedef void (*IntersectionKernel)(const double*, const double*, const double*, const double*, double, double*, size_t);
+	typedef void (*ParabolaKernel)(const double*, double, double, double, double*, size_t);
+
+	////////////////////////////////////////////////////////////////////
+	void IntersectionXScalar(const double* leftX, const double* leftY, const double* rightX, const double* rightY,
+		double lh, double* out, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = IntersectionX(Point(leftX[i], leftY[i]), Point(rightX[i], rightY[i]), lh);
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////
+	void ParabolaYScalar(const double* x, double lh, double px, double py, double* out, size_t count)
+	{
+		const Point point(px, py);
+		for (size_t i = 0; i < count; i++)
+		{
+			out[i] = CalculateParabolaY(x[i], lh, point);
+		}
+	}
+
+#ifdef BATCH_X86
+	////////////////////////////////////////////////////////////////////
+	bool CpuId(unsigned int leaf, unsigned int regs[4])
+	{
+#if defined(_MSC_VER)
+		int values[4];
+		__cpuid(values, 0);
+		if (unsigned(values[0]) < leaf)
+			return false;
+		__cpuidex(values, int(leaf), 0);
+		for (int i = 0; i < 4; i++)
+			regs[i] = unsigned(values[i]);
+		return true;
+#else
+		return 0 != __get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3]);
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Which register states the operating system saves on a context switch
+	unsigned long long EnabledStates()
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int low, high;
+		__asm__ volatile ("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+		return (unsigned long long)(high) << 32 | low;
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////
+	SimdLevel DetectSimdLevel()
+	{
+		unsigned int regs[4];
+		if (!CpuId(1, regs))
+			return SimdLevel::Scalar;
+
+		// The OS has to save the wide registers too, not only the CPU support them
+		const bool osSaves = 0 != (regs[2] & (1u << 27));
+		const bool avx = 0 != (regs[2] & (1u << 28));
+		if (!osSaves || !avx)
+			return SimdLevel::Scalar;
+
+		const unsigned long long states = EnabledStates();
+		if ((states & 0x6) != 0x6 || !CpuId(7, regs))
+			return SimdLevel::Scalar;
+
+		const bool avx2 = 0 != (regs[1] & (1u << 5));
+		const bool avx512 = 0 != (regs[1] & (1u << 16));
+		if (avx512 && (states & 0xE6) == 0xE6)
+			return SimdLevel::AVX512;
+		return avx2 ? SimdLevel::AVX2 : SimdLevel::Scalar;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	TARGET_AVX2 void IntersectionXAVX2(const double* leftX, const double* leftY, const double* rightX, const double* rightY,
+		double lh, double* out, size_t count)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d two = _mm256_set1_pd(2.0);
+		const __m256d minusTwo = _mm256_set1_pd(-2.0);
+		const __m256d four = _mm256_set1_pd(4.0);
+		const __m256d sign = _mm256_set1_pd(-0.0);
+		const __m256d line = _mm256_set1_pd(lh);
+		const __m256d lineSquared = _mm256_set1_pd(lh * lh);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256d lx = _mm256_loadu_pd(leftX + i);
+			const __m256d ly = _mm256_loadu_pd(leftY + i);
+			const __m256d rx = _mm256_loadu_pd(rightX + i);
+			const __m256d ry = _mm256_loadu_pd(rightY + i);
+
+			const __m256d dl = _mm256_div_pd(one, _mm256_mul_pd(two, _mm256_sub_pd(ly, line)));
+			const __m256d dr = _mm256_div_pd(one, _mm256_mul_pd(two, _mm256_sub_pd(ry, line)));
+
+			// Quadratic Coffecients
+			const __m256d a = _mm256_sub_pd(dl, dr);
+			const __m256d b = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(minusTwo, dl), lx), _mm256_mul_pd(_mm256_mul_pd(two, dr), rx));
+			const __m256d cl = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(lx, lx), _mm256_mul_pd(ly, ly)), lineSquared);
+			const __m256d cr = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(rx, rx), _mm256_mul_pd(ry, ry)), lineSquared);
+			const __m256d c = _mm256_sub_pd(_mm256_mul_pd(dl, cl), _mm256_mul_pd(dr, cr));
+
+			const __m256d root = _mm256_sqrt_pd(_mm256_sub_pd(_mm256_mul_pd(b, b), _mm256_mul_pd(_mm256_mul_pd(four, a), c)));
+			const __m256d minusB = _mm256_xor_pd(b, sign);
+			const __m256d twoA = _mm256_mul_pd(two, a);
+			const __m256d x1 = _mm256_div_pd(_mm256_add_pd(minusB, root), twoA);
+			const __m256d x2 = _mm256_div_pd(_mm256_sub_pd(minusB, root), twoA);
+
+			// Operand order matches std::max(x1, x2) and std::min(x2, x1) when a root is NaN
+			const __m256d larger = _mm256_max_pd(x2, x1);
+			const __m256d smaller = _mm256_min_pd(x1, x2);
+			const __m256d leftHigher = _mm256_cmp_pd(ly, ry, _CMP_LT_OQ);
+			__m256d x = _mm256_blendv_pd(smaller, larger, leftHigher);
+
+			// Sites on the sweep line and level sites, checked in the scalar order
+			x = _mm256_blendv_pd(x, rx, _mm256_cmp_pd(ry, line, _CMP_EQ_OQ));
+			x = _mm256_blendv_pd(x, lx, _mm256_cmp_pd(ly, line, _CMP_EQ_OQ));
+			x = _mm256_blendv_pd(x, _mm256_div_pd(_mm256_add_pd(lx, rx), two), _mm256_cmp_pd(ly, ry, _CMP_EQ_OQ));
+			_mm256_storeu_pd(out + i, x);
+		}
+
+		IntersectionXScalar(leftX + i, leftY + i, rightX + i, rightY + i, lh, out + i, count - i);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	TARGET_AVX2 void ParabolaYAVX2(const double* x, double lh, double px, double py, double* out, size_t count)
+	{
+		const double d = 2.0 * (py - lh);
+		if (d == 0)
+		{
+			for (size_t i = 0; i < count; i++)
+				out[i] = py;
+			return;
+		}
+
+		const __m256d cof = _mm256_set1_pd(1.0 / d);
+		const __m256d twoPx = _mm256_set1_pd(2.0 * px);
+		const __m256d pxSquared = _mm256_set1_pd(px * px);
+		const __m256d pySquared = _mm256_set1_pd(py * py);
+		const __m256d lineSquared = _mm256_set1_pd(lh * lh);
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m256d xs = _mm256_loadu_pd(x + i);
+			__m256d sum = _mm256_sub_pd(_mm256_mul_pd(xs, xs), _mm256_mul_pd(twoPx, xs));
+			sum = _mm256_add_pd(sum, pxSquared);
+			sum = _mm256_add_pd(sum, pySquared);
+			sum = _mm256_sub_pd(sum, lineSquared);
+			_mm256_storeu_pd(out + i, _mm256_mul_pd(cof, sum));
+		}
+
+		ParabolaYScalar(x + i, lh, px, py, out + i, count - i);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Lanes outside the mask are loaded as zero and never stored, so the tail
+	// shares the full-width path. The zero-masked forms of sqrt, min and max keep
+	// every lane defined rather than passing through an undefined register.
+	TARGET_AVX512 void IntersectionXAVX512(const double* leftX, const double* leftY, const double* rightX, const double* rightY,
+		double lh, double* out, size_t count)
+	{
+		const __m512d one = _mm512_set1_pd(1.0);
+		const __m512d two = _mm512_set1_pd(2.0);
+		const __m512d minusTwo = _mm512_set1_pd(-2.0);
+		const __m512d four = _mm512_set1_pd(4.0);
+		const __m512i sign = _mm512_set1_epi64((long long)(0x8000000000000000ull));
+		const __m512d line = _mm512_set1_pd(lh);
+		const __m512d lineSquared = _mm512_set1_pd(lh * lh);
+		const __mmask8 all = 0xFF;
+
+		for (size_t i = 0; i < count; i += 8)
+		{
+			const __mmask8 lanes = count - i >= 8 ? all : __mmask8((1u << (count - i)) - 1);
+			const __m512d lx = _mm512_maskz_loadu_pd(lanes, leftX + i);
+			const __m512d ly = _mm512_maskz_loadu_pd(lanes, leftY + i);
+			const __m512d rx = _mm512_maskz_loadu_pd(lanes, rightX + i);
+			const __m512d ry = _mm512_maskz_loadu_pd(lanes, rightY + i);
+
+			const __m512d dl = _mm512_div_pd(one, _mm512_mul_pd(two, _mm512_sub_pd(ly, line)));
+			const __m512d dr = _mm512_div_pd(one, _mm512_mul_pd(two, _mm512_sub_pd(ry, line)));
+
+			// Quadratic Coffecients
+			const __m512d a = _mm512_sub_pd(dl, dr);
+			const __m512d b = _mm512_add_pd(_mm512_mul_pd(_mm512_mul_pd(minusTwo, dl), lx), _mm512_mul_pd(_mm512_mul_pd(two, dr), rx));
+			const __m512d cl = _mm512_sub_pd(_mm512_add_pd(_mm512_mul_pd(lx, lx), _mm512_mul_pd(ly, ly)), lineSquared);
+			const __m512d cr = _mm512_sub_pd(_mm512_add_pd(_mm512_mul_pd(rx, rx), _mm512_mul_pd(ry, ry)), lineSquared);
+			const __m512d c = _mm512_sub_pd(_mm512_mul_pd(dl, cl), _mm512_mul_pd(dr, cr));
+
+			const __m512d root = _mm512_maskz_sqrt_pd(all, _mm512_sub_pd(_mm512_mul_pd(b, b), _mm512_mul_pd(_mm512_mul_pd(four, a), c)));
+			const __m512d minusB = _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(b), sign));
+			const __m512d twoA = _mm512_mul_pd(two, a);
+			const __m512d x1 = _mm512_div_pd(_mm512_add_pd(minusB, root), twoA);
+			const __m512d x2 = _mm512_div_pd(_mm512_sub_pd(minusB, root), twoA);
+
+			const __m512d larger = _mm512_maskz_max_pd(all, x2, x1);
+			const __m512d smaller = _mm512_maskz_min_pd(all, x1, x2);
+			const __mmask8 leftHigher = _mm512_cmp_pd_mask(ly, ry, _CMP_LT_OQ);
+			__m512d x = _mm512_mask_blend_pd(leftHigher, smaller, larger);
+
+			// Sites on the sweep line and level sites, checked in the scalar order
+			x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(ry, line, _CMP_EQ_OQ), x, rx);
+			x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(ly, line, _CMP_EQ_OQ), x, lx);
+			x = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(ly, ry, _CMP_EQ_OQ), x, _mm512_div_pd(_mm512_add_pd(lx, rx), two));
+			_mm512_mask_storeu_pd(out + i, lanes, x);
+		}
+	}
+#endif
+
+	std::atomic<int> CappedLevel(int(SimdLevel::AVX512));
+
+	////////////////////////////////////////////////////////////////////
+	SimdLevel SupportedLevel()
+	{
+#ifdef BATCH_X86
+		static const SimdLevel level = DetectSimdLevel();
+		return level;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	////////////////////////////////////////////////////////////////////
+	IntersectionKernel SelectIntersectionKernel()
+	{
+#ifdef BATCH_X86
+		switch (GetSimdLevel())
+		{
+		case SimdLevel::AVX512: return IntersectionXAVX512;
+		case SimdLevel::AVX2: return IntersectionXAVX2;
+		default: break;
+		}
+#endif
+		return IntersectionXScalar;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// A parabola has one focus so the AVX-512 path gains little, it shares the AVX2 one
+	ParabolaKernel SelectParabolaKernel()
+	{
+#ifdef BATCH_X86
+		if (SimdLevel::Scalar != GetSimdLevel())
+			return ParabolaYAVX2;
+#endif
+		return ParabolaYScalar;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+SimdLevel GetSimdLevel()
+{
+	const SimdLevel supported = SupportedLevel();
+	const SimdLevel capped = SimdLevel(CappedLevel.load(std::memory_order_relaxed));
+	return (int(capped) < int(supported)) ? capped : supported;
+}
+
+////////////////////////////////////////////////////////////////////
+void SetSimdLevel(SimdLevel level)
+{
+	CappedLevel.store(int(level), std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////
+void IntersectionXBatch(const double* leftX, const double* leftY, const double* rightX, const double* rightY,
+	const double lh, double* out, size_t count)
+{
+	SelectIntersectionKernel()(leftX, leftY, rightX, rightY, lh, out, count);
+}
+
+////////////////////////////////////////////////////////////////////
+void CalculateParabolaYBatch(const double* x, const double lh, const Point& point, double* out, size_t count)
+{
+	SelectParabolaKernel()(x, lh, point.x, point.y, out, count);
+}
+
+////////////////////////////////////////////////////////////////////
+void BreakpointsAt(const std::vector<SnapshotBreakpoint>& breakpoints, const double lh, std::vector<double>& x)
+{
+	const size_t count = breakpoints.size();
+	std::vector<double> foci(4 * count);
+	double* leftX = foci.data();
+	double* leftY = leftX + count;
+	double* rightX = leftY + count;
+	double* rightY = rightX + count;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		leftX[i] = breakpoints[i].Left.x;
+		leftY[i] = breakpoints[i].Left.y;
+		rightX[i] = breakpoints[i].Right.x;
+		rightY[i] = breakpoints[i].Right.y;
+	}
+
+	x.resize(count);
+	IntersectionXBatch(leftX, leftY, rightX, rightY, lh, x.data(), count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (breakpoints[i].IsVertical)
+			x[i] = (breakpoints[i].Left.x + breakpoints[i].Right.x) / 2.0;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../types/Point.h"
+#include "../types/SweepSnapshot.h"
+
+#include <cstddef>
+#include <vector>
+
+// Batched versions of IntersectionX and CalculateParabolaY that evaluate many
+// breakpoints for one sweep line at once. The widest instruction set the CPU
+// supports is picked on first use. Every path performs the scalar functions'
+// operations in the same order and none are fused into FMA, so the results are
+// identical whichever runs. CheckSimdLevels compares them.
+enum class SimdLevel
+{
+	Scalar,
+	AVX2,
+	AVX512
+};
+
+// The level the batch functions currently use
+SimdLevel GetSimdLevel();
+// Caps the level, for comparing the paths. Levels the CPU lacks fall back to the best it has.
+void SetSimdLevel(SimdLevel level);
+
+// Parameters
+//		leftX, leftY   : the left parabola focus of each breakpoint
+//		rightX, rightY : the right parabola focus of each breakpoint
+//		lh             : the line height of the sweep line
+//		out            : receives the x coordinate of each breakpoint
+//		count          : the number of breakpoints
+void IntersectionXBatch(const double* leftX, const double* leftY, const double* rightX, const double* rightY,
+	const double lh, double* out, size_t count);
+
+// Parameters
+//		x     : the x coordinates on the parabola
+//		lh    : the line height of the sweep line
+//		point : the focus point of the parabola
+//		out   : receives the y coordinate for each x
+//		count : the number of coordinates
+void CalculateParabolaYBatch(const double* x, const double lh, const Point& point, double* out, size_t count);
+
+// Where every breakpoint of a snapshot sits when the sweep line is at lh,
+// vertical breakpoints stay halfway between their sites.
+void BreakpointsAt(const std::vector<SnapshotBreakpoint>& breakpoints, const double lh, std::vector<double>& x);
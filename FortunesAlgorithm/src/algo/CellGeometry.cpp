@@ -0,0 +1,77 @@
+#include "CellGeometry.h"
+
+#include "../utils/Parallel.h"
+#include "../utils/Shoelace.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicCellPolygons<T> ExtractCells(const BasicVoronoiDiagram<T>& diagram, bool metrics, unsigned threads)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	BasicCellPolygons<T> cells;
+	const size_t n = diagram.Sites.size();
+	const size_t limit = diagram.HalfEdges.size();
+
+	// One walk measures each cell and counts its corners, the second copies them
+	cells.Offsets.assign(n + 1, 0);
+	std::vector<char> clockwise(n, 0);
+	if (metrics)
+	{
+		cells.Areas.resize(n);
+		cells.Centroids.resize(2 * n);
+	}
+
+	ParallelFor(n, threads, ParallelThreshold, [&](size_t begin, size_t end)
+	{
+		CellMeasure<Real> measure;
+		for (size_t i = begin; i < end; i++)
+		{
+			const BasicPoint<Real>& site = diagram.Sites[i]->point;
+			const bool closed = MeasureCell<T>(diagram.Sites[i]->face, site, limit, measure, [](const BasicPoint<Real>&) {});
+			cells.Offsets[i + 1] = closed ? measure.Corners : 0;
+			clockwise[i] = closed && measure.Sums.TwiceArea < Real(0);
+			if (!metrics)
+				continue;
+
+			const bool area = closed && Real(0) != measure.Sums.TwiceArea;
+			cells.Areas[i] = area ? std::abs(measure.Sums.TwiceArea) / Real(2) : Real(0);
+			cells.Centroids[2 * i] = area ? site.x + measure.Sums.CentroidX() : site.x;
+			cells.Centroids[2 * i + 1] = area ? site.y + measure.Sums.CentroidY() : site.y;
+		}
+	});
+
+	for (size_t i = 0; i < n; i++)
+		cells.Offsets[i + 1] += cells.Offsets[i];
+	cells.Coordinates.resize(2 * cells.Offsets[n]);
+
+	// Boundaries running clockwise are copied from the far end
+	ParallelFor(n, threads, ParallelThreshold, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			Real* corners = cells.Coordinates.data() + 2 * cells.Offsets[i];
+			const size_t count = cells.Offsets[i + 1] - cells.Offsets[i];
+
+			const HalfEdge* edge = count ? diagram.Sites[i]->face->outerComponent : nullptr;
+			for (size_t j = 0; j < count; j++)
+			{
+				const size_t k = clockwise[i] ? count - 1 - j : j;
+				corners[2 * k] = edge->origin->point.x;
+				corners[2 * k + 1] = edge->origin->point.y;
+				edge = edge->next;
+			}
+		}
+	});
+
+	return cells;
+}
+
+template BasicCellPolygons<float> ExtractCells(const BasicVoronoiDiagram<float>&, bool, unsigned);
+template BasicCellPolygons<double> ExtractCells(const BasicVoronoiDiagram<double>&, bool, unsigned);
+template BasicCellPolygons<int64_t> ExtractCells(const BasicVoronoiDiagram<int64_t>&, bool, unsigned);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// Every cell of a diagram as a polygon in flat buffers, ready to hand to a renderer or
+// numeric code as they are. Cell i belongs to site index i + 1.
+template<typename T>
+struct BasicCellPolygons
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+
+	// x then y of every corner, counterclockwise, cell after cell
+	std::vector<Real> Coordinates;
+	// Cell i has corners Offsets[i] to Offsets[i + 1] - 1
+	std::vector<size_t> Offsets;
+	// Filled only when metrics are asked for, one per cell, centroids as x then y
+	std::vector<Real> Areas;
+	std::vector<Real> Centroids;
+};
+
+typedef BasicCellPolygons<double> CellPolygons;
+
+// Parameters
+//		diagram : a diagram that has been run to completion
+//		metrics : also compute the area and centroid of every cell
+//		threads : threads to split the cells over, 0 uses every hardware thread
+// Walks every cell's boundary once to measure it, as Metrics does, and once to copy it,
+// both in parallel, so each cell's slice is written by one thread. A cell whose boundary
+// does not close has no corners, an area of zero and its site as the centroid.
+template<typename T>
+BasicCellPolygons<T> ExtractCells(const BasicVoronoiDiagram<T>& diagram, bool metrics = false, unsigned threads = 0);
@@ -0,0 +1,247 @@
+#include "CellLocator.h"
+
+#include "../utils/Clipping.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace
+{
+	// Queries the batched locate places before comparing candidates
+	const size_t LocateChunk = 64;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicCellLocator<T>::BasicCellLocator(const VoronoiDiagram& diagram)
+	: MinX(std::numeric_limits<Real>::max())
+	, MinY(std::numeric_limits<Real>::max())
+	, MaxX(-std::numeric_limits<Real>::max())
+	, MaxY(-std::numeric_limits<Real>::max())
+	, BucketSize(1)
+	, Columns(1)
+	, Rows(1)
+{
+	for (Face* face : diagram.Faces)
+	{
+		if (face->Unbounded || nullptr == face->site)
+			continue;
+
+		Cells.push_back(face);
+		MinX = std::min(MinX, face->site->point.x);
+		MinY = std::min(MinY, face->site->point.y);
+		MaxX = std::max(MaxX, face->site->point.x);
+		MaxY = std::max(MaxY, face->site->point.y);
+	}
+
+	BucketStart.assign(2, 0);
+	if (Cells.empty())
+		return;
+
+	// Cells of hull sites run out to the bounding box, far past the sites, so the grid
+	// covers the sites and square buckets hold about one cell each
+	const Real width = MaxX - MinX;
+	const Real height = MaxY - MinY;
+	BucketSize = std::sqrt(width * height / Real(Cells.size()));
+	if (!(BucketSize > Real(0)))
+		BucketSize = std::max({ width, height, Real(1) }) / Real(Cells.size());
+	Columns = std::max<size_t>(1, size_t(std::ceil(width / BucketSize)));
+	Rows = std::max<size_t>(1, size_t(std::ceil(height / BucketSize)));
+
+	// The buckets each cell overlaps, from the bounds of the part of the cell inside the grid
+	struct Span { size_t firstColumn, lastColumn, firstRow, lastRow; bool empty; };
+	std::vector<Span> spans(Cells.size());
+	std::vector<Point> polygon, clipped;
+
+	auto column = [this](Real x) { return size_t(std::min(std::max((x - MinX) / BucketSize, Real(0)), Real(Columns - 1))); };
+	auto row = [this](Real y) { return size_t(std::min(std::max((y - MinY) / BucketSize, Real(0)), Real(Rows - 1))); };
+
+	for (size_t i = 0; i < Cells.size(); i++)
+	{
+		Face* face = Cells[i];
+		polygon.clear();
+		bool closed = false;
+
+		HalfEdge* start = face->outerComponent;
+		HalfEdge* edge = start;
+		size_t steps = 0;
+		while (edge && steps++ <= diagram.HalfEdges.size())
+		{
+			if (edge->origin)
+				polygon.push_back(edge->origin->point);
+			edge = edge->next;
+			if (edge == start)
+			{
+				closed = true;
+				break;
+			}
+		}
+
+		// An open boundary gives no shape, the cell is listed everywhere
+		if (!closed || polygon.size() < 3)
+		{
+			spans[i] = { 0, Columns - 1, 0, Rows - 1, false };
+			OuterCells.push_back(face);
+			continue;
+		}
+
+		Real minX = polygon[0].x, minY = polygon[0].y, maxX = polygon[0].x, maxY = polygon[0].y;
+		for (const Point& p : polygon)
+		{
+			minX = std::min(minX, p.x);
+			minY = std::min(minY, p.y);
+			maxX = std::max(maxX, p.x);
+			maxY = std::max(maxY, p.y);
+		}
+
+		// Only cells reaching past the grid can hold a point outside it
+		if (minX < MinX || minY < MinY || maxX > MaxX || maxY > MaxY)
+		{
+			OuterCells.push_back(face);
+			ClipToRectangle(polygon, clipped, MinX, MinY, MaxX, MaxY);
+			if (polygon.empty())
+			{
+				spans[i] = { 0, 0, 0, 0, true };
+				continue;
+			}
+
+			minX = minY = std::numeric_limits<Real>::max();
+			maxX = maxY = -std::numeric_limits<Real>::max();
+			for (const Point& p : polygon)
+			{
+				minX = std::min(minX, p.x);
+				minY = std::min(minY, p.y);
+				maxX = std::max(maxX, p.x);
+				maxY = std::max(maxY, p.y);
+			}
+		}
+
+		spans[i] = { column(minX), column(maxX), row(minY), row(maxY), false };
+	}
+
+	// Count, then place, every cell in every bucket it overlaps
+	BucketStart.assign(Columns * Rows + 1, 0);
+	for (const Span& span : spans)
+	{
+		if (span.empty) continue;
+		for (size_t r = span.firstRow; r <= span.lastRow; r++)
+			for (size_t c = span.firstColumn; c <= span.lastColumn; c++)
+				BucketStart[r * Columns + c + 1]++;
+	}
+	for (size_t i = 1; i < BucketStart.size(); i++)
+		BucketStart[i] += BucketStart[i - 1];
+
+	const size_t total = BucketStart.back();
+	CandidateX.resize(total);
+	CandidateY.resize(total);
+	CandidateCell.resize(total);
+
+	std::vector<size_t> fill(BucketStart.begin(), BucketStart.end() - 1);
+	for (size_t i = 0; i < Cells.size(); i++)
+	{
+		const Span& span = spans[i];
+		if (span.empty) continue;
+		for (size_t r = span.firstRow; r <= span.lastRow; r++)
+		{
+			for (size_t c = span.firstColumn; c <= span.lastColumn; c++)
+			{
+				const size_t slot = fill[r * Columns + c]++;
+				CandidateX[slot] = Cells[i]->site->point.x;
+				CandidateY[slot] = Cells[i]->site->point.y;
+				CandidateCell[slot] = Cells[i];
+			}
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicCellLocator<T>::Face* BasicCellLocator<T>::LocateCell(const Point& point) const
+{
+	const size_t bucket = Bucket(point);
+	if (NoBucket == bucket)
+		return NearestOf(point, OuterCells);
+	return NearestInBucket(point, bucket);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicCellLocator<T>::LocateCells(const Point* points, size_t count, Face** cells) const
+{
+	size_t buckets[LocateChunk];
+	for (size_t begin = 0; begin < count; begin += LocateChunk)
+	{
+		const size_t end = std::min(count, begin + LocateChunk);
+
+		// Bucket arithmetic for the whole chunk first, it has no branches to speak of
+		for (size_t i = begin; i < end; i++)
+			buckets[i - begin] = Bucket(points[i]);
+
+		for (size_t i = begin; i < end; i++)
+		{
+			const size_t bucket = buckets[i - begin];
+			cells[i] = (NoBucket == bucket) ? NearestOf(points[i], OuterCells) : NearestInBucket(points[i], bucket);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+size_t BasicCellLocator<T>::Bucket(const Point& point) const
+{
+	if (Cells.empty() || point.x < MinX || point.x > MaxX || point.y < MinY || point.y > MaxY)
+		return NoBucket;
+
+	const size_t c = std::min(size_t((point.x - MinX) / BucketSize), Columns - 1);
+	const size_t r = std::min(size_t((point.y - MinY) / BucketSize), Rows - 1);
+	return r * Columns + c;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicCellLocator<T>::Face* BasicCellLocator<T>::NearestInBucket(const Point& point, size_t bucket) const
+{
+	const size_t begin = BucketStart[bucket];
+	const size_t end = BucketStart[bucket + 1];
+
+	size_t best = begin;
+	Real bestDistance = std::numeric_limits<Real>::max();
+	for (size_t i = begin; i < end; i++)
+	{
+		const Real changeX = CandidateX[i] - point.x;
+		const Real changeY = CandidateY[i] - point.y;
+		const Real distance = changeX * changeX + changeY * changeY;
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			best = i;
+		}
+	}
+	return (begin == end) ? NearestOf(point, Cells) : CandidateCell[best];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicCellLocator<T>::Face* BasicCellLocator<T>::NearestOf(const Point& point, const std::vector<Face*>& cells) const
+{
+	Face* best = nullptr;
+	Real bestDistance = std::numeric_limits<Real>::max();
+	for (Face* cell : cells)
+	{
+		const Real changeX = cell->site->point.x - point.x;
+		const Real changeY = cell->site->point.y - point.y;
+		const Real distance = changeX * changeX + changeY * changeY;
+		if (distance < bestDistance)
+		{
+			bestDistance = distance;
+			best = cell;
+		}
+	}
+	return best;
+}
+
+template class BasicCellLocator<float>;
+template class BasicCellLocator<double>;
+template class BasicCellLocator<int64_t>;
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// Answers which Voronoi cell holds a point once the diagram is finished. A grid of square
+// buckets, about one per cell, is laid over the bounds of the sites and every bucket
+// lists the cells whose bounds overlap it. The cell holding a point overlaps the
+// point's bucket, so the nearest of the listed sites is its site, and a query compares a
+// handful of sites in expectation. The lists are flat coordinate arrays, bucket after
+// bucket, which the batched query runs through in tight loops. Nothing changes after
+// construction so any number of threads may query one locator.
+template<typename T>
+class BasicCellLocator
+{
+public:
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	// The diagram must have been run to completion
+	BasicCellLocator(const VoronoiDiagram& diagram);
+
+	// Returns the cell holding the point, either neighbour for a point on a shared edge.
+	// Points outside the grid compare the sites of the cells reaching past it.
+	Face* LocateCell(const Point& point) const;
+
+	// Parameters
+	//		points : the points to locate
+	//		count  : the number of points
+	//		cells  : receives the cell of every point
+	void LocateCells(const Point* points, size_t count, Face** cells) const;
+
+private:
+	static const size_t NoBucket = size_t(-1);
+
+	size_t Bucket(const Point& point) const;
+	Face* NearestInBucket(const Point& point, size_t bucket) const;
+	Face* NearestOf(const Point& point, const std::vector<Face*>& cells) const;
+
+	Real MinX, MinY, MaxX, MaxY;
+	Real BucketSize;
+	size_t Columns, Rows;
+
+	// Candidates of bucket b are [BucketStart[b], BucketStart[b + 1])
+	std::vector<size_t> BucketStart;
+	std::vector<Real> CandidateX;
+	std::vector<Real> CandidateY;
+	std::vector<Face*> CandidateCell;
+
+	std::vector<Face*> Cells;
+	// Cells reaching past the grid, the only ones that can hold a point outside it
+	std::vector<Face*> OuterCells;
+};
+
+typedef BasicCellLocator<double> CellLocator;
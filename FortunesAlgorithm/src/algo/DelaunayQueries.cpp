@@ -0,0 +1,578 @@
+#include "DelaunayQueries.h"
+
+#include "../utils/HilbertCurve.h"
+#include "../utils/Parallel.h"
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	////////////////////////////////////////////////////////////////////
+	// Calls visit with every triangulation half-edge leaving the vertex. The outgoing edges
+	// are turned through in one direction, and when the fan is open, from the far side too.
+	template<typename T, typename Visit>
+	void ForEachOutgoing(DCEL::BasicVertex<T>* vertex, Visit visit)
+	{
+		typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+		HalfEdge* start = vertex->incidentEdge;
+		if (nullptr == start)
+			return;
+
+		HalfEdge* edge = start;
+		do
+		{
+			visit(edge);
+			edge = (edge->prev) ? edge->prev->twin : nullptr;
+		} while (edge && edge != start);
+
+		if (edge == start)
+			return;
+
+		edge = start->twin ? start->twin->next : nullptr;
+		while (edge && edge != start && edge->origin == vertex)
+		{
+			visit(edge);
+			edge = edge->twin ? edge->twin->next : nullptr;
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Calls visit with every Delaunay neighbour of the vertex
+	template<typename T, typename Visit>
+	void ForEachNeighbour(DCEL::BasicVertex<T>* vertex, Visit visit)
+	{
+		ForEachOutgoing<T>(vertex, [&visit](DCEL::BasicHalfEdge<T>* edge) { visit(edge->dest); });
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename Real>
+	Real DistanceSquared(const BasicPoint<Real>& a, const BasicPoint<Real>& b)
+	{
+		const Real changeX = a.x - b.x;
+		const Real changeY = a.y - b.y;
+		return changeX * changeX + changeY * changeY;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename Real>
+	struct Box
+	{
+		Real MinX, MinY, MaxX, MaxY;
+	};
+
+	////////////////////////////////////////////////////////////////////
+	// Length of the part of start + t * direction, tMin <= t <= tMax, inside the box
+	template<typename Real>
+	Real ClippedLength(const BasicPoint<Real>& start, const BasicPoint<Real>& direction, Real tMin, Real tMax, const Box<Real>& box)
+	{
+		auto slab = [&](Real origin, Real change, Real low, Real high)
+		{
+			if (Real(0) == change)
+			{
+				if (origin < low || origin > high)
+					tMax = tMin - Real(1);
+				return;
+			}
+			Real first = (low - origin) / change;
+			Real second = (high - origin) / change;
+			if (first > second)
+				std::swap(first, second);
+			tMin = std::max(tMin, first);
+			tMax = std::min(tMax, second);
+		};
+		slab(start.x, direction.x, box.MinX, box.MaxX);
+		slab(start.y, direction.y, box.MinY, box.MaxY);
+
+		if (tMax <= tMin)
+			return Real(0);
+		return (tMax - tMin) * std::sqrt(direction.x * direction.x + direction.y * direction.y);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// The Voronoi edge dual to a Delaunay edge runs between the circumcentres of the
+	// triangles on either side of it. On the hull only one side has a triangle and the
+	// edge is a ray away from it. Either way it is cut to the box the diagram is clipped to.
+	// The half edge leaving the lower index is measured for both, so the pair agrees to the bit.
+	template<typename T>
+	typename CoordinateTraits<T>::Real SharedEdgeLength(DCEL::BasicHalfEdge<T>* edge,
+		const Box<typename CoordinateTraits<T>::Real>& box)
+	{
+		typedef typename CoordinateTraits<T>::Real Real;
+		typedef DCEL::BasicHalfEdge<T> HalfEdge;
+		typedef BasicPoint<Real> Point;
+
+		if (edge->twin && edge->dest->index < edge->origin->index)
+			edge = edge->twin;
+
+		const Point& a = edge->origin->point;
+		const Point& b = edge->dest->point;
+		const Real infinity = std::numeric_limits<Real>::infinity();
+
+		// The corner of the triangle on each side of the edge, nullptr on the hull
+		auto corner = [](HalfEdge* side) -> DCEL::BasicVertex<T>*
+		{
+			if (nullptr == side || nullptr == side->incidentFace || side->incidentFace->Unbounded || nullptr == side->next)
+				return nullptr;
+			return side->next->dest;
+		};
+		DCEL::BasicVertex<T>* left = corner(edge);
+		DCEL::BasicVertex<T>* right = corner(edge->twin);
+
+		const Point normal(b.y - a.y, a.x - b.x);
+		if (left && right)
+		{
+			const Point start = Circumcentre(a, b, left->point);
+			const Point end = Circumcentre(a, b, right->point);
+			return ClippedLength(start, Point(end.x - start.x, end.y - start.y), Real(0), Real(1), box);
+		}
+		if (left || right)
+		{
+			const Point& inside = (left ? left : right)->point;
+			const Point start = Circumcentre(a, b, inside);
+			// Away from the triangle, across the edge
+			const Real side = normal.x * (inside.x - a.x) + normal.y * (inside.y - a.y);
+			const Point direction = (side > Real(0)) ? Point(-normal.x, -normal.y) : normal;
+			return ClippedLength(start, direction, Real(0), infinity, box);
+		}
+
+		const Point middle((a.x + b.x) / Real(2), (a.y + b.y) / Real(2));
+		return ClippedLength(middle, normal, -infinity, infinity, box);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Open addressing set of the vertices an expansion has reached, it grows with the
+	// expansion and is cleared by wiping the few slots in use
+	class VisitedSet
+	{
+	public:
+		VisitedSet() : Slots(64, nullptr), Count(0) {}
+
+		// Returns false when the vertex was already in the set
+		bool Insert(const void* vertex)
+		{
+			if (2 * (Count + 1) > Slots.size())
+				Grow();
+
+			const size_t mask = Slots.size() - 1;
+			// Vertices are aligned allocations, mix the address so the low bits vary
+			size_t slot = size_t((uint64_t(uintptr_t(vertex)) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+			while (Slots[slot])
+			{
+				if (Slots[slot] == vertex)
+					return false;
+				slot = (slot + 1) & mask;
+			}
+			Slots[slot] = vertex;
+			Used.push_back(slot);
+			Count++;
+			return true;
+		}
+
+		void Clear()
+		{
+			for (size_t slot : Used)
+				Slots[slot] = nullptr;
+			Used.clear();
+			Count = 0;
+		}
+
+	private:
+		void Grow()
+		{
+			std::vector<const void*> old;
+			old.swap(Slots);
+			Slots.assign(2 * old.size(), nullptr);
+			Used.clear();
+			Count = 0;
+			for (const void* vertex : old)
+			{
+				if (vertex)
+					Insert(vertex);
+			}
+		}
+
+		std::vector<const void*> Slots;
+		std::vector<size_t> Used;
+		size_t Count;
+	};
+
+	////////////////////////////////////////////////////////////////////
+	// What one thread reuses from query to query
+	template<typename T>
+	struct Expansion
+	{
+		typedef typename CoordinateTraits<T>::Real Real;
+
+		std::vector<std::pair<Real, DCEL::BasicVertex<T>*>> Frontier;
+		VisitedSet Visited;
+	};
+
+	////////////////////////////////////////////////////////////////////
+	// Positions 0 to count - 1 sorted along a Hilbert curve over the bounds of the points.
+	// Walking the triangulation in this order keeps the vertices it touches in cache.
+	template<typename Real, typename GetPoint>
+	std::vector<size_t> CurveOrder(size_t count, GetPoint point)
+	{
+		std::vector<size_t> order(count);
+		if (0 == count)
+			return order;
+
+		Real minX = point(0).x, minY = point(0).y, maxX = point(0).x, maxY = point(0).y;
+		for (size_t i = 0; i < count; i++)
+		{
+			minX = std::min(minX, point(i).x);
+			minY = std::min(minY, point(i).y);
+			maxX = std::max(maxX, point(i).x);
+			maxY = std::max(maxY, point(i).y);
+		}
+
+		const Real cells = Real((uint32_t(1) << HilbertOrder) - 1);
+		const Real width = maxX > minX ? maxX - minX : Real(1);
+		const Real height = maxY > minY ? maxY - minY : Real(1);
+		std::vector<std::pair<uint64_t, size_t>> keyed(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			const uint32_t x = uint32_t((point(i).x - minX) / width * cells);
+			const uint32_t y = uint32_t((point(i).y - minY) / height * cells);
+			keyed[i] = { HilbertIndex(x, y), i };
+		}
+		std::sort(keyed.begin(), keyed.end());
+
+		for (size_t i = 0; i < count; i++)
+			order[i] = keyed[i].second;
+		return order;
+	}
+
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicVoronoiSite<T>* NearestSite(const BasicVoronoiDiagram<T>& diagram,
+	const BasicPoint<typename CoordinateTraits<T>::Real>& point, BasicVoronoiSite<T>* hint)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+
+	if (diagram.Sites.empty())
+		return nullptr;
+
+	if (nullptr == hint)
+		hint = diagram.Sites.front();
+
+	// Without triangles, when every site is on one line, there is nothing to walk
+	Vertex* current = hint->triVertex;
+	if (nullptr == current || nullptr == current->incidentEdge)
+	{
+		VoronoiSite* best = hint;
+		for (VoronoiSite* site : diagram.Sites)
+		{
+			if (DistanceSquared(site->point, point) < DistanceSquared(best->point, point))
+				best = site;
+		}
+		return best;
+	}
+
+	Real currentDistance = DistanceSquared(current->point, point);
+	while (true)
+	{
+		Vertex* next = current;
+		Real nextDistance = currentDistance;
+		ForEachNeighbour<T>(current, [&](Vertex* neighbour)
+		{
+			if (nullptr == neighbour)
+				return;
+			const Real distance = DistanceSquared(neighbour->point, point);
+			if (distance < nextDistance)
+			{
+				next = neighbour;
+				nextDistance = distance;
+			}
+		});
+
+		if (next == current)
+			break;
+		current = next;
+		currentDistance = nextDistance;
+	}
+
+	// Delaunay vertices carry the index of their site
+	return diagram.Sites[current->index - 1];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NearestSites(const BasicVoronoiDiagram<T>& diagram,
+	const BasicPoint<typename CoordinateTraits<T>::Real>* points, size_t count, BasicVoronoiSite<T>** sites)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+
+	// Along the curve consecutive walks are short
+	const std::vector<size_t> order = CurveOrder<Real>(count, [points](size_t i) -> const BasicPoint<Real>& { return points[i]; });
+
+	VoronoiSite* hint = nullptr;
+	for (size_t query : order)
+	{
+		hint = NearestSite(diagram, points[query], hint);
+		sites[query] = hint;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Takes the closest vertex of the frontier until k are taken, skipping the first skip of
+// them, and pushes the neighbours of each one taken
+template<typename T, typename Take>
+static void Expand(Expansion<T>& expansion, DCEL::BasicVertex<T>* start,
+	const BasicPoint<typename CoordinateTraits<T>::Real>& point, size_t k, size_t skip, Take take)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef std::pair<Real, Vertex*> Entry;
+
+	std::vector<Entry>& frontier = expansion.Frontier;
+	frontier.clear();
+	expansion.Visited.Clear();
+
+	frontier.push_back({ DistanceSquared(start->point, point), start });
+	expansion.Visited.Insert(start);
+
+	size_t taken = 0;
+	while (!frontier.empty() && taken < k + skip)
+	{
+		std::pop_heap(frontier.begin(), frontier.end(), std::greater<Entry>());
+		Vertex* vertex = frontier.back().second;
+		frontier.pop_back();
+
+		if (taken++ >= skip)
+			take(vertex);
+
+		ForEachNeighbour<T>(vertex, [&](Vertex* neighbour)
+		{
+			if (nullptr == neighbour || !expansion.Visited.Insert(neighbour))
+				return;
+			frontier.push_back({ DistanceSquared(neighbour->point, point), neighbour });
+			std::push_heap(frontier.begin(), frontier.end(), std::greater<Entry>());
+		});
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void KNearest(const BasicVoronoiDiagram<T>& diagram, const BasicPoint<typename CoordinateTraits<T>::Real>& point,
+	size_t k, std::vector<BasicVoronoiSite<T>*>& sites, BasicVoronoiSite<T>* hint)
+{
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+
+	sites.clear();
+	VoronoiSite* nearest = NearestSite(diagram, point, hint);
+	if (nullptr == nearest || 0 == k)
+		return;
+
+	// Without triangles, when every site is on one line, sort them all
+	if (nullptr == nearest->triVertex || nullptr == nearest->triVertex->incidentEdge)
+	{
+		sites = diagram.Sites;
+		const size_t count = std::min(k, sites.size());
+		std::partial_sort(sites.begin(), sites.begin() + count, sites.end(), [&point](const VoronoiSite* a, const VoronoiSite* b)
+		{
+			return DistanceSquared(a->point, point) < DistanceSquared(b->point, point);
+		});
+		sites.resize(count);
+		return;
+	}
+
+	Expansion<T> expansion;
+	Expand<T>(expansion, nearest->triVertex, point, k, 0, [&](Vertex* vertex)
+	{
+		sites.push_back(diagram.Sites[vertex->index - 1]);
+	});
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void KNearestGraph(const BasicVoronoiDiagram<T>& diagram, size_t k,
+	std::vector<size_t>& offsets, std::vector<int>& neighbours, unsigned threads)
+{
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+
+	const size_t n = diagram.Sites.size();
+	const size_t row = (n > 0) ? std::min(k, n - 1) : 0;
+
+	offsets.resize(n + 1);
+	for (size_t i = 0; i <= n; i++)
+		offsets[i] = i * row;
+	neighbours.assign(n * row, 0);
+	if (0 == row)
+		return;
+
+	// Sites are taken along the curve and each thread takes a stretch of it. Each site's
+	// row is its own slice of neighbours, threads never share one.
+	const std::vector<size_t> order = CurveOrder<typename CoordinateTraits<T>::Real>(n,
+		[&diagram](size_t i) -> const BasicPoint<typename CoordinateTraits<T>::Real>& { return diagram.Sites[i]->point; });
+
+	auto fillRange = [&](size_t begin, size_t end)
+	{
+		Expansion<T> expansion;
+		std::vector<VoronoiSite*> found;
+		for (size_t position = begin; position < end; position++)
+		{
+			const size_t i = order[position];
+			VoronoiSite* site = diagram.Sites[i];
+			int* out = &neighbours[offsets[i]];
+
+			if (nullptr == site->triVertex || nullptr == site->triVertex->incidentEdge)
+			{
+				KNearest(diagram, site->point, row + 1, found, site);
+				size_t j = 0;
+				for (VoronoiSite* other : found)
+				{
+					if (other != site && j < row)
+						out[j++] = other->index;
+				}
+				continue;
+			}
+
+			// The site itself comes out first
+			size_t j = 0;
+			Expand<T>(expansion, site->triVertex, site->point, row, 1, [&](Vertex* vertex)
+			{
+				out[j++] = vertex->index;
+			});
+		}
+	};
+
+	ParallelFor(n, threads, ParallelThreshold, fillRange);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NeighbourGraph(const BasicVoronoiDiagram<T>& diagram, std::vector<size_t>& offsets, std::vector<int>& neighbours,
+	std::vector<typename CoordinateTraits<T>::Real>* edgeLengths, unsigned threads)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	const size_t n = diagram.Sites.size();
+	offsets.assign(n + 1, 0);
+	neighbours.clear();
+	if (edgeLengths)
+		edgeLengths->clear();
+	if (n < 2)
+		return;
+
+	// The sweep clips the diagram to a box it leaves behind as vertices
+	Box<Real> box = { std::numeric_limits<Real>::max(), std::numeric_limits<Real>::max(),
+		-std::numeric_limits<Real>::max(), -std::numeric_limits<Real>::max() };
+	for (const Vertex* vertex : diagram.Vertices)
+	{
+		if (!vertex->box)
+			continue;
+		box.MinX = std::min(box.MinX, vertex->point.x);
+		box.MinY = std::min(box.MinY, vertex->point.y);
+		box.MaxX = std::max(box.MaxX, vertex->point.x);
+		box.MaxY = std::max(box.MaxY, vertex->point.y);
+	}
+
+	// Without triangles every site is on one line and neighbours the sites either side of it
+	VoronoiSite* first = diagram.Sites.front();
+	if (nullptr == first->triVertex || nullptr == first->triVertex->incidentEdge)
+	{
+		std::vector<VoronoiSite*> line = diagram.Sites;
+		std::sort(line.begin(), line.end(), [](const VoronoiSite* a, const VoronoiSite* b)
+		{
+			return a->point.x < b->point.x || (a->point.x == b->point.x && a->point.y < b->point.y);
+		});
+
+		std::vector<std::vector<std::pair<int, Real>>> rows(n);
+		for (size_t i = 0; i + 1 < n; i++)
+		{
+			const BasicPoint<Real>& a = line[i]->point;
+			const BasicPoint<Real>& b = line[i + 1]->point;
+			const Real infinity = std::numeric_limits<Real>::infinity();
+			const Real length = ClippedLength(BasicPoint<Real>((a.x + b.x) / Real(2), (a.y + b.y) / Real(2)),
+				BasicPoint<Real>(b.y - a.y, a.x - b.x), -infinity, infinity, box);
+			rows[line[i]->index - 1].push_back({ line[i + 1]->index, length });
+			rows[line[i + 1]->index - 1].push_back({ line[i]->index, length });
+		}
+
+		for (size_t i = 0; i < n; i++)
+		{
+			offsets[i + 1] = offsets[i] + rows[i].size();
+			for (const std::pair<int, Real>& neighbour : rows[i])
+			{
+				neighbours.push_back(neighbour.first);
+				if (edgeLengths)
+					edgeLengths->push_back(neighbour.second);
+			}
+		}
+		return;
+	}
+
+	// Count every row first so the rows can then be written in place by any thread
+	ParallelFor(n, threads, ParallelThreshold, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t degree = 0;
+			ForEachNeighbour<T>(diagram.Sites[i]->triVertex, [&degree](Vertex* neighbour) { if (neighbour) degree++; });
+			offsets[i + 1] = degree;
+		}
+	});
+
+	for (size_t i = 0; i < n; i++)
+		offsets[i + 1] += offsets[i];
+
+	neighbours.resize(offsets[n]);
+	if (edgeLengths)
+		edgeLengths->resize(offsets[n]);
+
+	ParallelFor(n, threads, ParallelThreshold, [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			size_t j = offsets[i];
+			ForEachOutgoing<T>(diagram.Sites[i]->triVertex, [&](HalfEdge* edge)
+			{
+				if (nullptr == edge->dest)
+					return;
+				neighbours[j] = edge->dest->index;
+				if (edgeLengths)
+					(*edgeLengths)[j] = SharedEdgeLength<T>(edge, box);
+				j++;
+			});
+		}
+	});
+}
+
+template BasicVoronoiSite<float>* NearestSite(const BasicVoronoiDiagram<float>&, const BasicPoint<double>&, BasicVoronoiSite<float>*);
+template BasicVoronoiSite<double>* NearestSite(const BasicVoronoiDiagram<double>&, const BasicPoint<double>&, BasicVoronoiSite<double>*);
+template BasicVoronoiSite<int64_t>* NearestSite(const BasicVoronoiDiagram<int64_t>&, const BasicPoint<long double>&, BasicVoronoiSite<int64_t>*);
+
+template void NearestSites(const BasicVoronoiDiagram<float>&, const BasicPoint<double>*, size_t, BasicVoronoiSite<float>**);
+template void NearestSites(const BasicVoronoiDiagram<double>&, const BasicPoint<double>*, size_t, BasicVoronoiSite<double>**);
+template void NearestSites(const BasicVoronoiDiagram<int64_t>&, const BasicPoint<long double>*, size_t, BasicVoronoiSite<int64_t>**);
+
+template void KNearest(const BasicVoronoiDiagram<float>&, const BasicPoint<double>&, size_t, std::vector<BasicVoronoiSite<float>*>&, BasicVoronoiSite<float>*);
+template void KNearest(const BasicVoronoiDiagram<double>&, const BasicPoint<double>&, size_t, std::vector<BasicVoronoiSite<double>*>&, BasicVoronoiSite<double>*);
+template void KNearest(const BasicVoronoiDiagram<int64_t>&, const BasicPoint<long double>&, size_t, std::vector<BasicVoronoiSite<int64_t>*>&, BasicVoronoiSite<int64_t>*);
+
+template void KNearestGraph(const BasicVoronoiDiagram<float>&, size_t, std::vector<size_t>&, std::vector<int>&, unsigned);
+template void KNearestGraph(const BasicVoronoiDiagram<double>&, size_t, std::vector<size_t>&, std::vector<int>&, unsigned);
+template void KNearestGraph(const BasicVoronoiDiagram<int64_t>&, size_t, std::vector<size_t>&, std::vector<int>&, unsigned);
+
+template void NeighbourGraph(const BasicVoronoiDiagram<float>&, std::vector<size_t>&, std::vector<int>&, std::vector<double>*, unsigned);
+template void NeighbourGraph(const BasicVoronoiDiagram<double>&, std::vector<size_t>&, std::vector<int>&, std::vector<double>*, unsigned);
+template void NeighbourGraph(const BasicVoronoiDiagram<int64_t>&, std::vector<size_t>&, std::vector<int>&, std::vector<long double>*, unsigned);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// Queries answered by walking the Delaunay triangulation of a finished diagram. They need
+// no index beyond the triangulation the sweep already built.
+
+// Parameters
+//		diagram : a diagram that has been run to completion
+//		point   : the query point
+//		hint    : the site to start the walk from, nullptr starts from the first site
+// Walks from the hint to whichever Delaunay neighbour is closer to the point until no
+// neighbour is. On a Delaunay triangulation that site is the nearest, so the walk is as
+// long as the distance from the hint, and passing the previous answer for coherent
+// queries makes each one a few steps.
+template<typename T>
+BasicVoronoiSite<T>* NearestSite(const BasicVoronoiDiagram<T>& diagram,
+	const BasicPoint<typename CoordinateTraits<T>::Real>& point, BasicVoronoiSite<T>* hint = nullptr);
+
+// Parameters
+//		diagram : a diagram that has been run to completion
+//		points  : the query points
+//		count   : the number of points
+//		sites   : receives the nearest site of every point
+// Answers the points in Hilbert curve order, each walk starting from the previous answer,
+// and writes the results back in input order.
+template<typename T>
+void NearestSites(const BasicVoronoiDiagram<T>& diagram,
+	const BasicPoint<typename CoordinateTraits<T>::Real>* points, size_t count, BasicVoronoiSite<T>** sites);
+
+// Parameters
+//		diagram : a diagram that has been run to completion
+//		point   : the query point
+//		k       : how many sites to find
+//		sites   : receives the k nearest sites, nearest first
+//		hint    : where to start the walk to the nearest site
+// Expands outward from the nearest site over Delaunay neighbours, always taking the closest
+// site on the frontier next. The j-th nearest site neighbours one of the j - 1 before it,
+// so the first k taken are the k nearest. Fewer come back when there are fewer sites.
+template<typename T>
+void KNearest(const BasicVoronoiDiagram<T>& diagram, const BasicPoint<typename CoordinateTraits<T>::Real>& point,
+	size_t k, std::vector<BasicVoronoiSite<T>*>& sites, BasicVoronoiSite<T>* hint = nullptr);
+
+// Parameters
+//		diagram    : a diagram that has been run to completion
+//		k          : how many neighbours every site gets
+//		offsets    : receives where each site's row starts, row i is site index i + 1
+//		neighbours : receives the indices of the neighbours, nearest first
+//		threads    : threads to split the sites over, 0 uses every hardware thread
+// The k nearest other sites of every site in compressed rows. Every row holds k sites,
+// or all other sites when there are fewer, so rows are filled in parallel in place.
+template<typename T>
+void KNearestGraph(const BasicVoronoiDiagram<T>& diagram, size_t k,
+	std::vector<size_t>& offsets, std::vector<int>& neighbours, unsigned threads = 0);
+
+// Parameters
+//		diagram     : a diagram that has been run to completion
+//		offsets     : receives where each site's row starts, row i is site index i + 1
+//		neighbours  : receives the indices of the Delaunay neighbours of every site
+//		edgeLengths : when given, receives the length of the Voronoi edge each pair shares
+//		threads     : threads to split the sites over, 0 uses every hardware thread
+// The site adjacency graph in compressed rows, for consumers that would rather not walk
+// the half-edges. Degrees are counted in a first pass so the rows are then written in
+// parallel. Lengths come from the circumcentres either side of each Delaunay edge, clipped
+// to the diagram's bounding box, so both directions of a pair agree. Neighbours across a
+// degenerate edge, on four or more co-circular sites, share only a point and get zero.
+template<typename T>
+void NeighbourGraph(const BasicVoronoiDiagram<T>& diagram, std::vector<size_t>& offsets, std::vector<int>& neighbours,
+	std::vector<typename CoordinateTraits<T>::Real>* edgeLengths = nullptr, unsigned threads = 0);
@@ -0,0 +1,575 @@
+#include "DualCells.h"
+
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	// The sweep's margin between the diagram and its bounding box
+	const double BoxMargin = 5.0;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicDualCells<T>::BasicDualCells(VoronoiDiagram& diagram)
+	: Diagram(diagram)
+	, Outside(nullptr)
+	, MinX(0)
+	, MinY(0)
+	, MaxX(0)
+	, MaxY(0)
+	, VoronoiIndex(0)
+	, BoxIndex(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+// Triangles whose centres are within the sweep's snap share one vertex, and each hull
+// edge gives a ray out to a box with the sweep's margin about the sites and vertices. The
+// box is cut at every ray and its corners, and the pieces close the cells of the hull
+// sites.
+template<typename T>
+bool BasicDualCells<T>::Build(Face* outside, bool weighted)
+{
+	Outside = outside;
+	if (nullptr == Outside || nullptr == Outside->innerComponent)
+		return false;
+	if (Diagram.Faces.empty() || !Diagram.Faces.back()->Unbounded)
+		return false;
+	Face* unbounded = Diagram.Faces.back();
+
+	// Where each site's cell starts, after the spoke into the outside on the hull so the
+	// box closes the cell last
+	Starts.resize(Diagram.Sites.size());
+	for (size_t i = 0; i < Diagram.Sites.size(); i++)
+	{
+		const VoronoiSite* site = Diagram.Sites[i];
+		Starts[i] = nullptr;
+		if (nullptr == site->face)
+			return false;
+		if (nullptr == site->triVertex)
+			continue;
+		if (nullptr == site->triVertex->incidentEdge)
+			return false;
+
+		HalfEdge* first = site->triVertex->incidentEdge;
+		HalfEdge* spoke = first;
+		Starts[i] = first;
+		size_t steps = 0;
+		do
+		{
+			if (spoke->origin != site->triVertex || ++steps > FanLimit)
+				return false;
+			if (spoke->incidentFace != Outside && spoke->twin->incidentFace == Outside)
+				Starts[i] = spoke;
+			spoke = spoke->prev->twin;
+		} while (spoke != first);
+	}
+
+	Hull.clear();
+	HalfEdge* start = Outside->innerComponent;
+	HalfEdge* edge = start;
+	do
+	{
+		Hull.push_back(edge->twin);
+		edge = edge->prev;
+		if (Hull.size() > Diagram.TriangulationHalfEdges.size())
+			return false;
+	} while (edge != start);
+	if (Hull.size() < 3)
+		return false;
+
+	const size_t m = Diagram.TriangulationFaces.size();
+	Centres.resize(m, Point(0, 0));
+	Parent.resize(m);
+	Real minX = Diagram.MinX, minY = Diagram.MinY, maxX = Diagram.MaxX, maxY = Diagram.MaxY;
+	for (size_t i = 0; i < m; i++)
+	{
+		Face* triangle = Diagram.TriangulationFaces[i];
+		triangle->index = int(i) + 1;
+		Parent[i] = i;
+		if (triangle == Outside)
+			continue;
+
+		const HalfEdge* first = triangle->outerComponent;
+		const Vertex* a = first->origin;
+		const Vertex* b = first->dest;
+		const Vertex* c = first->prev->origin;
+		const Point centre = weighted
+			? PowerCentre(a->point, Diagram.Sites[a->index - 1]->weight, b->point, Diagram.Sites[b->index - 1]->weight,
+				c->point, Diagram.Sites[c->index - 1]->weight)
+			: Circumcentre(a->point, b->point, c->point);
+		if (!std::isfinite(centre.x) || !std::isfinite(centre.y))
+			return false;
+		Centres[i] = centre;
+		minX = std::min(minX, centre.x);
+		minY = std::min(minY, centre.y);
+		maxX = std::max(maxX, centre.x);
+		maxY = std::max(maxY, centre.y);
+	}
+
+	auto root = [this](size_t i)
+	{
+		while (Parent[i] != i)
+		{
+			Parent[i] = Parent[Parent[i]];
+			i = Parent[i];
+		}
+		return i;
+	};
+	const Real extent = std::max({ Real(1), Diagram.MaxX - Diagram.MinX, Diagram.MaxY - Diagram.MinY });
+	const Real snap = Real(64) * std::numeric_limits<Real>::epsilon() * extent;
+	for (const HalfEdge* delaunay : Diagram.TriangulationHalfEdges)
+	{
+		if (delaunay->incidentFace == Outside || delaunay->twin->incidentFace == Outside)
+			continue;
+		const size_t left = root(size_t(delaunay->incidentFace->index - 1));
+		const size_t right = root(size_t(delaunay->twin->incidentFace->index - 1));
+		if (left != right && std::abs(Centres[left].x - Centres[right].x) <= snap && std::abs(Centres[left].y - Centres[right].y) <= snap)
+			Parent[left] = right;
+	}
+
+	// Rays leave through the box in the order of the hull
+	SetBox(minX, minY, maxX, maxY);
+	Exits.resize(Hull.size(), Point(0, 0));
+	size_t descents = 0;
+	for (size_t k = 0; k < Hull.size(); k++)
+	{
+		const HalfEdge* hullEdge = Hull[k];
+		const Point& from = Centres[root(size_t(hullEdge->incidentFace->index - 1))];
+		const Real dx = hullEdge->dest->point.y - hullEdge->origin->point.y;
+		const Real dy = hullEdge->origin->point.x - hullEdge->dest->point.x;
+		if (!ExitBox(from, dx, dy, Exits[k]))
+			return false;
+
+		if (k > 0 && !(Along(Exits[k - 1]) < Along(Exits[k])))
+			descents++;
+	}
+	if (!(Along(Exits.back()) < Along(Exits.front())))
+		descents++;
+	if (descents != 1)
+		return false;
+
+	// Everything checks out, from here on the diagram changes
+	TakeRecords();
+
+	CornerOf.assign(m, nullptr);
+	auto corner = [&](const Face* triangle) -> Vertex*
+	{
+		const size_t i = root(size_t(triangle->index - 1));
+		if (nullptr == CornerOf[i])
+			CornerOf[i] = NewVertex(Centres[i], false);
+		return CornerOf[i];
+	};
+	auto siteOf = [this](const Vertex* vertex) { return Diagram.Sites[vertex->index - 1]; };
+
+	// The Voronoi edge of every Delaunay half-edge, in the cell of its origin. A half-edge
+	// on the outside has its twin's.
+	auto slot = [](const HalfEdge* delaunay)
+	{
+		const HalfEdge* first = delaunay->incidentFace->outerComponent;
+		const size_t side = (delaunay == first) ? 0 : (delaunay == first->next) ? 1 : 2;
+		return 3 * size_t(delaunay->incidentFace->index - 1) + side;
+	};
+	Dual.assign(3 * m, nullptr);
+	for (size_t k = 0; k < Hull.size(); k++)
+	{
+		HalfEdge* hullEdge = Hull[k];
+		Dual[slot(hullEdge)] = NewPair(NewVertex(Exits[k], true), corner(hullEdge->incidentFace),
+			siteOf(hullEdge->origin)->face, siteOf(hullEdge->dest)->face);
+	}
+
+	for (size_t i = 0; i < Diagram.Sites.size(); i++)
+	{
+		VoronoiSite* site = Diagram.Sites[i];
+		Loop.clear();
+		if (nullptr == Starts[i])
+		{
+			site->face->outerComponent = nullptr;
+			continue;
+		}
+
+		HalfEdge* spoke = Starts[i];
+		do
+		{
+			HalfEdge* voronoi = nullptr;
+			if (spoke->incidentFace == Outside)
+			{
+				voronoi = Dual[slot(spoke->twin)]->twin;
+			}
+			else if (spoke->twin->incidentFace != Outside && Dual[slot(spoke->twin)])
+			{
+				voronoi = Dual[slot(spoke->twin)]->twin;
+			}
+			else if (Dual[slot(spoke)])
+			{
+				voronoi = Dual[slot(spoke)];
+			}
+			else
+			{
+				Vertex* from = corner(spoke->twin->incidentFace);
+				Vertex* to = corner(spoke->incidentFace);
+				if (from != to)
+				{
+					voronoi = NewPair(from, to, site->face, siteOf(spoke->dest)->face);
+					Dual[slot(spoke)] = voronoi;
+				}
+			}
+			if (voronoi)
+				Loop.push_back(voronoi);
+			spoke = spoke->prev->twin;
+		} while (spoke != Starts[i]);
+
+		// A hull cell runs counterclockwise along the box from its last ray to its first
+		if (Starts[i]->twin->incidentFace == Outside)
+			CloseAlongBox(Loop.back()->dest, Loop.front()->origin, site->face, unbounded);
+		LinkLoop(site);
+	}
+
+	LinkOutside(unbounded);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// With d the direction of the chain, the edge between neighbours a and b crosses it at
+// a + s (b - a) where s = 1/2 + (wa - wb) / (2 |b - a|^2), and runs along the normal n.
+// The cell of chain site i is then Q(i) to P(i) on its right edge, the box counterclockwise
+// to P(i - 1), P(i - 1) to Q(i - 1) on its left edge and the box back to Q(i), where P is
+// where an edge leaves the box along n and Q along -n.
+template<typename T>
+bool BasicDualCells<T>::BuildStrips(const std::vector<Vertex*>& chain, bool weighted)
+{
+	if (chain.empty())
+		return false;
+	if (Diagram.Faces.empty() || !Diagram.Faces.back()->Unbounded)
+		return false;
+	Face* unbounded = Diagram.Faces.back();
+	for (const VoronoiSite* site : Diagram.Sites)
+	{
+		if (nullptr == site->face)
+			return false;
+	}
+
+	const size_t k = chain.size();
+	const Real nx = chain.front()->point.y - chain.back()->point.y;
+	const Real ny = chain.back()->point.x - chain.front()->point.x;
+	auto weightOf = [&](const Vertex* vertex) { return weighted ? Diagram.Sites[vertex->index - 1]->weight : Real(0); };
+
+	Centres.resize(k > 1 ? k - 1 : 0, Point(0, 0));
+	Real minX = Diagram.MinX, minY = Diagram.MinY, maxX = Diagram.MaxX, maxY = Diagram.MaxY;
+	for (size_t j = 0; j + 1 < k; j++)
+	{
+		const Point& a = chain[j]->point;
+		const Point& b = chain[j + 1]->point;
+		const Real bx = b.x - a.x, by = b.y - a.y;
+		const Real s = Real(0.5) + (weightOf(chain[j]) - weightOf(chain[j + 1])) / (Real(2) * (bx * bx + by * by));
+		Centres[j] = Point(a.x + s * bx, a.y + s * by);
+		if (!std::isfinite(Centres[j].x) || !std::isfinite(Centres[j].y))
+			return false;
+		minX = std::min(minX, Centres[j].x);
+		minY = std::min(minY, Centres[j].y);
+		maxX = std::max(maxX, Centres[j].x);
+		maxY = std::max(maxY, Centres[j].y);
+	}
+	SetBox(minX, minY, maxX, maxY);
+
+	Exits.resize(2 * Centres.size(), Point(0, 0));
+	for (size_t j = 0; j < Centres.size(); j++)
+	{
+		if (!ExitBox(Centres[j], nx, ny, Exits[2 * j]) || !ExitBox(Centres[j], -nx, -ny, Exits[2 * j + 1]))
+			return false;
+	}
+
+	// Everything checks out, from here on the diagram changes
+	TakeRecords();
+
+	// Each edge runs Q to P in the cell of the chain site before it
+	Dual.assign(Centres.size(), nullptr);
+	for (size_t j = 0; j < Centres.size(); j++)
+	{
+		Dual[j] = NewPair(NewVertex(Exits[2 * j + 1], true), NewVertex(Exits[2 * j], true),
+			Diagram.Sites[chain[j]->index - 1]->face, Diagram.Sites[chain[j + 1]->index - 1]->face);
+	}
+
+	for (VoronoiSite* site : Diagram.Sites)
+		site->face->outerComponent = nullptr;
+	for (size_t i = 0; i < k; i++)
+	{
+		VoronoiSite* site = Diagram.Sites[chain[i]->index - 1];
+		Loop.clear();
+		if (1 == k)
+		{
+			// A single cell is the whole box
+			Vertex* start = NewVertex(Point(MinX, MinY), true);
+			CloseAlongBox(start, start, site->face, unbounded);
+		}
+		else if (0 == i)
+		{
+			Loop.push_back(Dual[0]);
+			CloseAlongBox(Dual[0]->dest, Dual[0]->origin, site->face, unbounded);
+		}
+		else if (k - 1 == i)
+		{
+			Loop.push_back(Dual[i - 1]->twin);
+			CloseAlongBox(Dual[i - 1]->origin, Dual[i - 1]->dest, site->face, unbounded);
+		}
+		else
+		{
+			Loop.push_back(Dual[i]);
+			CloseAlongBox(Dual[i]->dest, Dual[i - 1]->dest, site->face, unbounded);
+			Loop.push_back(Dual[i - 1]->twin);
+			CloseAlongBox(Dual[i - 1]->origin, Dual[i]->origin, site->face, unbounded);
+		}
+		LinkLoop(site);
+	}
+
+	LinkOutside(unbounded);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// The ray between hull sites a and b leaves along (b - a) turned clockwise, and the cell
+// of b runs in along the ray, counterclockwise along the box and out along the next ray.
+template<typename T>
+bool BasicDualCells<T>::CloseRays(const std::vector<HalfEdge*>& rays, Real minX, Real minY, Real maxX, Real maxY, Face* unbounded)
+{
+	if (rays.size() < 3 || nullptr == unbounded)
+		return false;
+
+	SetBox(minX, minY, maxX, maxY);
+	Exits.resize(rays.size(), Point(0, 0));
+	size_t descents = 0;
+	for (size_t k = 0; k < rays.size(); k++)
+	{
+		const HalfEdge* ray = rays[k];
+		const HalfEdge* next = rays[(k + 1) % rays.size()];
+		if (nullptr != ray->origin || nullptr == ray->dest || ray->twin->incidentFace != next->incidentFace)
+			return false;
+
+		const Point& before = ray->incidentFace->site->point;
+		const Point& after = ray->twin->incidentFace->site->point;
+		if (!ExitBox(ray->dest->point, after.y - before.y, before.x - after.x, Exits[k]))
+			return false;
+
+		if (k > 0 && !(Along(Exits[k - 1]) < Along(Exits[k])))
+			descents++;
+	}
+	if (!(Along(Exits.back()) < Along(Exits.front())))
+		descents++;
+	if (descents != 1)
+		return false;
+
+	// Everything checks out, from here on the diagram changes. The diagram has no box yet,
+	// so its vertices are numbered from one.
+	SpareVertices.clear();
+	SpareEdges.clear();
+	VoronoiIndex = BoxIndex = 0;
+	Box.clear();
+	for (size_t k = 0; k < rays.size(); k++)
+	{
+		Vertex* exit = NewVertex(Exits[k], true);
+		rays[k]->origin = exit;
+		rays[k]->twin->dest = exit;
+	}
+
+	for (size_t k = 0; k < rays.size(); k++)
+	{
+		HalfEdge* in = rays[k]->twin;
+		HalfEdge* out = rays[(k + 1) % rays.size()];
+		Loop.clear();
+		CloseAlongBox(in->dest, out->origin, in->incidentFace, unbounded);
+
+		in->next = Loop.front();
+		Loop.front()->prev = in;
+		for (size_t j = 0; j < Loop.size(); j++)
+		{
+			HalfEdge* next = (j + 1 < Loop.size()) ? Loop[j + 1] : out;
+			Loop[j]->next = next;
+			next->prev = Loop[j];
+			Loop[j]->origin->incidentEdge = Loop[j];
+		}
+		if (nullptr == in->incidentFace->outerComponent)
+			in->incidentFace->outerComponent = in;
+	}
+
+	LinkOutside(unbounded);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// The sweep's margin is kept about everything the cells reach
+template<typename T>
+void BasicDualCells<T>::SetBox(Real minX, Real minY, Real maxX, Real maxY)
+{
+	MinX = minX - Real(BoxMargin);
+	MinY = minY - Real(BoxMargin);
+	MaxX = maxX + Real(BoxMargin);
+	MaxY = maxY + Real(BoxMargin);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicDualCells<T>::Real BasicDualCells<T>::Along(const Point& point) const
+{
+	const Real width = MaxX - MinX, height = MaxY - MinY;
+	if (point.y == MinY)
+		return point.x - MinX;
+	if (point.x == MaxX)
+		return width + (point.y - MinY);
+	if (point.y == MaxY)
+		return width + height + (MaxX - point.x);
+	return width + width + height + (MaxY - point.y);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+bool BasicDualCells<T>::ExitBox(const Point& from, Real dx, Real dy, Point& exit) const
+{
+	const Real max = std::numeric_limits<Real>::max();
+	const Real tx = (dx > 0) ? (MaxX - from.x) / dx : (dx < 0) ? (MinX - from.x) / dx : max;
+	const Real ty = (dy > 0) ? (MaxY - from.y) / dy : (dy < 0) ? (MinY - from.y) / dy : max;
+	if (tx < ty)
+		exit = Point(dx > 0 ? MaxX : MinX, std::min(std::max(from.y + tx * dy, MinY), MaxY));
+	else if (ty < max)
+		exit = Point(std::min(std::max(from.x + ty * dx, MinX), MaxX), dy > 0 ? MaxY : MinY);
+	else
+		return false;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicDualCells<T>::TakeRecords()
+{
+	SpareVertices.clear();
+	SpareEdges.clear();
+	SpareVertices.swap(Diagram.Vertices);
+	SpareEdges.swap(Diagram.HalfEdges);
+	Diagram.Vertices.reserve(SpareVertices.size());
+	Diagram.HalfEdges.reserve(SpareEdges.size());
+	VoronoiIndex = BoxIndex = 0;
+	Box.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicDualCells<T>::Vertex* BasicDualCells<T>::NewVertex(const Point& point, bool box)
+{
+	Vertex* vertex = nullptr;
+	if (SpareVertices.empty())
+	{
+		vertex = Diagram.NewVertex({ 0, point, nullptr });
+	}
+	else
+	{
+		vertex = SpareVertices.back();
+		SpareVertices.pop_back();
+	}
+	*vertex = Vertex({ box ? ++BoxIndex : ++VoronoiIndex, point, nullptr, box });
+	Diagram.Vertices.push_back(vertex);
+	return vertex;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicDualCells<T>::HalfEdge* BasicDualCells<T>::NewPair(Vertex* origin, Vertex* dest, Face* left, Face* right)
+{
+	auto newEdge = [this](Vertex* from, Vertex* to, Face* face) -> HalfEdge*
+	{
+		HalfEdge* halfEdge = nullptr;
+		if (SpareEdges.empty())
+		{
+			halfEdge = Diagram.NewHalfEdge(HalfEdge());
+		}
+		else
+		{
+			halfEdge = SpareEdges.back();
+			SpareEdges.pop_back();
+		}
+		*halfEdge = HalfEdge({ from, to, nullptr, face, nullptr, nullptr });
+		Diagram.HalfEdges.push_back(halfEdge);
+		return halfEdge;
+	};
+
+	HalfEdge* halfEdge = newEdge(origin, dest, left);
+	halfEdge->twin = newEdge(dest, origin, right);
+	halfEdge->twin->twin = halfEdge;
+	return halfEdge;
+}
+
+////////////////////////////////////////////////////////////////////
+// A run that starts where it ends goes all the way round
+template<typename T>
+void BasicDualCells<T>::CloseAlongBox(Vertex* at, Vertex* end, Face* face, Face* unbounded)
+{
+	const Point corners[4] = { Point(MinX, MinY), Point(MaxX, MinY), Point(MaxX, MaxY), Point(MinX, MaxY) };
+	const Real perimeter = Real(2) * (MaxX - MinX) + Real(2) * (MaxY - MinY);
+	const Real begin = Along(at->point);
+	auto ahead = [&](const Point& point)
+	{
+		const Real distance = Along(point) - begin;
+		return (distance < 0) ? distance + perimeter : distance;
+	};
+	const Real last = (at == end) ? perimeter : ahead(end->point);
+
+	int order[4] = { 0, 1, 2, 3 };
+	std::sort(order, order + 4, [&](int a, int b) { return ahead(corners[a]) < ahead(corners[b]); });
+	for (int c : order)
+	{
+		const Real distance = ahead(corners[c]);
+		if (distance <= 0 || distance >= last)
+			continue;
+		Vertex* boxCorner = NewVertex(corners[c], true);
+		Box.push_back(NewPair(at, boxCorner, face, unbounded));
+		Loop.push_back(Box.back());
+		at = boxCorner;
+	}
+	Box.push_back(NewPair(at, end, face, unbounded));
+	Loop.push_back(Box.back());
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicDualCells<T>::LinkLoop(VoronoiSite* site)
+{
+	for (size_t j = 0; j < Loop.size(); j++)
+	{
+		HalfEdge* next = Loop[(j + 1) % Loop.size()];
+		Loop[j]->next = next;
+		next->prev = Loop[j];
+		Loop[j]->origin->incidentEdge = Loop[j];
+	}
+	site->face->outerComponent = Loop.empty() ? nullptr : Loop.front();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicDualCells<T>::LinkOutside(Face* unbounded)
+{
+	// The outside of the box runs clockwise
+	std::sort(Box.begin(), Box.end(), [&](const HalfEdge* a, const HalfEdge* b) { return Along(a->origin->point) < Along(b->origin->point); });
+	for (size_t j = 0; j < Box.size(); j++)
+	{
+		HalfEdge* outer = Box[j]->twin;
+		outer->next = Box[(j + Box.size() - 1) % Box.size()]->twin;
+		outer->prev = Box[(j + 1) % Box.size()]->twin;
+	}
+	unbounded->outerComponent = nullptr;
+	unbounded->innerComponent = Box.empty() ? nullptr : Box.front()->twin;
+
+	for (Vertex* vertex : SpareVertices)
+		delete vertex;
+	for (HalfEdge* halfEdge : SpareEdges)
+		delete halfEdge;
+	SpareVertices.clear();
+	SpareEdges.clear();
+}
+
+template class BasicDualCells<float>;
+template class BasicDualCells<double>;
+template class BasicDualCells<int64_t>;
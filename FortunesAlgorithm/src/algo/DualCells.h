@@ -0,0 +1,90 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// Builds the cells of a diagram in place as the dual of its triangulation, one vertex per
+// triangle and a ray per hull edge out to the bounding box, reusing the records of the
+// cells it replaces. The vertex of a triangle is its circumcentre, or for weighted sites
+// the point of equal power from its corners, which makes the cells those of the power
+// diagram. A site with no vertex in the triangulation gets a cell with no boundary. The
+// working space is kept between builds.
+template<typename T>
+class BasicDualCells
+{
+public:
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	BasicDualCells(VoronoiDiagram& diagram);
+
+	// Parameters
+	//		outside  : the unbounded face of the triangulation, its loop running clockwise
+	//		           along the hull
+	//		weighted : place the vertices by the weights of the sites
+	// Returns false, having changed nothing, when the triangulation cannot give a diagram.
+	bool Build(Face* outside, bool weighted);
+
+	// Parameters
+	//		chain    : the vertices of sites on one line, in order along it, that keep a cell
+	//		weighted : place the edges by the weights of the sites
+	// The cells of sites on one line are strips between parallel edges across the box,
+	// each at the point of equal power of two neighbours on the chain. Sites off the chain
+	// get a cell with no boundary.
+	bool BuildStrips(const std::vector<Vertex*>& chain, bool weighted);
+
+	// Parameters
+	//		rays      : one Voronoi edge per hull edge, counterclockwise around the hull, each
+	//		            running in to its vertex from an origin not yet set, with the cell of
+	//		            the hull site before it on its left
+	//		minX..    : the extent of the sites and vertices the box is kept about
+	//		unbounded : the face outside the box
+	// Ends the rays at the box and closes the hull cells along it, for cells built up to
+	// their rays some other way. Returns false, having changed nothing, when the rays do not
+	// leave the box in the order of the hull.
+	bool CloseRays(const std::vector<HalfEdge*>& rays, Real minX, Real minY, Real maxX, Real maxY, Face* unbounded);
+
+private:
+	void SetBox(Real minX, Real minY, Real maxX, Real maxY);
+	// How far counterclockwise from the lower left corner the point is on the box
+	Real Along(const Point& point) const;
+	// Where the ray from the point in the direction dx, dy leaves the box
+	bool ExitBox(const Point& from, Real dx, Real dy, Point& exit) const;
+
+	// The records of the cells being replaced are reused before new ones are made
+	void TakeRecords();
+	Vertex* NewVertex(const Point& point, bool box);
+	HalfEdge* NewPair(Vertex* origin, Vertex* dest, Face* left, Face* right);
+	// Adds the box edges counterclockwise from at to end, and the corners between, to Loop
+	void CloseAlongBox(Vertex* at, Vertex* end, Face* face, Face* unbounded);
+	// Makes Loop the boundary of the site's cell
+	void LinkLoop(VoronoiSite* site);
+	// Links the outside of the box clockwise and deletes the records left over
+	void LinkOutside(Face* unbounded);
+
+	VoronoiDiagram& Diagram;
+	Face* Outside;
+
+	std::vector<Point> Centres;
+	std::vector<size_t> Parent;
+	std::vector<Vertex*> CornerOf;
+	std::vector<HalfEdge*> Hull;
+	std::vector<Point> Exits;
+	std::vector<HalfEdge*> Starts, Loop, Box;
+	// The Voronoi edge of each Delaunay half-edge, three to a triangle
+	std::vector<HalfEdge*> Dual;
+
+	Real MinX, MinY, MaxX, MaxY;
+	std::vector<Vertex*> SpareVertices;
+	std::vector<HalfEdge*> SpareEdges;
+	int VoronoiIndex, BoxIndex;
+};
+
+typedef BasicDualCells<double> DualCells;
@@ -1,33 +1,177 @@
 #include "FortunesAlgorithm.h"
 
+#include "BTreeBeachLine.h"
+#include "PowerDiagram.h"
+#include "Predicates.h"
+#include "RedBlackBeachLine.h"
+
 #include "../types/Point.h"
 #include "../types/VoronoiDiagram.h"
+#include "../utils/NoContraction.h"
 #include "../utils/PriorityQueue.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <limits>
+#include <unordered_set>
 
 using namespace BL;
 
 ////////////////////////////////////////////////////////////////////
-FortunesAlgorithm::FortunesAlgorithm(VoronoiDiagram& diagram)
+// Snapshots and step records are for the viewer, which draws in double
+template<typename Real>
+static ::Point ToDouble(const BasicPoint<Real>& point)
+{
+	return ::Point(double(point.x), double(point.y));
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicFortunesAlgorithm<T>::BasicFortunesAlgorithm(VoronoiDiagram& diagram, SweepAxis axis, BeachLineType beachLine)
 	: Diagram(diagram)
 	, Queue(new PriorityQueue())
-	, Root(nullptr)
+	, Beach(nullptr)
 	, FirstSite(nullptr)
-	, SweepHeight(DBL_MAX)
+	, SweepHeight(std::numeric_limits<Real>::max())
 	, Complete(false)
+	, Transposed(false)
+	, Weighted(false)
+	, PowerReport({ 0, 0, false })
 	, NumVoronoiSites(0)
 	, NumBoundingVertices(0)
-	, LastVistedVertex(nullptr)
+	, NumTriangles(0)
+	, NumArcs(0)
+	, Axis(axis)
+	, Verbose(true)
+	, RecentVertices()
+	, RecentHeight(std::numeric_limits<Real>::max())
+	, VertexSnap(0)
 	, InOrderArcs()
 	, CompletedEdges()
-	, MinX(DBL_MAX)
-	, MinY(DBL_MAX)
-	, MaxX(-DBL_MAX)
-	, MaxY(-DBL_MAX)
+	, UsedBisectors(0)
+	, UsedEdgePoints(0)
+	, MinX(std::numeric_limits<Real>::max())
+	, MinY(std::numeric_limits<Real>::max())
+	, MaxX(-std::numeric_limits<Real>::max())
+	, MaxY(-std::numeric_limits<Real>::max())
+{
+	if (BeachLineType::BTree == beachLine)
+		Beach = new BTreeBeachLine<T>();
+	else
+		Beach = new RedBlackBeachLine<T>();
+
+	Reset();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicFortunesAlgorithm<T>::~BasicFortunesAlgorithm()
 {
-	std::cout << "Number of sites: " << Diagram.Sites.size() << std::endl;
+	while (!Queue->IsEmpty())
+		DeleteEvent(Queue->Pop());
+	delete Queue;
+	delete Beach;
+	for (Bisector* bisector : Bisectors)
+		delete bisector;
+	for (Point* point : EdgePoints)
+		delete point;
+}
+
+////////////////////////////////////////////////////////////////////
+// A circle event owns the site that places it in the queue
+template<typename T>
+void BasicFortunesAlgorithm<T>::DeleteEvent(EventPoint* event)
+{
+	if (EventPointType::Circle == event->Type)
+		delete event->Site;
+	delete event;
+}
+
+////////////////////////////////////////////////////////////////////
+// Bisectors and edge points live until the next Reset, which hands them out again
+template<typename T>
+typename BasicFortunesAlgorithm<T>::Bisector* BasicFortunesAlgorithm<T>::NewBisector(Point* start, VoronoiSite* left, VoronoiSite* right)
+{
+	if (UsedBisectors == Bisectors.size())
+		Bisectors.push_back(new Bisector(start, left, right));
+	else
+		*Bisectors[UsedBisectors] = Bisector(start, left, right);
+	return Bisectors[UsedBisectors++];
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicFortunesAlgorithm<T>::Point* BasicFortunesAlgorithm<T>::NewEdgePoint(Real x, Real y)
+{
+	if (UsedEdgePoints == EdgePoints.size())
+		EdgePoints.push_back(new Point(x, y));
+	else
+		*EdgePoints[UsedEdgePoints] = Point(x, y);
+	return EdgePoints[UsedEdgePoints++];
+}
+
+////////////////////////////////////////////////////////////////////
+// Everything a sweep leaves behind is cleared in place, so the queue, the beach line
+// and the edge lists start the next sweep with the storage of the last one.
+template<typename T>
+void BasicFortunesAlgorithm<T>::Reset()
+{
+	// Events left over from a sweep that was stopped early
+	while (!Queue->IsEmpty())
+		DeleteEvent(Queue->Pop());
+	Beach->Clear();
+	// A sweep along X stopped early leaves the sites turned
+	if (Transposed && !Complete)
+	{
+		for (VoronoiSite* site : Diagram.Sites)
+			site->point = Point(-site->point.y, site->point.x);
+	}
+	Transposed = false;
+
+	FirstSite = nullptr;
+	SweepHeight = std::numeric_limits<Real>::max();
+	Complete = false;
+	NumVoronoiSites = 0;
+	NumBoundingVertices = 0;
+	NumTriangles = 0;
+	NumArcs = 0;
+	RecentVertices.clear();
+	RecentHeight = std::numeric_limits<Real>::max();
+	InOrderArcs.clear();
+	CompletedEdges.clear();
+	IniniteEdges.clear();
+	FirstRowEdges.clear();
+	UsedBisectors = 0;
+	UsedEdgePoints = 0;
+	MinX = MinY = std::numeric_limits<Real>::max();
+	MaxX = MaxY = -std::numeric_limits<Real>::max();
+
+	Diagram.ReserveCapacity();
+
+	// Snap a few ulps of the extent of the sites, enough to absorb the rounding between
+	// two circumcentres of co-circular sites
+	const Real extent = std::max({ Real(1), Diagram.MaxX - Diagram.MinX, Diagram.MaxY - Diagram.MinY });
+	VertexSnap = Real(64) * std::numeric_limits<Real>::epsilon() * extent;
+	Queue->Elements.reserve(Diagram.Sites.size());
+
+	Weighted = false;
+	for (const VoronoiSite* site : Diagram.Sites)
+		Weighted = Weighted || site->weight != 0;
+	PowerReport = { 0, 0, false };
+
+	// Sweeping along X is a Y sweep over the sites turned a quarter clockwise. Weighted
+	// sites are not swept by Run, so they are left as they are.
+	const SweepAxis axis = SweepAxis::Auto == Axis ? ChooseSweepAxis(Diagram.Sites) : Axis;
+	Transposed = !Weighted && SweepAxis::X == axis;
+	if (Transposed)
+	{
+		for (VoronoiSite* site : Diagram.Sites)
+		{
+			site->point = Point(site->point.y, -site->point.x);
+		}
+	}
+
 	for (VoronoiSite* site : Diagram.Sites)
 	{
 		Queue->Push(new EventPoint(site));
@@ -37,29 +181,96 @@ FortunesAlgorithm::FortunesAlgorithm(VoronoiDiagram& diagram)
 }
 
 ////////////////////////////////////////////////////////////////////
-FortunesAlgorithm::~FortunesAlgorithm()
+// The beach line is of the unweighted sites, so for weighted sites the power diagram is
+// built from their regular triangulation instead of a sweep. Should that fail the sites
+// are swept without their weights.
+template<typename T>
+void BasicFortunesAlgorithm<T>::Run()
 {
-	delete Queue;
+	if (Weighted)
+	{
+		PowerReport = ApplyWeights(Diagram);
+		if (PowerReport.Applied)
+		{
+			while (!Queue->IsEmpty())
+				DeleteEvent(Queue->Pop());
+			Diagram.CountReallocations();
+			Complete = true;
+			return;
+		}
+		Diagram.ClearDCEL();
+		Weighted = false;
+	}
+
+	while (!Queue->IsEmpty())
+	{
+		Next();
+	}
+
+	Finish();
 }
 
-void FortunesAlgorithm::Run()
+////////////////////////////////////////////////////////////////////
+// Drives the sweep one event at a time. Each live event is handled when the
+// consumer asks for the next record, and the diagram is finished once the
+// queue runs dry, so draining the generator is equivalent to Run().
+template<typename T>
+Generator<SweepEvent> BasicFortunesAlgorithm<T>::Steps()
 {
 	while (!Queue->IsEmpty())
 	{
+		EventPoint* top = Queue->Peek();
+		if (EventPointType::Circle == top->Type && top->Deleted)
+		{
+			Next();
+			continue;
+		}
+
+		SweepEvent event = { top->Type, ToDouble(top->Site->point), double(top->Site->point.y), 0, 0, 0, 0, 0 };
+		if (EventPointType::Circle == top->Type)
+			event.Location.y += double(top->Radius);
+
+		const int arcs = NumArcs;
+		const size_t vertices = Diagram.Vertices.size();
+		const size_t halfEdges = Diagram.HalfEdges.size();
+		const size_t triangles = Diagram.TriangulationFaces.size();
+
 		Next();
+
+		event.ArcsCreated = std::max(0, NumArcs - arcs);
+		event.ArcsRemoved = std::max(0, arcs - NumArcs);
+		event.VerticesAdded = Diagram.Vertices.size() - vertices;
+		event.HalfEdgesAdded = Diagram.HalfEdges.size() - halfEdges;
+		event.TrianglesAdded = Diagram.TriangulationFaces.size() - triangles;
+		co_yield event;
 	}
 
+	if (!Complete)
+		Finish();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicFortunesAlgorithm<T>::Finish()
+{
 	CleanZeroLengthEdges();
 	CleanRemainingTree();
 	FillOuterEdgesIncidentFaces();
-
+	if (Transposed)
+		RestoreSweepAxis();
+	// The beach line is of the unweighted sites, weights are applied to the result
+	if (Weighted)
+		PowerReport = ApplyWeights(Diagram);
+
+	Diagram.CountReallocations();
+	Diagram.InvalidateMetrics();
 	Complete = true;
-	std::cout << std::endl;
 }
 
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::Continues(double height)
+template<typename T>
+void BasicFortunesAlgorithm<T>::Continues(Real height)
 {
 	if (!Queue->IsEmpty() && height - Queue->Peek()->Site->point.y < -0.005)
 	{
@@ -69,7 +280,57 @@ void FortunesAlgorithm::Continues(double height)
 
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::Next()
+// Processes every event strictly above the given height in one call and leaves
+// the rest of the queue and the beach line untouched, so the sweep can be
+// resumed later or its partial state inspected.
+// Parameters
+//		height     : the sweep line stops above this height
+//		maxEvents  : stop after this many events, 0 for no limit
+//		maxSeconds : stop once this much time has passed, 0 for no limit
+// Returns the number of live events still waiting above the height, 0 once it is reached.
+template<typename T>
+size_t BasicFortunesAlgorithm<T>::AdvanceTo(Real height, size_t maxEvents, double maxSeconds)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t processed = 0;
+
+	while (!Queue->IsEmpty() && Queue->Peek()->Site->point.y > height)
+	{
+		if (maxEvents != 0 && processed >= maxEvents)
+			break;
+		if (maxSeconds > 0.0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= maxSeconds)
+			break;
+
+		Next();
+		processed++;
+	}
+
+	if (Queue->IsEmpty() || Queue->Peek()->Site->point.y <= height)
+		return 0;
+
+	// The queue is ordered by height first, so only the events above the height and
+	// their children are visited
+	size_t remaining = 0;
+	std::vector<size_t> stack(1, 0);
+	while (!stack.empty())
+	{
+		const size_t i = stack.back();
+		stack.pop_back();
+		const EventPoint* e = Queue->Elements[i];
+		if (e->Site->point.y <= height)
+			continue;
+		if (!e->Deleted)
+			remaining++;
+		for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < Queue->Elements.size(); child++)
+			stack.push_back(child);
+	}
+	return remaining;
+}
+
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicFortunesAlgorithm<T>::Next()
 {
 	if (Queue->IsEmpty())
 	{
@@ -88,195 +349,173 @@ void FortunesAlgorithm::Next()
 	{
 		HandleCircleEvent(top);
 	}
-	delete top;
+	DeleteEvent(top);
 }
 
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::HandleSiteEvent(EventPoint* site)
+template<typename T>
+void BasicFortunesAlgorithm<T>::HandleSiteEvent(EventPoint* site)
 {
 	// Maintain Records
 	UpdateBounds(site->Site->point);
-	site->Site->face = new DCEL::Face({ site->Site, nullptr, nullptr });
+	site->Site->face = Diagram.NewFace({ site->Site, nullptr, nullptr, false, 0 });
 	Diagram.Faces.push_back(site->Site->face);
-	Diagram.TriangulationVertices.push_back(new DCEL::Vertex({ site->Site->index, site->Site->point, nullptr }));
-	DCEL::Vertex* triV = Diagram.TriangulationVertices.back();
+	Diagram.TriangulationVertices.push_back(Diagram.NewVertex({ site->Site->index, site->Site->point, nullptr }));
+	Vertex* triV = Diagram.TriangulationVertices.back();
 	site->Site->triVertex = triV;
 
-	if (nullptr == Root) { Root = new Arc(site->Site); FirstSite = Root->Site; return; };
+	if (Beach->IsEmpty()) { Beach->Start(site->Site); FirstSite = site->Site; NumArcs++; return; };
 
 	Point& p = site->Site->point;
-	Arc* a = FindArcAtX(p.x);
+	ArcRef a = Beach->FindArcAtX(p.x, SweepHeight);
+	VoronoiSite* aSite = Beach->Site(a);
 
-	if (FirstSite->point.y - site->Site->point.y < .1)
+	// Sites level with the first site only have the first row of arcs above them, whose
+	// parabolas are still vertical rays, so the new arc is simply placed beside them
+	if (FirstSite->point.y == site->Site->point.y)
 	{
-		double middle = (site->Site->point.x + a->Site->point.x) / 2.0;
-		Point* start = new Point({ middle, SweepHeight });
+		Real middle = (site->Site->point.x + aSite->point.x) / 2.0;
+		Point* start = NewEdgePoint(middle, SweepHeight);
 
-		if (a->Site->point.x < site->Site->point.x)
-		{
-			a->Edge = new Edge(start, a->Site, site->Site);
-			a->Edge->Neighbour = new Edge(start, site->Site, a->Site);
-			a->Edge->Neighbour->Neighbour = a->Edge;
-			a->SetLeft(new Arc(a->Site));
-			a->SetRight(new Arc(site->Site));
-		}
-		else
-		{
-			a->Edge = new Edge(start, site->Site, a->Site);
-			a->Edge->Neighbour = new Edge(start, site->Site, a->Site);
-			a->Edge->Neighbour->Neighbour = a->Edge;
-			a->SetRight(new Arc(site->Site));
-			a->SetRight(new Arc(a->Site));
-		}
+		VoronoiSite* leftSite = (aSite->point.x < site->Site->point.x) ? aSite : site->Site;
+		VoronoiSite* rightSite = (aSite->point.x < site->Site->point.x) ? site->Site : aSite;
 
-		a->Leaf = false;
-		if (a != Root) a->Color = Arc::TreeColor::Red;
+		ArcRef leftArc, rightArc;
+		const Edge edge(NewBisector(start, leftSite, rightSite), false);
+		Beach->SplitArc(a, leftSite, rightSite, edge, leftArc, rightArc);
+		FirstRowEdges.push_back(edge);
+		NumArcs++;
 
-		FixRedBlackPropertiesAfterInsert(a);
 		PrintTree();
 		return;
 	}
 
-	if (nullptr != a->CircleEvent)
+	if (nullptr != Beach->CircleEvent(a))
 	{
-		a->CircleEvent->Deleted = true;
-		a->CircleEvent = nullptr;
+		Beach->CircleEvent(a)->Deleted = true;
+		Beach->SetCircleEvent(a, nullptr);
 	}
 
-	Point* edgeStart = new Point(p.x, CalculateParabolaY(p.x, SweepHeight, a->Site->point));
-	Edge* el = new Edge(edgeStart, a->Site, site->Site);
-	Edge* er = new Edge(edgeStart, site->Site, a->Site);
-
-	el->Neighbour = er;
-	er->Neighbour = el;
-
-	a->Edge = er;
-	a->Leaf = false;
-	a->Color = Arc::TreeColor::Red;
-
-	Arc* pl = new Arc(a->Site);
-	Arc* pm = new Arc(site->Site);
-	Arc* pr = new Arc(a->Site);
-
-	Arc* elArc = new Arc(el);
+	Point* edgeStart = NewEdgePoint(p.x, CalculateParabolaY(p.x, SweepHeight, aSite->point));
+	Bisector* bisector = NewBisector(edgeStart, aSite, site->Site);
+	Edge el(bisector, false);
+	Edge er(bisector, true);
 
-	a->SetRight(pr);
-	a->SetLeft(elArc);
+	ArcRef pl, pm, pr;
+	Beach->InsertArc(a, site->Site, el, er, pl, pm, pr);
+	NumArcs += 2;
 
-	elArc->SetLeft(pl);
-	elArc->SetRight(pm);
-
-	CheckForCircleEvent(pl, true);
-	CheckForCircleEvent(pr, true);
-	
-	// Balance (elArc)
-	FixRedBlackPropertiesAfterInsert(a);
-	FixRedBlackPropertiesAfterInsert(elArc);
+	CheckForCircleEvent(pl);
+	CheckForCircleEvent(pr);
 
 	PrintTree();
-	std::cout << std::endl;
+	if (Verbose)
+		std::cout << std::endl;
 }
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::HandleCircleEvent(EventPoint* site)
+template<typename T>
+void BasicFortunesAlgorithm<T>::HandleCircleEvent(EventPoint* site)
 {
-	Arc* arc = site->Arc;
+	ArcRef arc = site->Arc;
+
+	Edge leftBreakpoint = Beach->LeftBreakpoint(arc);
+	Edge rightBreakpoint = Beach->RightBreakpoint(arc);
 
-	Arc* leftEdge = GetLeftParent(arc);
-	Arc* rightEdge = GetRightParent(arc);
+	if (leftBreakpoint.IsNull() || rightBreakpoint.IsNull()) return;
 
-	if (nullptr == leftEdge || nullptr == rightEdge) return;
+	ArcRef leftArc = Beach->LeftArc(arc);
+	ArcRef rightArc = Beach->RightArc(arc);
 
-	Arc* leftArc = GetClosestLeftChild(leftEdge);
-	Arc* rightArc = GetClosestRightChild(rightEdge);
+	VoronoiSite* arcSite = Beach->Site(arc);
+	VoronoiSite* leftSite = Beach->Site(leftArc);
+	VoronoiSite* rightSite = Beach->Site(rightArc);
 
-	if (nullptr != leftArc->CircleEvent && leftArc->CircleEvent->Site->point != site->Site->point)
+	// A neighbour's event stays when its circle is this one, which happens when four
+	// or more sites are co-circular and the vertex is shared
+	EventPoint* leftEvent = Beach->CircleEvent(leftArc);
+	if (nullptr != leftEvent && !IsSameCircle(Beach->LeftArc(leftArc), leftArc, arc, rightArc))
 	{ 
-		leftArc->CircleEvent->Deleted = true; 
-		leftArc->CircleEvent = nullptr;
+		leftEvent->Deleted = true; 
+		Beach->SetCircleEvent(leftArc, nullptr);
 	}
 
-	if (nullptr != rightArc->CircleEvent && rightArc->CircleEvent->Site->point != site->Site->point)
+	EventPoint* rightEvent = Beach->CircleEvent(rightArc);
+	if (nullptr != rightEvent && !IsSameCircle(leftArc, arc, rightArc, Beach->RightArc(rightArc)))
 	{
-		rightArc->CircleEvent->Deleted = true;
-		rightArc->CircleEvent = nullptr;
+		rightEvent->Deleted = true;
+		Beach->SetCircleEvent(rightArc, nullptr);
 	}
 
-	Point* vertex = new Point(site->Site->point.x, site->Site->point.y + site->Radius);
-	leftEdge->Edge->End = vertex;
-	rightEdge->Edge->End = vertex;
+	Point* vertex = NewEdgePoint(site->Site->point.x, site->Site->point.y + site->Radius);
+	leftBreakpoint.End() = vertex;
+	rightBreakpoint.End() = vertex;
 
-	CompletedEdges.push_back(leftEdge->Edge);
-	CompletedEdges.push_back(rightEdge->Edge);
+	CompletedEdges.push_back(leftBreakpoint);
+	CompletedEdges.push_back(rightBreakpoint);
 
 	//Maintain records
 	UpdateBounds(*vertex);
-	if(LastVistedVertex == nullptr || LastVistedVertex->point.x != vertex->x || LastVistedVertex->point.y != vertex->y)
-	{ 
-		Diagram.Vertices.emplace_back(new DCEL::Vertex({ ++NumVoronoiSites, *vertex, nullptr }));
-		LastVistedVertex = Diagram.Vertices.back();
-	}
+	Vertex* voronoiVertex = FindOrAddVertex(*vertex, leftSite, arcSite, rightSite);
 
 
-	DCEL::HalfEdge* vNv1 = nullptr;
-	DCEL::HalfEdge* v1vN = nullptr;
-	DCEL::HalfEdge* vNv2 = nullptr;
-	DCEL::HalfEdge* v2vN = nullptr;
+	HalfEdge* vNv1 = nullptr;
+	HalfEdge* v1vN = nullptr;
+	HalfEdge* vNv2 = nullptr;
+	HalfEdge* v2vN = nullptr;
 
-	Edge* newEdge = new Edge(vertex, leftArc->Site, rightArc->Site);
+	Edge newEdge(NewBisector(vertex, leftSite, rightSite), false);
 
-	if (nullptr == leftEdge->Edge->HalfEdge)
+	if (nullptr == leftBreakpoint.HalfEdge())
 	{
-		vNv1 = new DCEL::HalfEdge({ Diagram.Vertices.back(), nullptr, nullptr, nullptr, nullptr, nullptr });
-		v1vN = new DCEL::HalfEdge({ nullptr, Diagram.Vertices.back(),    vNv1, nullptr, nullptr, nullptr });
+		vNv1 = Diagram.NewHalfEdge({ voronoiVertex, nullptr, nullptr, nullptr, nullptr, nullptr });
+		v1vN = Diagram.NewHalfEdge({ nullptr, voronoiVertex,    vNv1, nullptr, nullptr, nullptr });
 		vNv1->twin = v1vN;
-		vNv1->incidentFace = leftEdge->Edge->Left->face;
+		vNv1->incidentFace = leftBreakpoint.Left()->face;
 		if (nullptr == vNv1->incidentFace->outerComponent) vNv1->incidentFace->outerComponent = vNv1;
-		v1vN->incidentFace = leftEdge->Edge->Right->face;
+		v1vN->incidentFace = leftBreakpoint.Right()->face;
 		if (nullptr == v1vN->incidentFace->outerComponent) v1vN->incidentFace->outerComponent = v1vN;
 
-		leftEdge->Edge->HalfEdge = vNv1;
-		leftEdge->Edge->Neighbour->HalfEdge = v1vN;
+		leftBreakpoint.SetHalfEdge(vNv1);
 		Diagram.HalfEdges.emplace_back(vNv1);
 		Diagram.HalfEdges.emplace_back(v1vN);
 	}
 	else {
-		vNv1 = leftEdge->Edge->HalfEdge;
+		vNv1 = leftBreakpoint.HalfEdge();
 		v1vN = vNv1->twin;
-		vNv1->origin = Diagram.Vertices.back();
-		v1vN->dest = Diagram.Vertices.back();
+		vNv1->origin = voronoiVertex;
+		v1vN->dest = voronoiVertex;
 	}
 
-	if (nullptr == rightEdge->Edge->HalfEdge)
+	if (nullptr == rightBreakpoint.HalfEdge())
 	{
-		vNv2 = new DCEL::HalfEdge({ Diagram.Vertices.back(), nullptr, nullptr, nullptr, nullptr, nullptr });
-		v2vN = new DCEL::HalfEdge({ nullptr, Diagram.Vertices.back(),    vNv2, nullptr, nullptr, nullptr });
+		vNv2 = Diagram.NewHalfEdge({ voronoiVertex, nullptr, nullptr, nullptr, nullptr, nullptr });
+		v2vN = Diagram.NewHalfEdge({ nullptr, voronoiVertex,    vNv2, nullptr, nullptr, nullptr });
 		vNv2->twin = v2vN;
-		vNv2->incidentFace = rightEdge->Edge->Left->face;
+		vNv2->incidentFace = rightBreakpoint.Left()->face;
 		if (nullptr == vNv2->incidentFace->outerComponent) vNv2->incidentFace->outerComponent = vNv2;
-		v2vN->incidentFace = rightEdge->Edge->Right->face;
+		v2vN->incidentFace = rightBreakpoint.Right()->face;
 		if (nullptr == v2vN->incidentFace->outerComponent) v2vN->incidentFace->outerComponent = v2vN;
 
-		rightEdge->Edge->HalfEdge = vNv2;
-		rightEdge->Edge->Neighbour->HalfEdge = v2vN;
+		rightBreakpoint.SetHalfEdge(vNv2);
 		Diagram.HalfEdges.emplace_back(vNv2);
 		Diagram.HalfEdges.emplace_back(v2vN);
 	}
 	else {
-		vNv2 = rightEdge->Edge->HalfEdge;
+		vNv2 = rightBreakpoint.HalfEdge();
 		v2vN = vNv2->twin;
-		vNv2->origin = Diagram.Vertices.back();
-		v2vN->dest = Diagram.Vertices.back();
+		vNv2->origin = voronoiVertex;
+		v2vN->dest = voronoiVertex;
 	}
 
-	DCEL::HalfEdge* vNv3 = new DCEL::HalfEdge({ Diagram.Vertices.back(), nullptr, nullptr, nullptr, nullptr, nullptr });
-	DCEL::HalfEdge* v3vN = new DCEL::HalfEdge({ nullptr, Diagram.Vertices.back(),    vNv3, nullptr, nullptr, nullptr });
+	HalfEdge* vNv3 = Diagram.NewHalfEdge({ voronoiVertex, nullptr, nullptr, nullptr, nullptr, nullptr });
+	HalfEdge* v3vN = Diagram.NewHalfEdge({ nullptr, voronoiVertex,    vNv3, nullptr, nullptr, nullptr });
 	vNv3->twin = v3vN;
-	newEdge->HalfEdge = v3vN;
-	vNv3->incidentFace = rightEdge->Edge->Right->face;
+	newEdge.SetHalfEdge(v3vN);
+	vNv3->incidentFace = rightBreakpoint.Right()->face;
 	if (nullptr == vNv3->incidentFace->outerComponent) vNv3->incidentFace->outerComponent = vNv3;
-	v3vN->incidentFace = leftEdge->Edge->Left->face;
+	v3vN->incidentFace = leftBreakpoint.Left()->face;
 	if (nullptr == v3vN->incidentFace->outerComponent) v3vN->incidentFace->outerComponent = v3vN;
 
 	v1vN->next = vNv2;
@@ -304,17 +543,17 @@ void FortunesAlgorithm::HandleCircleEvent(EventPoint* site)
 
 	// Delany
 	// Test for test turn
-	bool leftTurn = ((rightArc->Site->triVertex->point.x - arc->Site->triVertex->point.x) * (leftArc->Site->triVertex->point.y - rightArc->Site->triVertex->point.y)
-		- (rightArc->Site->triVertex->point.y - arc->Site->triVertex->point.y) * (leftArc->Site->triVertex->point.x - rightArc->Site->triVertex->point.x) > 0);
+	bool leftTurn = ((rightSite->triVertex->point.x - arcSite->triVertex->point.x) * (leftSite->triVertex->point.y - rightSite->triVertex->point.y)
+		- (rightSite->triVertex->point.y - arcSite->triVertex->point.y) * (leftSite->triVertex->point.x - rightSite->triVertex->point.x) > 0);
 
-	DCEL::Vertex* v1 = (leftTurn) ? rightArc->Site->triVertex : leftArc->Site->triVertex;
-	DCEL::Vertex* v2 = (leftTurn) ? leftArc->Site->triVertex : rightArc->Site->triVertex;
+	Vertex* v1 = (leftTurn) ? rightSite->triVertex : leftSite->triVertex;
+	Vertex* v2 = (leftTurn) ? leftSite->triVertex : rightSite->triVertex;
 
-	DCEL::Face* tri = new DCEL::Face({nullptr, nullptr, nullptr, false, ++NumTriangles});
+	Face* tri = Diagram.NewFace({nullptr, nullptr, nullptr, false, ++NumTriangles});
 
-	DCEL::HalfEdge* e1 = new DCEL::HalfEdge({ arc->Site->triVertex, v1, nullptr, tri, nullptr, nullptr });
-	DCEL::HalfEdge* e2 = new DCEL::HalfEdge({ v1, v2, nullptr, tri, nullptr, e1 });
-	DCEL::HalfEdge* e3 = new DCEL::HalfEdge({ v2, arc->Site->triVertex, nullptr, tri, e1, e2 });
+	HalfEdge* e1 = Diagram.NewHalfEdge({ arcSite->triVertex, v1, nullptr, tri, nullptr, nullptr });
+	HalfEdge* e2 = Diagram.NewHalfEdge({ v1, v2, nullptr, tri, nullptr, e1 });
+	HalfEdge* e3 = Diagram.NewHalfEdge({ v2, arcSite->triVertex, nullptr, tri, e1, e2 });
 	e1->prev = e3;
 	e1->next = e2;
 	e2->next = e3;
@@ -330,124 +569,78 @@ void FortunesAlgorithm::HandleCircleEvent(EventPoint* site)
 
 	if (leftTurn)
 	{
-		e1->twin = rightEdge->Edge->TriHalfEdge;
+		e1->twin = rightBreakpoint.TriHalfEdge();
 		if (e1->twin != nullptr) e1->twin->twin = e1;
-		if (rightEdge->Edge->Neighbour != nullptr)  rightEdge->Edge->Neighbour->TriHalfEdge = e1;
+		rightBreakpoint.TriHalfEdge() = e1;
 
-		e3->twin = leftEdge->Edge->TriHalfEdge;
+		e3->twin = leftBreakpoint.TriHalfEdge();
 		if (e3->twin != nullptr) e3->twin->twin = e3;
-		if (leftEdge->Edge->Neighbour != nullptr)  leftEdge->Edge->Neighbour->TriHalfEdge = e3;
+		leftBreakpoint.TriHalfEdge() = e3;
 	} else
 	{
-		e1->twin = leftEdge->Edge->TriHalfEdge;
+		e1->twin = leftBreakpoint.TriHalfEdge();
 		if (e1->twin != nullptr) e1->twin->twin = e1;
-		if (leftEdge->Edge->Neighbour != nullptr)  leftEdge->Edge->Neighbour->TriHalfEdge = e1;
+		leftBreakpoint.TriHalfEdge() = e1;
 		
-		e3->twin = rightEdge->Edge->TriHalfEdge;
+		e3->twin = rightBreakpoint.TriHalfEdge();
 		if (e3->twin != nullptr) e3->twin->twin = e3;
-		if (rightEdge->Edge->Neighbour != nullptr)  rightEdge->Edge->Neighbour->TriHalfEdge = e3;
+		rightBreakpoint.TriHalfEdge() = e3;
 	}
 
-	newEdge->TriHalfEdge = e2;
+	newEdge.TriHalfEdge() = e2;
 
 	Diagram.TriangulationHalfEdges.push_back(e1);
 	Diagram.TriangulationHalfEdges.push_back(e2);
 	Diagram.TriangulationHalfEdges.push_back(e3);
 	Diagram.TriangulationFaces.push_back(tri);
 
-	// Clean Tree
-	Arc* higherNode = nullptr;
-	Arc* tmp = arc;
-
-	while (tmp->Parent != nullptr)
-	{
-		tmp = tmp->Parent;
-		if (tmp == leftEdge)
-			higherNode = leftEdge;
-
-		if (tmp == rightEdge)
-			higherNode = rightEdge;
-	}
-
-	higherNode->Edge = newEdge;
-
-	Arc* grandParent = arc->Parent->Parent;
-	Arc* movedUp = nullptr;
-	if (arc == arc->Parent->Left)
-	{
-		movedUp = arc->Parent->Right;
-		if (grandParent->Left == arc->Parent)
-		{
-			grandParent->SetLeft(arc->Parent->Right);
-
-		}
-		else {
-			grandParent->SetRight(arc->Parent->Right);
-		}
-	}
-	else
-	{
-		movedUp = arc->Parent->Left;
-		if (grandParent->Left == arc->Parent)
-		{
-			grandParent->SetLeft(arc->Parent->Left);
-		}
-		else {
-			grandParent->SetRight(arc->Parent->Left);
-
-		}
-	}
-
-	if (arc->Parent->Color == Arc::TreeColor::Black)
-	{
-		FixRedBlackPropertiesAfterDelete(movedUp);
-	}
-	delete arc->Parent;
-	delete arc;
+	Beach->RemoveArc(arc, newEdge);
+	NumArcs--;
 
 	CheckForCircleEvent(leftArc);
 	CheckForCircleEvent(rightArc);
 
-	}
+}
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::CleanRemainingTree()
+template<typename T>
+void BasicFortunesAlgorithm<T>::CleanRemainingTree()
 {
-	DCEL::Face* unbounded = new DCEL::Face({ nullptr, nullptr, nullptr, true });
-	DCEL::Face* triUnbounded = new DCEL::Face({ nullptr, nullptr, nullptr, true, ++NumTriangles });
+	Face* unbounded = Diagram.NewFace({ nullptr, nullptr, nullptr, true, 0 });
+	Face* triUnbounded = Diagram.NewFace({ nullptr, nullptr, nullptr, true, ++NumTriangles });
 	Diagram.Faces.push_back(unbounded);
 	Diagram.TriangulationFaces.push_back(triUnbounded);
 
-	std::vector<DCEL::HalfEdge*> boundingEdges;
-	DCEL::Vertex* b1 = new DCEL::Vertex({ ++NumBoundingVertices, Point({ MinX - 5.0, MinY - 5.0 }), nullptr, true });
-	DCEL::Vertex* b2 = new DCEL::Vertex({ ++NumBoundingVertices, Point({ MaxX + 5.0, MinY - 5.0 }), nullptr, true });
-	DCEL::Vertex* b3 = new DCEL::Vertex({ ++NumBoundingVertices, Point({ MaxX + 5.0, MaxY + 5.0 }), nullptr, true });
-	DCEL::Vertex* b4 = new DCEL::Vertex({ ++NumBoundingVertices, Point({ MinX - 5.0, MaxY + 5.0 }), nullptr, true });
+	std::vector<HalfEdge*> boundingEdges;
+	Vertex* b1 = Diagram.NewVertex({ ++NumBoundingVertices, Point(MinX - 5.0, MinY - 5.0), nullptr, true });
+	Vertex* b2 = Diagram.NewVertex({ ++NumBoundingVertices, Point(MaxX + 5.0, MinY - 5.0), nullptr, true });
+	Vertex* b3 = Diagram.NewVertex({ ++NumBoundingVertices, Point(MaxX + 5.0, MaxY + 5.0), nullptr, true });
+	Vertex* b4 = Diagram.NewVertex({ ++NumBoundingVertices, Point(MinX - 5.0, MaxY + 5.0), nullptr, true });
 
 	Diagram.Vertices.push_back(b1);
 	Diagram.Vertices.push_back(b2);
 	Diagram.Vertices.push_back(b3);
 	Diagram.Vertices.push_back(b4);
 
-	boundingEdges.push_back(new DCEL::HalfEdge({ b1, b2, nullptr, nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b1, b2, nullptr, nullptr, nullptr, nullptr }));
 	b1->incidentEdge = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b2, b1, boundingEdges.back(), nullptr, nullptr, nullptr}));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b2, b1, boundingEdges.back(), nullptr, nullptr, nullptr}));
 	boundingEdges.back()->incidentFace = unbounded;
 	unbounded->innerComponent = boundingEdges.back();
 	boundingEdges.back()->twin->twin = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b2, b3, nullptr, nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b2, b3, nullptr, nullptr, nullptr, nullptr }));
 	b2->incidentEdge = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b3, b2, boundingEdges.back(), nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b3, b2, boundingEdges.back(), nullptr, nullptr, nullptr }));
 	boundingEdges.back()->incidentFace = unbounded;
 	boundingEdges.back()->twin->twin = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b3, b4, nullptr, nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b3, b4, nullptr, nullptr, nullptr, nullptr }));
 	b3->incidentEdge = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b4, b3, boundingEdges.back(), nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b4, b3, boundingEdges.back(), nullptr, nullptr, nullptr }));
 	boundingEdges.back()->incidentFace = unbounded;
 	boundingEdges.back()->twin->twin = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b4, b1, nullptr, nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b4, b1, nullptr, nullptr, nullptr, nullptr }));
 	b4->incidentEdge = boundingEdges.back();
-	boundingEdges.push_back(new DCEL::HalfEdge({ b1, b4, boundingEdges.back(), nullptr, nullptr, nullptr }));
+	boundingEdges.push_back(Diagram.NewHalfEdge({ b1, b4, boundingEdges.back(), nullptr, nullptr, nullptr }));
 	boundingEdges.back()->incidentFace = unbounded;
 	boundingEdges.back()->twin->twin = boundingEdges.back();
 
@@ -471,150 +664,33 @@ void FortunesAlgorithm::CleanRemainingTree()
 	boundingEdges[7]->next = boundingEdges[5];
 	boundingEdges[7]->prev = boundingEdges[1];
 
-	for (Arc* arc : InOrder())
+	for (ArcRef arc : InOrder())
 	{
-		if (arc->Edge != nullptr)
-		{
-			// Voronoi Diagram
-			double x, y;
-			for (int i = 0; i < boundingEdges.size(); i+=2)
-			{
-				bool intersectingCorner = false;
-				bool intersecting = false;
-				DCEL::HalfEdge* edge = boundingEdges[i];
-
-				if (arc->Edge->IsVertical)
-				{
-					x = arc->Edge->Start->x;
-					y = edge->origin->point.y;
-
-					intersecting = (y - arc->Edge->Start->y) / (arc->Edge->Direction.y) > 0;
-				} else if (edge->origin->point.x - edge->dest->point.x == 0)
-				{
-					x = edge->origin->point.x;
-					y = arc->Edge->Line.x * x + arc->Edge->Line.y;
-					intersecting = (y < std::max(edge->origin->point.y, edge->dest->point.y)
-						&& y > std::min(edge->origin->point.y, edge->dest->point.y)
-						&& (x - arc->Edge->Start->x) / (arc->Edge->Direction.x) > 0);
-
-					intersectingCorner = (y == edge->origin->point.y);
-
-				}
-				else if (edge->origin->point.y - edge->dest->point.y == 0)
-				{
-					y = edge->origin->point.y;
-					x = (y - arc->Edge->Line.y) / arc->Edge->Line.x;
-
-					intersecting = (x < std::max(edge->origin->point.x, edge->dest->point.x)
-						&& x > std::min(edge->origin->point.x, edge->dest->point.x)
-						&& (y - arc->Edge->Start->y) / (arc->Edge->Direction.y) > 0);
-
-					intersectingCorner = (x == edge->origin->point.x);
-				}
-
-				if ((intersecting || intersectingCorner) && arc->Edge->HalfEdge == nullptr)
-				{
-					arc->Edge->HalfEdge = new DCEL::HalfEdge({ nullptr, nullptr, nullptr, arc->Edge->Left->face, nullptr, nullptr });
-					arc->Edge->HalfEdge->twin = new DCEL::HalfEdge({ nullptr, nullptr, arc->Edge->HalfEdge, arc->Edge->Right->face, nullptr, nullptr });
-
-					if (arc->Edge->Left->face->outerComponent == nullptr) arc->Edge->Left->face->outerComponent = arc->Edge->HalfEdge;
-					if (arc->Edge->Right->face->outerComponent == nullptr) arc->Edge->Right->face->outerComponent = arc->Edge->HalfEdge->twin;
-
-					Diagram.HalfEdges.push_back(arc->Edge->HalfEdge);
-					Diagram.HalfEdges.push_back(arc->Edge->HalfEdge->twin);
-
-					if(arc->Edge->Neighbour != nullptr)
-						arc->Edge->Neighbour->HalfEdge = arc->Edge->HalfEdge->twin;
-				}
-
-				if (intersecting)
-				{
-					DCEL::Vertex* b = new DCEL::Vertex({ ++NumBoundingVertices, Point({ x, y }), nullptr, true });
-					Diagram.Vertices.push_back(b);
-
-					// Create new half edge
-					DCEL::HalfEdge* e1eB = new DCEL::HalfEdge({ edge->origin, b, nullptr, nullptr, nullptr, nullptr });
-					e1eB->prev = edge->prev;
-					e1eB->next = arc->Edge->HalfEdge;
-					e1eB->incidentFace = arc->Edge->HalfEdge->incidentFace;
-					edge->prev->next = e1eB;
-
-					// Create new Half edge
-					DCEL::HalfEdge* eBe1 = new DCEL::HalfEdge({ b, edge->origin, e1eB, nullptr, nullptr, nullptr });
-					eBe1->incidentFace = unbounded;
-					eBe1->next = edge->twin->next;
-					eBe1->prev = edge->twin;
-					e1eB->twin = eBe1;
-
-					// Update old records
-					edge->origin = b;
-					edge->twin->dest = b;
-
-					arc->Edge->HalfEdge->origin = b;
-					arc->Edge->HalfEdge->twin->dest = b;
-					arc->Edge->HalfEdge->twin->next = edge;
-					arc->Edge->HalfEdge->prev = e1eB;
-
-					edge->prev = arc->Edge->HalfEdge->twin;
-					edge->incidentFace = arc->Edge->HalfEdge->twin->incidentFace;
-
-					// Provide incident edges
-					b->incidentEdge = edge;
-					e1eB->origin->incidentEdge = e1eB;
-
-					boundingEdges.push_back(e1eB);
-					boundingEdges.push_back(eBe1);
-
-					break;
-				}
-				else if (intersectingCorner)
-				{
-					arc->Edge->HalfEdge->origin = edge->origin;
-					arc->Edge->HalfEdge->twin->dest= edge->origin;
-
-					arc->Edge->HalfEdge->twin->next = edge;
-					arc->Edge->HalfEdge->prev = edge->prev;
-					edge->prev->next = arc->Edge->HalfEdge;
-					edge->prev->incidentFace = arc->Edge->HalfEdge->incidentFace;
-
-					edge->prev = arc->Edge->HalfEdge->twin;
-					edge->incidentFace = arc->Edge->HalfEdge->twin->incidentFace;
-					break;
-				}
-			}
-
-			// Triangulation
-			if (arc->Edge->TriHalfEdge != nullptr)
-			{
-				arc->Edge->TriHalfEdge->twin = new DCEL::HalfEdge({ arc->Edge->TriHalfEdge->dest, arc->Edge->TriHalfEdge->origin ,arc->Edge->TriHalfEdge, triUnbounded, nullptr, nullptr });
-				Diagram.TriangulationHalfEdges.push_back(arc->Edge->TriHalfEdge->twin);
-
-				if (triUnbounded->innerComponent == nullptr)
-				{
-					triUnbounded->innerComponent = arc->Edge->TriHalfEdge->twin;
-				}
-			}
-
-			IniniteEdges.push_back(arc->Edge);
-			arc->Edge->End = new Point({ arc->Edge->Start->x + 10.0 * arc->Edge->Direction.x,
-				arc->Edge->Start->y + 10.0 * arc->Edge->Direction.y });
-		}
-		delete arc;
+		Edge breakpoint = Beach->RightBreakpoint(arc);
+		if (!breakpoint.IsNull())
+			ClipToBox(breakpoint, boundingEdges, unbounded, triUnbounded);
 	}
 
-	for (DCEL::HalfEdge* edge : boundingEdges)
+	// The bisectors of the first row are rays down from infinity, whether a circle event
+	// closed them or they are still on the beach line their upper end meets the top of the box
+	for (const Edge& edge : FirstRowEdges)
+		ClipToBox(Edge(edge.Source, !edge.Reversed), boundingEdges, unbounded, triUnbounded);
+	Beach->Clear();
+
+	for (HalfEdge* edge : boundingEdges)
 	{
 		Diagram.HalfEdges.push_back(edge);
 	}
 
 	// Finish Delauny 
-	DCEL::HalfEdge* start = triUnbounded->innerComponent;
-	DCEL::HalfEdge* cur = nullptr;
-	Diagram.PrintDelaunayTriangulation(std::cout);
+	HalfEdge* start = triUnbounded->innerComponent;
+	HalfEdge* cur = nullptr;
+	if (Verbose)
+		Diagram.PrintDelaunayTriangulation(std::cout);
 	while (start != cur)
 	{
 		if (cur == nullptr) cur = start;
-		DCEL::HalfEdge* prev = cur->twin;
+		HalfEdge* prev = cur->twin;
 		while (prev->incidentFace != triUnbounded)
 		{
 			prev = prev->next->twin;
@@ -624,533 +700,466 @@ void FortunesAlgorithm::CleanRemainingTree()
 
 		cur = prev;
 	}
-	
-
-	Root == nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::CleanZeroLengthEdges()
+// Ends the breakpoint's edge where it leaves the box, splitting the box edge it
+// crosses, and gives its Delaunay half edge a twin on the unbounded triangle.
+template<typename T>
+void BasicFortunesAlgorithm<T>::ClipToBox(Edge breakpoint, std::vector<HalfEdge*>& boundingEdges,
+	Face* unbounded, Face* triUnbounded)
 {
-	std::vector<DCEL::HalfEdge* >::iterator it = Diagram.HalfEdges.begin();
-	while(it != Diagram.HalfEdges.end())
+	// The edge leaves the box beyond its finite end, the vertex its half edge already
+	// runs to when the other side was closed and the start of the bisector otherwise
+	const Point* from = breakpoint.Start();
+	if (nullptr != breakpoint.HalfEdge() && nullptr != breakpoint.HalfEdge()->dest)
+		from = &breakpoint.HalfEdge()->dest->point;
+
+	// Voronoi Diagram
+	Real x, y;
+	for (size_t i = 0; i < boundingEdges.size(); i+=2)
 	{
-		DCEL::HalfEdge* edge = *it;
-		if (edge->origin == edge->dest)
-		{
-			edge->next->prev = edge->prev;
-			edge->prev->next = edge->next;
-			edge->twin = nullptr;
-			it = Diagram.HalfEdges.erase(it);
-		}
-		else {
-			it++;
-		}
-	}
-}
+		bool intersectingCorner = false;
+		bool intersecting = false;
+		HalfEdge* edge = boundingEdges[i];
 
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::FillOuterEdgesIncidentFaces()
-{
-	DCEL::HalfEdge* start = Diagram.Faces.back()->innerComponent->twin;
-	DCEL::HalfEdge* cur = nullptr;
-	while (start != cur)
-	{
-		if (cur == nullptr)
-			cur = start;
-
-		if (cur->incidentFace == nullptr)
-			cur->incidentFace = cur->prev->incidentFace;
+		if (breakpoint.IsVertical())
+		{
+			// Only the top and bottom of the box cross a vertical bisector
+			if (edge->origin->point.y != edge->dest->point.y)
+				continue;
 
-		cur = cur->twin->next->twin;
-	}
-}
+			x = breakpoint.Start()->x;
+			y = edge->origin->point.y;
 
+			intersecting = (x < std::max(edge->origin->point.x, edge->dest->point.x)
+				&& x > std::min(edge->origin->point.x, edge->dest->point.x)
+				&& (y - from->y) / (breakpoint.Direction().y) > 0);
+		} else if (edge->origin->point.x - edge->dest->point.x == 0)
+		{
+			x = edge->origin->point.x;
+			y = breakpoint.Line().x * x + breakpoint.Line().y;
+			intersecting = (y < std::max(edge->origin->point.y, edge->dest->point.y)
+				&& y > std::min(edge->origin->point.y, edge->dest->point.y)
+				&& (x - from->x) / (breakpoint.Direction().x) > 0);
 
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::UpdateBounds(const Point& point)
-{
-	if (point.y < MinY)
-		MinY = point.y;
-	if (point.y > MaxY)
-		MaxY = point.y;
-	if (point.x < MinX)
-		MinX = point.x;
-	if (point.x > MaxX)
-		MaxX = point.x;
-}
+			intersectingCorner = (y == edge->origin->point.y
+				&& (x - from->x) / (breakpoint.Direction().x) > 0);
 
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::CheckForCircleEvent(Arc* arc, bool potentinalVertexSplit)
-{
-	Arc* leftEdge = GetLeftParent(arc);
-	Arc* rightEdge = GetRightParent(arc);
+		}
+		else if (edge->origin->point.y - edge->dest->point.y == 0)
+		{
+			y = edge->origin->point.y;
+			x = (y - breakpoint.Line().y) / breakpoint.Line().x;
 
+			intersecting = (x < std::max(edge->origin->point.x, edge->dest->point.x)
+				&& x > std::min(edge->origin->point.x, edge->dest->point.x)
+				&& (y - from->y) / (breakpoint.Direction().y) > 0);
 
-	if (nullptr == rightEdge || nullptr == leftEdge)
-		return;
+			intersectingCorner = (x == edge->origin->point.x
+				&& (y - from->y) / (breakpoint.Direction().y) > 0);
+		}
 
-	Arc* leftArc = GetClosestLeftChild(leftEdge);
-	Arc* rightArc = GetClosestRightChild(rightEdge);
+		if ((intersecting || intersectingCorner) && breakpoint.HalfEdge() == nullptr)
+		{
+			HalfEdge* halfEdge = Diagram.NewHalfEdge({ nullptr, nullptr, nullptr, breakpoint.Left()->face, nullptr, nullptr });
+			halfEdge->twin = Diagram.NewHalfEdge({ nullptr, nullptr, halfEdge, breakpoint.Right()->face, nullptr, nullptr });
+			breakpoint.SetHalfEdge(halfEdge);
 
-	if (nullptr == leftArc || nullptr == rightArc || leftArc->Site == rightArc->Site) return;
+			if (breakpoint.Left()->face->outerComponent == nullptr) breakpoint.Left()->face->outerComponent = breakpoint.HalfEdge();
+			if (breakpoint.Right()->face->outerComponent == nullptr) breakpoint.Right()->face->outerComponent = breakpoint.HalfEdge()->twin;
 
-	Point* intersection = leftEdge->Edge->Intersect(rightEdge->Edge);
-	if (nullptr == intersection) return;
+			Diagram.HalfEdges.push_back(breakpoint.HalfEdge());
+			Diagram.HalfEdges.push_back(breakpoint.HalfEdge()->twin);
+		}
 
-	double changeX = arc->Site->point.x - intersection->x;
-	double changeY = arc->Site->point.y - intersection->y;
+		if (intersecting)
+		{
+			Vertex* b = Diagram.NewVertex({ ++NumBoundingVertices, Point(x, y), nullptr, true });
+			Diagram.Vertices.push_back(b);
+
+			// Create new half edge
+			HalfEdge* e1eB = Diagram.NewHalfEdge({ edge->origin, b, nullptr, nullptr, nullptr, nullptr });
+			e1eB->prev = edge->prev;
+			e1eB->next = breakpoint.HalfEdge();
+			e1eB->incidentFace = breakpoint.HalfEdge()->incidentFace;
+			edge->prev->next = e1eB;
+
+			// Create new Half edge
+			HalfEdge* eBe1 = Diagram.NewHalfEdge({ b, edge->origin, e1eB, nullptr, nullptr, nullptr });
+			eBe1->incidentFace = unbounded;
+			eBe1->next = edge->twin->next;
+			eBe1->prev = edge->twin;
+			edge->twin->next->prev = eBe1;
+			edge->twin->next = eBe1;
+			e1eB->twin = eBe1;
+
+			// Update old records
+			edge->origin = b;
+			edge->twin->dest = b;
+
+			breakpoint.HalfEdge()->origin = b;
+			breakpoint.HalfEdge()->twin->dest = b;
+			breakpoint.HalfEdge()->twin->next = edge;
+			breakpoint.HalfEdge()->prev = e1eB;
+
+			edge->prev = breakpoint.HalfEdge()->twin;
+			edge->incidentFace = breakpoint.HalfEdge()->twin->incidentFace;
+
+			// Provide incident edges
+			b->incidentEdge = edge;
+			e1eB->origin->incidentEdge = e1eB;
+
+			boundingEdges.push_back(e1eB);
+			boundingEdges.push_back(eBe1);
+
+			break;
+		}
+		else if (intersectingCorner)
+		{
+			breakpoint.HalfEdge()->origin = edge->origin;
+			breakpoint.HalfEdge()->twin->dest= edge->origin;
 
-	double distance = std::sqrt((changeX * changeX) + (changeY * changeY));
+			breakpoint.HalfEdge()->twin->next = edge;
+			breakpoint.HalfEdge()->prev = edge->prev;
+			edge->prev->next = breakpoint.HalfEdge();
+			edge->prev->incidentFace = breakpoint.HalfEdge()->incidentFace;
 
-	if (intersection->y - distance> SweepHeight || (!potentinalVertexSplit && intersection->y - distance >= SweepHeight)) return;
+			edge->prev = breakpoint.HalfEdge()->twin;
+			edge->incidentFace = breakpoint.HalfEdge()->twin->incidentFace;
+			break;
+		}
+	}
 
-	EventPoint* circleEvent = new EventPoint(
-		new VoronoiSite({ Point(intersection->x, intersection->y - distance), nullptr, nullptr, -1 }), EventPointType::Circle);
+	// Triangulation, a first row bisector still on the beach line is seen from both ends
+	if (breakpoint.TriHalfEdge() != nullptr && breakpoint.TriHalfEdge()->twin == nullptr)
+	{
+		HalfEdge* triHalfEdge = breakpoint.TriHalfEdge();
+		triHalfEdge->twin = Diagram.NewHalfEdge({ triHalfEdge->dest, triHalfEdge->origin ,triHalfEdge, triUnbounded, nullptr, nullptr });
+		Diagram.TriangulationHalfEdges.push_back(breakpoint.TriHalfEdge()->twin);
 
-	arc->CircleEvent = circleEvent;
-	circleEvent->Arc = arc;
-	circleEvent->Radius = distance;
+		if (triUnbounded->innerComponent == nullptr)
+		{
+			triUnbounded->innerComponent = breakpoint.TriHalfEdge()->twin;
+		}
+	}
 
-	Queue->Push(circleEvent);
+	IniniteEdges.push_back(breakpoint);
+	const Point direction = breakpoint.Direction();
+	breakpoint.End() = NewEdgePoint(breakpoint.Start()->x + 10.0 * direction.x,
+		breakpoint.Start()->y + 10.0 * direction.y);
 }
 
-
 ////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::FindArcAtX(double x)
+template<typename T>
+void BasicFortunesAlgorithm<T>::CleanZeroLengthEdges()
 {
-	BL::Arc* root = Root;
-	while (!root->Leaf)
+	// Compact in one pass, erasing edge by edge is quadratic when a lattice leaves many
+	size_t kept = 0;
+	for (HalfEdge* edge : Diagram.HalfEdges)
 	{
-		// Error - A leaf has become an internal node (only edge nodes should be internal)
-		if (nullptr == root->Edge) return nullptr;
-		if (root->Edge->IsVertical && x < root->Edge->Start->x ||
-			x < IntersectionX(root->Edge->Left->point, root->Edge->Right->point, SweepHeight))
+		if (edge->origin == edge->dest)
 		{
-			root = root->Left;
+			edge->next->prev = edge->prev;
+			edge->prev->next = edge->next;
+			edge->twin = nullptr;
+		}
+		else {
+			Diagram.HalfEdges[kept++] = edge;
 		}
-		else
-			root = root->Right;
 	}
-	return root;
+	Diagram.HalfEdges.resize(kept);
 }
 
 ////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::GetLeftParent(Arc* root)
+template<typename T>
+void BasicFortunesAlgorithm<T>::FillOuterEdgesIncidentFaces()
 {
-	Arc* parent = root->Parent;
-	while (nullptr != parent && parent->Left == root)
+	HalfEdge* start = Diagram.Faces.back()->innerComponent->twin;
+	HalfEdge* cur = nullptr;
+	while (start != cur)
 	{
-		root = parent;
-		parent = parent->Parent;
-	}
-	return parent;
-}
+		if (cur == nullptr)
+			cur = start;
 
-////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::GetRightParent(Arc* root)
-{
-	Arc* parent = root->Parent;
-	while (nullptr != parent && parent->Right == root)
-	{
-		root = parent;
-		parent = parent->Parent;
-	}
-	return parent;
-}
+		if (cur->incidentFace == nullptr)
+			cur->incidentFace = cur->prev->incidentFace;
 
-////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::GetClosestLeftChild(Arc* root)
-{
-	Arc* child = root->Left;
-	while (nullptr != child && !child->Leaf)
-	{
-		child = child->Right;
+		cur = cur->twin->next->twin;
 	}
-	return child;
 }
 
-////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::GetClosestRightChild(Arc* root)
-{
-	Arc* child = root->Right;
-	while (nullptr != child && !child->Leaf)
-	{
-		child = child->Left;
-	}
-	return child;
-}
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::RightRotation(Arc* arc)
+// Turns everything the sweep produced a quarter counter clockwise, back into
+// the orientation of the input. A rotation rather than a mirror keeps the
+// winding of every face and triangle intact.
+template<typename T>
+void BasicFortunesAlgorithm<T>::RestoreSweepAxis()
 {
-	Arc* parent = arc->Parent;
-	Arc* leftChild = arc->Left;
-
-	arc->Left = leftChild->Right;
-	if (leftChild->Right != nullptr) {
-		leftChild->Right->Parent = arc;
-	}
-
-	leftChild->Right = arc;
-	arc->Parent = leftChild;
+	for (VoronoiSite* site : Diagram.Sites)
+		site->point = Point(-site->point.y, site->point.x);
 
-	ReplaceParentsChild(parent, arc, leftChild);
-}
+	for (Vertex* vertex : Diagram.Vertices)
+		vertex->point = Point(-vertex->point.y, vertex->point.x);
 
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::LeftRotation(Arc* arc) {
-	Arc* parent = arc->Parent;
-	Arc* rightChild = arc->Right;
+	for (Vertex* vertex : Diagram.TriangulationVertices)
+		vertex->point = Point(-vertex->point.y, vertex->point.x);
 
-	arc->Right = rightChild->Left;
-	if (rightChild->Left != nullptr) {
-		rightChild->Left->Parent = arc;
+	// Neighbouring edges share their end points, so only turn each point once
+	std::unordered_set<Point*> edgePoints;
+	for (const Edge& edge : CompletedEdges)
+	{
+		edgePoints.insert(edge.Start());
+		edgePoints.insert(edge.End());
 	}
-
-	rightChild->Left = arc;
-	arc->Parent = rightChild;
-
-	ReplaceParentsChild(parent, arc, rightChild);
+	for (const Edge& edge : IniniteEdges)
+	{
+		edgePoints.insert(edge.Start());
+		edgePoints.insert(edge.End());
+	}
+	for (Point* point : edgePoints)
+		*point = Point(-point->y, point->x);
+
+	const Real minX = MinX, maxX = MaxX, minY = MinY, maxY = MaxY;
+	MinX = -maxY;
+	MaxX = -minY;
+	MinY = minX;
+	MaxY = maxX;
 }
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::ReplaceParentsChild(Arc* parent, Arc* oldChild, Arc* newChild)
+template<typename T>
+void BasicFortunesAlgorithm<T>::UpdateBounds(const Point& point)
 {
-	if (parent == nullptr) {
-		Root = newChild;
-	}
-	else if (parent->Left == oldChild) {
-		parent->Left = newChild;
-	}
-	else if (parent->Right == oldChild) {
-		parent->Right = newChild;
-	}
-
-	if (newChild != nullptr) {
-		newChild->Parent = parent;
-	}
+	if (point.y < MinY)
+		MinY = point.y;
+	if (point.y > MaxY)
+		MaxY = point.y;
+	if (point.x < MinX)
+		MinX = point.x;
+	if (point.x > MaxX)
+		MaxX = point.x;
 }
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::FixRedBlackPropertiesAfterInsert(Arc* arc)
+// Vertices of four or more co-circular sites are made once per circle event, and the
+// events need not pop back to back. Hashing the vertices on snapped coordinates finds
+// the earlier copy so the DCEL never holds the duplicate or the zero length edge. Nearby
+// is only a candidate, the copy is the same vertex when its sites are exactly co-circular
+// with a, b and c.
+template<typename T>
+typename BasicFortunesAlgorithm<T>::Vertex* BasicFortunesAlgorithm<T>::FindOrAddVertex(const Point& point,
+	const VoronoiSite* a, const VoronoiSite* b, const VoronoiSite* c)
 {
-	Arc* parent = arc->Parent;
+	// Co-circular sites close their circle at one event height, once the sweep has
+	// moved past it no later vertex can coincide with the recent ones
+	if (SweepHeight < RecentHeight - VertexSnap)
+		RecentVertices.clear();
+	RecentHeight = SweepHeight;
 
-	if (parent == nullptr) {
-		arc->Color = Arc::TreeColor::Black;
-		return;
-	}
-
-	if (parent->Color == Arc::TreeColor::Black) {
-		return;
-	}
-
-	Arc* grandparent = parent->Parent;
-
-	if (grandparent == nullptr) {
-		parent->Color = Arc::TreeColor::Black;
-		return;
-	}
-
-	Arc* uncle = GetUncle(parent);
-
-	if (uncle != nullptr && uncle->Color == Arc::TreeColor::Red) {
-		parent->Color = Arc::TreeColor::Black;
-		grandparent->Color = Arc::TreeColor::Red;
-		uncle->Color = Arc::TreeColor::Black;
-
-		FixRedBlackPropertiesAfterInsert(grandparent);
-	}
-
-	else if (parent == grandparent->Left) {
-		if (arc == parent->Right) {
-			LeftRotation(parent);
+	auto cellOf = [this](Real value) -> int64_t
+	{
+		const double cell = std::floor(double(value / VertexSnap));
+		return int64_t(std::max(std::min(cell, 4.0e18), -4.0e18));
+	};
+	const CellKey cell = { cellOf(point.x), cellOf(point.y) };
 
-			parent = arc;
+	// A coincident vertex lies in this cell or one of its neighbours
+	for (int64_t dx = -1; dx <= 1; dx++)
+	{
+		for (int64_t dy = -1; dy <= 1; dy++)
+		{
+			auto range = RecentVertices.equal_range(CellKey{ cell.x + dx, cell.y + dy });
+			for (auto it = range.first; it != range.second; ++it)
+			{
+				const RecentVertex& recent = it->second;
+				if (std::abs(recent.vertex->point.x - point.x) > VertexSnap
+					|| std::abs(recent.vertex->point.y - point.y) > VertexSnap)
+					continue;
+
+				const Point& p = recent.sites[0]->point;
+				const Point& q = recent.sites[1]->point;
+				const Point& r = recent.sites[2]->point;
+				if (0.0 == SitePredicates<T>::InCircle(p, q, r, a->point)
+					&& 0.0 == SitePredicates<T>::InCircle(p, q, r, b->point)
+					&& 0.0 == SitePredicates<T>::InCircle(p, q, r, c->point))
+					return recent.vertex;
+			}
 		}
-
-		RightRotation(grandparent);
-
-		parent->Color = Arc::TreeColor::Black;
-		grandparent->Color = Arc::TreeColor::Red;
 	}
 
-	else {
-		if (arc == parent->Left) {
-			RightRotation(parent);
-			parent = arc;
-		}
-
-		LeftRotation(grandparent);
-
-		parent->Color = Arc::TreeColor::Black;
-		grandparent->Color = Arc::TreeColor::Red;
-	}
+	Vertex* vertex = Diagram.NewVertex({ ++NumVoronoiSites, point, nullptr });
+	Diagram.Vertices.push_back(vertex);
+	RecentVertices.insert({ cell, RecentVertex{ vertex, { a, b, c } } });
+	return vertex;
 }
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::FixRedBlackPropertiesAfterDelete(Arc* arc)
+template<typename T>
+void BasicFortunesAlgorithm<T>::CheckForCircleEvent(ArcRef arc)
 {
-	if (arc == Root) {
-		arc->Color = Arc::TreeColor::Black;
-		return;
-	}
+	// An event kept through the last circle event already covers this circle
+	if (nullptr != Beach->CircleEvent(arc)) return;
 
-	Arc* sibling = (arc == arc->Parent->Left) ? arc->Parent->Right : arc->Parent->Left;
+	Edge leftEdge = Beach->LeftBreakpoint(arc);
+	Edge rightEdge = Beach->RightBreakpoint(arc);
 
-	if (sibling->Color == Arc::TreeColor::Red) {
-		sibling->Color = Arc::TreeColor::Black;
-		arc->Parent->Color = Arc::TreeColor::Red;
-		if (arc == arc->Parent->Left) {
-			LeftRotation(arc->Parent);
-		}
-		else {
-			RightRotation(arc->Parent);
-		}
-		sibling = (arc == arc->Parent->Left) ? arc->Parent->Right : arc->Parent->Left;
-	}
 
-	if (sibling->Left->Color == Arc::TreeColor::Black && sibling->Right->Color == Arc::TreeColor::Black) {
-		sibling->Color = Arc::TreeColor::Red;
+	if (rightEdge.IsNull() || leftEdge.IsNull())
+		return;
 
-		if (arc->Parent->Color == Arc::TreeColor::Red) {
-			arc->Parent->Color = Arc::TreeColor::Black;
-		}
+	ArcRef leftArc = Beach->LeftArc(arc);
+	ArcRef rightArc = Beach->RightArc(arc);
 
-		else 
-		{
-			FixRedBlackPropertiesAfterDelete(arc->Parent);
-		}
-	} else 
-	{
-		bool isLeftChild = arc == arc->Parent->Left;
+	if (NullArc == leftArc || NullArc == rightArc || Beach->Site(leftArc) == Beach->Site(rightArc)) return;
 
-		if (isLeftChild && sibling->Right->Color == Arc::TreeColor::Black) {
-			sibling->Left->Color = Arc::TreeColor::Black;
-			sibling->Color = Arc::TreeColor::Red;
-			RightRotation(sibling);
-			sibling = arc->Parent->Right;
-		}
-		else if (!isLeftChild && sibling->Left->Color == Arc::TreeColor::Black) {
-			sibling->Right->Color = Arc::TreeColor::Black;
-			sibling->Color = Arc::TreeColor::Red;
-			LeftRotation(sibling);
-			sibling = arc->Parent->Left;
-		}
+	// The breakpoints either side of the arc only meet when its neighbours' sites
+	// turn clockwise around its own, which the exact predicate settles
+	VoronoiSite* arcSite = Beach->Site(arc);
+	if (SitePredicates<T>::Orientation(Beach->Site(leftArc)->point, arcSite->point, Beach->Site(rightArc)->point) >= 0.0) return;
 
-		sibling->Color = arc->Parent->Color;
-		arc->Parent->Color = Arc::TreeColor::Black;
-		if (isLeftChild) {
-			sibling->Right->Color = Arc::TreeColor::Black;
-			LeftRotation(arc->Parent);
-		}
-		else {
-			sibling->Left->Color = Arc::TreeColor::Black;
-			RightRotation(arc->Parent);
-		}
-	}
-}
-
-////////////////////////////////////////////////////////////////////
-Arc* FortunesAlgorithm::GetUncle(Arc* parent) {
-	Arc* grandparent = parent->Parent;
-	if (grandparent->Left == parent) {
-		return grandparent->Right;
-	}
-	else if (grandparent->Right == parent) {
-		return grandparent->Left;
-	}
-}
+	// The edges only place the vertex
+	Point* intersection = leftEdge.Intersect(rightEdge);
+	if (nullptr == intersection) return;
 
+	Real changeX = arcSite->point.x - intersection->x;
+	Real changeY = arcSite->point.y - intersection->y;
 
+	Real distance = std::sqrt((changeX * changeX) + (changeY * changeY));
 
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::PrintTree()
-{
-	if(nullptr != Root)
-		PrintTreeInOrder(Root);
-}
+	// Converging breakpoints always meet at or below the sweep line, rounding can
+	// only put the bottom of the circle a hair above it
+	const Real eventHeight = std::min(intersection->y - distance, SweepHeight);
 
-////////////////////////////////////////////////////////////////////
-bool FortunesAlgorithm::IsComplete()
-{
-	return Complete;
-}
-
-////////////////////////////////////////////////////////////////////
-double FortunesAlgorithm::GetHeight()
-{
-	return SweepHeight;
-}
-
-////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::PrintTreeInOrder(Arc* a, int depth)
-{
-	if (nullptr != a->Left)
-		PrintTreeInOrder(a->Left, depth + 1);
+	EventPoint* circleEvent = new EventPoint(
+		new VoronoiSite({ Point(intersection->x, eventHeight), nullptr, nullptr, -1 }), EventPointType::Circle);
 
-	if (nullptr != a->Edge)
-		std::cout << "<" << a->Edge->Left->index << ", " << a->Edge->Right->index << "> ";
-	else if (nullptr != a->Site)
-		std::cout << "P" << a->Site->index << " ";
+	Beach->SetCircleEvent(arc, circleEvent);
+	circleEvent->Arc = arc;
+	circleEvent->Radius = intersection->y - eventHeight;
+	delete intersection;
 
-	if (nullptr != a->Right)
-		PrintTreeInOrder(a->Right, depth + 1);
+	Queue->Push(circleEvent);
 }
 
-////////////////////////////////////////////////////////////////////
-const std::vector<Arc*>& FortunesAlgorithm::InOrder()
-{
-	InOrderArcs.clear();
-	if (nullptr != Root)
-		TreeInOrder(Root);
-
-	return InOrderArcs;
-}
 
 ////////////////////////////////////////////////////////////////////
-void FortunesAlgorithm::TreeInOrder(BL::Arc* a)
+template<typename T>
+bool BasicFortunesAlgorithm<T>::IsSameCircle(ArcRef a, ArcRef b, ArcRef c, ArcRef d) const
 {
-	if (nullptr != a->Left)
-		TreeInOrder(a->Left);
-
-	InOrderArcs.push_back(a);
-
-	if (nullptr != a->Right)
-		TreeInOrder(a->Right);
+	if (NullArc == a || NullArc == d) return false;
+	return 0.0 == SitePredicates<T>::InCircle(Beach->Site(a)->point, Beach->Site(b)->point, Beach->Site(c)->point, Beach->Site(d)->point);
 }
 
-
 ////////////////////////////////////////////////////////////////////
-BL::Arc::Arc(VoronoiSite* site)
-	: Site(site)
-	, Edge(nullptr)
-	, CircleEvent(nullptr)
-	, Parent(nullptr)
-	, Left(nullptr)
-	, Right(nullptr)
-	, Leaf(true)
-	, Color(Arc::TreeColor::Black)
+template<typename T>
+void BasicFortunesAlgorithm<T>::PrintTree()
 {
+	if (Verbose)
+		Beach->Print(std::cout);
 }
 
 ////////////////////////////////////////////////////////////////////
-Arc::Arc(BL::Edge* edge)
-	: Site(nullptr)
-	, Edge(edge)
-	, CircleEvent(nullptr)
-	, Parent(nullptr)
-	, Left(nullptr)
-	, Right(nullptr)
-	, Leaf(false)
-	, Color(Arc::TreeColor::Red)
+template<typename T>
+void BasicFortunesAlgorithm<T>::SetVerbose(bool verbose)
 {
+	Verbose = verbose;
 }
 
 ////////////////////////////////////////////////////////////////////
-void Arc::SetLeft(Arc* a)
+template<typename T>
+bool BasicFortunesAlgorithm<T>::IsComplete()
 {
-	a->Parent = this;
-	Left = a;
+	return Complete;
 }
 
 ////////////////////////////////////////////////////////////////////
-void Arc::SetRight(Arc* a)
+template<typename T>
+typename BasicFortunesAlgorithm<T>::Real BasicFortunesAlgorithm<T>::GetHeight()
 {
-	a->Parent = this;
-	Right = a;
+	return SweepHeight;
 }
 
-
 ////////////////////////////////////////////////////////////////////
-BL::Edge::Edge(Point* start, VoronoiSite* left, VoronoiSite* right)
-	: Start(start)
-	, End(nullptr)
-	, Left(left)
-	, Right(right)
-	, HalfEdge(nullptr)
-	, TriHalfEdge(nullptr)
-	, Neighbour(nullptr)
-	, Line({ 0,0 })
-	, Direction({ 0,0 })
-	, IsVertical(false)
+template<typename T>
+const std::vector<ArcRef>& BasicFortunesAlgorithm<T>::InOrder()
 {
-	if (left->point.y == right->point.y)
-		IsVertical = true;
-
-	Line.x = (right->point.x - left->point.x) / (left->point.y - right->point.y);
-	Line.y = (start->y - Line.x * start->x);
+	InOrderArcs.clear();
+	if (!Beach->IsEmpty())
+	{
+		for (ArcRef arc = Beach->First(); NullArc != arc; arc = Beach->RightArc(arc))
+			InOrderArcs.push_back(arc);
+	}
 
-	Direction.x = (right->point.y - left->point.y);
-	Direction.y = (left->point.x - right->point.x);
+	return InOrderArcs;
 }
 
 ////////////////////////////////////////////////////////////////////
-BL::Edge::~Edge()
+template<typename T>
+void BasicFortunesAlgorithm<T>::TakeSnapshot(SweepSnapshot& snapshot)
 {
-}
+	snapshot.SweepHeight = SweepHeight;
+	snapshot.Complete = Complete;
 
-////////////////////////////////////////////////////////////////////
-Point* Edge::Intersect(Edge* edge)
-{
-	// Test for parellel
-	if (Line.x == edge->Line.x) return nullptr;
-	if (IsVertical && edge->IsVertical)
+	snapshot.Arcs.clear();
+	snapshot.Breakpoints.clear();
+	// The beach line has been torn down once the diagram is complete
+	if (!Complete)
 	{
-		return nullptr;
+		const std::vector<ArcRef>& arcs = InOrder();
+		for (size_t i = 0; i < arcs.size(); i++)
+		{
+			snapshot.Arcs.push_back(ToDouble(Beach->Site(arcs[i])->point));
+			if (i + 1 == arcs.size())
+				break;
+
+			// Every pair of neighbouring arcs gets a breakpoint, even before its edge exists
+			const Edge edge = Beach->RightBreakpoint(arcs[i]);
+			if (!edge.IsNull())
+			{
+				snapshot.Breakpoints.push_back({ ToDouble(edge.Left()->point), ToDouble(edge.Right()->point), ToDouble(*edge.Start()), edge.IsVertical(), true });
+			}
+			else
+			{
+				const ::Point left = ToDouble(Beach->Site(arcs[i])->point);
+				const ::Point right = ToDouble(Beach->Site(arcs[i + 1])->point);
+				snapshot.Breakpoints.push_back({ left, right, left, left.y == right.y, false });
+			}
+		}
 	}
 
-	// Cacluation intersection
-	double x = 0.0, y = 0.0;
-	if (edge->IsVertical)
+	for (size_t i = snapshot.CompletedEdges.size(); i < CompletedEdges.size(); i++)
 	{
-		x = edge->Start->x;
-		y = Line.x * x + Line.y;
+		snapshot.CompletedEdges.push_back({ ToDouble(*CompletedEdges[i].Start()), ToDouble(*CompletedEdges[i].End()) });
 	}
-	else if (IsVertical)
+
+	for (size_t i = snapshot.InfiniteEdges.size(); i < IniniteEdges.size(); i++)
 	{
-		x = Start->x;
-		y = edge->Line.x * x + edge->Line.y;
+		snapshot.InfiniteEdges.push_back({ ToDouble(*IniniteEdges[i].Start()), ToDouble(*IniniteEdges[i].End()) });
 	}
-	else {
-		x = (edge->Line.y - Line.y) / (Line.x - edge->Line.x);
-		y = Line.x * x + Line.y;
-	}
-
-	// Test to ensure its on proper side of the line
-	if ((x - Start->x) / (Direction.x) < 0.0) return nullptr;
-	if (Direction.y && (y - Start->y) / (Direction.y) < 0.0) return nullptr;
-
-	if ((x - edge->Start->x) / (edge->Direction.x) < 0.0) return nullptr;
-	if (edge->Direction.y && (y - edge->Start->y) / (edge->Direction.y) < 0.0) return nullptr;
-
-	Point* intersection = new Point(x, y);
-	return intersection;
 }
 
-
 ////////////////////////////////////////////////////////////////////
-Point Edge::RenderEdge(double y)
+template<typename Real>
+Real IntersectionX(const BasicPoint<Real>& left, const BasicPoint<Real>& right, const Real lh)
 {
-	double x = IntersectionX(Left->point, Right->point, y);
-	return Point(x, CalculateParabolaY(x, y, Left->point));
-}
+	// A site on the sweep line is still a vertical ray, and sites level with each other meet halfway
+	if (left.y == right.y) return (left.x + right.x) / 2;
+	if (left.y == lh) return left.x;
+	if (right.y == lh) return right.x;
 
-////////////////////////////////////////////////////////////////////
-double IntersectionX(const Point& left, const Point& right, const double lh)
-{
-	const double dl = 1.0 / (2.0 * (left.y - lh));
-	const double dr = 1.0 / (2.0 * (right.y - lh));
+	const Real dl = 1.0 / (2.0 * (left.y - lh));
+	const Real dr = 1.0 / (2.0 * (right.y - lh));
 
 	// Quadratic Coffecients
-	const double a = dl - dr;
-	const double b = -2.0 * dl * left.x + 2.0 * dr * right.x;
-	const double c = dl * (left.x * left.x + left.y * left.y - lh * lh)
+	const Real a = dl - dr;
+	const Real b = -2.0 * dl * left.x + 2.0 * dr * right.x;
+	const Real c = dl * (left.x * left.x + left.y * left.y - lh * lh)
 		- dr * (right.x * right.x + right.y * right.y - lh * lh);
 
-	double x1 = (-b + sqrt(b * b - 4 * a * c)) / (2.0 * a);
-	double x2 = (-b - sqrt(b * b - 4 * a * c)) / (2.0 * a);
+	Real x1 = (-b + std::sqrt(b * b - 4 * a * c)) / (2.0 * a);
+	Real x2 = (-b - std::sqrt(b * b - 4 * a * c)) / (2.0 * a);
 
 	if (left.y < right.y)
 		return std::max(x1, x2);
@@ -1159,18 +1168,27 @@ double IntersectionX(const Point& left, const Point& right, const double lh)
 }
 
 ////////////////////////////////////////////////////////////////////
-double CalculateParabolaY(const double x, const double lh, const Point& point)
+template<typename Real>
+Real CalculateParabolaY(const Real x, const Real lh, const BasicPoint<Real>& point)
 {
-	double px = point.x;
-	double py = point.y;
+	Real px = point.x;
+	Real py = point.y;
 
-	double d = 2.0 * (py - lh);
+	Real d = 2.0 * (py - lh);
 
 	if (d == 0) return point.y;
 
-	double cof = 1.0 / d;
+	Real cof = 1.0 / d;
 
 	return cof * (x * x - 2.0 * px * x + px * px + py * py - lh * lh);
 }
 
+template class BasicFortunesAlgorithm<float>;
+template class BasicFortunesAlgorithm<double>;
+template class BasicFortunesAlgorithm<int64_t>;
+
+template double IntersectionX(const BasicPoint<double>&, const BasicPoint<double>&, const double);
+template long double IntersectionX(const BasicPoint<long double>&, const BasicPoint<long double>&, const long double);
 
+template double CalculateParabolaY(const double, const double, const BasicPoint<double>&);
+template long double CalculateParabolaY(const long double, const long double, const BasicPoint<long double>&);
@@ -1,139 +1,142 @@
 #pragma once
 
+#include "PowerDiagram.h"
+#include "SweepDirection.h"
+
+#include "../types/BeachLine.h"
+#include "../types/SweepSnapshot.h"
 #include "../types/VoronoiDiagram.h"
+#include "../utils/CellHash.h"
+#include "../utils/Generator.h"
 
-namespace BL
-{
-	class Arc;
-	class Edge;
-}
-class EventPoint;
-class PriorityQueue;
+#include <unordered_map>
+
+template<typename T> class BasicEventPoint;
+template<typename T> class BasicPriorityQueue;
+struct SweepEvent;
 
-class FortunesAlgorithm
+// The sweep over sites with coordinates of type T, computing in CoordinateTraits<T>::Real.
+// It is compiled for float, double and int64_t sites, FortunesAlgorithm is the double one.
+// Snapshots and step records are for the viewer and stay in double whatever T is.
+template<typename T>
+class BasicFortunesAlgorithm
 {
 public:
-	FortunesAlgorithm(VoronoiDiagram& diagram);
-	~FortunesAlgorithm();
-
-	void Continues(double height);
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+	typedef BasicEventPoint<T> EventPoint;
+	typedef BasicPriorityQueue<T> PriorityQueue;
+	typedef BL::BasicBeachLine<T> BeachLine;
+	typedef BL::BasicBisector<T> Bisector;
+	typedef BL::BasicEdge<T> Edge;
+
+	// Sweeping along X rotates the sites a quarter turn and rotates the finished
+	// diagram back, partial states (snapshots, steps, heights) stay rotated.
+	BasicFortunesAlgorithm(VoronoiDiagram& diagram, SweepAxis axis = SweepAxis::Y,
+		BL::BeachLineType beachLine = BL::BeachLineType::RedBlack);
+	~BasicFortunesAlgorithm();
+
+	void Continues(Real height);
+	size_t AdvanceTo(Real height, size_t maxEvents = 0, double maxSeconds = 0.0);
 	void Run();
+	// Sets the sweep up again for the diagram's sites as they are now, once the diagram's
+	// DCEL has been cleared. Lets one algorithm sweep the same diagram many times.
+	void Reset();
 	void Next();
+	Generator<SweepEvent> Steps();
 
 // Utility Functions
 	void PrintTree();
+	// On by default, prints the beach line after every site event and the triangulation
+	// when the sweep finishes
+	void SetVerbose(bool verbose);
 	bool IsComplete();
-	double GetHeight();
-	const std::vector<BL::Arc*>& InOrder();
-	const std::vector<BL::Edge*>& GetCompletedEdges() { return CompletedEdges; }
-	const std::vector<BL::Edge*>& GetInfiniteEdges() { return IniniteEdges; }
+	Real GetHeight();
+	const std::vector<BL::ArcRef>& InOrder();
+	const BeachLine& GetBeachLine() { return *Beach; }
+	const std::vector<Edge>& GetCompletedEdges() { return CompletedEdges; }
+	const std::vector<Edge>& GetInfiniteEdges() { return IniniteEdges; }
+	// Bisectors of the first row, whose upper ends are left open until the sweep finishes
+	const std::vector<Edge>& GetFirstRowEdges() { return FirstRowEdges; }
+	void TakeSnapshot(SweepSnapshot& snapshot);
+	// What applying the weights of the sites did, all zero when every weight is 0
+	const PowerDiagramReport& GetPowerReport() const { return PowerReport; }
+	// Bisectors and edge points held for reuse, as many as the largest sweep since the
+	// algorithm was made needed
+	size_t GetEdgeRecords() const { return Bisectors.size() + EdgePoints.size(); }
+	// Unlinks the edges co-circular sites left with no length. Finishing does it, a sweep
+	// stopped early can too, the edges it drops have both ends.
+	void CleanZeroLengthEdges();
 
 
 private:
 // Fortunes Functions
 	void HandleSiteEvent(EventPoint* event);
 	void HandleCircleEvent(EventPoint* site);
-	void CheckForCircleEvent(BL::Arc* arc, bool potentinalVertexSplit = false);
+	void CheckForCircleEvent(BL::ArcRef arc);
+	bool IsSameCircle(BL::ArcRef a, BL::ArcRef b, BL::ArcRef c, BL::ArcRef d) const;
+	Vertex* FindOrAddVertex(const Point& point, const VoronoiSite* a, const VoronoiSite* b, const VoronoiSite* c);
+	void Finish();
 	void CleanRemainingTree();
-	void CleanZeroLengthEdges();
+	void ClipToBox(Edge breakpoint, std::vector<HalfEdge*>& boundingEdges, Face* unbounded, Face* triUnbounded);
 	void FillOuterEdgesIncidentFaces();
 	void UpdateBounds(const Point& point);
-
-// Tree Functions
-	BL::Arc* FindArcAtX(double x);
-
-	BL::Arc* GetLeftParent(BL::Arc* root);
-	BL::Arc* GetRightParent(BL::Arc* root);
-
-	BL::Arc* GetClosestLeftChild(BL::Arc* root);
-	BL::Arc* GetClosestRightChild(BL::Arc* root);
-
-	void RightRotation(BL::Arc* arc);
-	void LeftRotation(BL::Arc* arc);
-	void ReplaceParentsChild(BL::Arc* parent, BL::Arc* oldChild, BL::Arc* newChild);
-
-	void FixRedBlackPropertiesAfterInsert(BL::Arc* arc);
-	void FixRedBlackPropertiesAfterDelete(BL::Arc* arc);
-	BL::Arc* GetUncle(BL::Arc* parent);
-
-	void PrintTreeInOrder(BL::Arc* arc, int depth = 0);
-	void TreeInOrder(BL::Arc* arc);
+	void RestoreSweepAxis();
+	void DeleteEvent(EventPoint* event);
+	Bisector* NewBisector(Point* start, VoronoiSite* left, VoronoiSite* right);
+	Point* NewEdgePoint(Real x, Real y);
 
 	VoronoiDiagram& Diagram;
 	PriorityQueue* Queue;
-	BL::Arc* Root;
+	BeachLine* Beach;
 	VoronoiSite* FirstSite;
-	double SweepHeight;
+	Real SweepHeight;
 	bool Complete;
+	bool Transposed;
+	// Some site has a weight, the diagram is then built from the regular triangulation
+	// without a sweep
+	bool Weighted;
+	PowerDiagramReport PowerReport;
 	int NumVoronoiSites;
 	int NumBoundingVertices;
 	int NumTriangles;
-	DCEL::Vertex* LastVistedVertex;
+	int NumArcs;
+	SweepAxis Axis;
+	bool Verbose;
+	// A vertex made around the current event height and three of the sites it is equidistant to
+	struct RecentVertex
+	{
+		Vertex* vertex;
+		const VoronoiSite* sites[3];
+	};
+	// Keyed on coordinates snapped to VertexSnap, distinct vertices can share a cell
+	std::unordered_multimap<CellKey, RecentVertex, CellKeyHash> RecentVertices;
+	Real RecentHeight;
+	Real VertexSnap;
 
 // Utility Variables
-	std::vector<BL::Arc*> InOrderArcs;
-	std::vector<BL::Edge*> CompletedEdges;
-	std::vector<BL::Edge*> IniniteEdges;
+	std::vector<BL::ArcRef> InOrderArcs;
+	std::vector<Edge> CompletedEdges;
+	std::vector<Edge> IniniteEdges;
+	// Bisectors between sites level with the first site, open upwards until the box closes them
+	std::vector<Edge> FirstRowEdges;
+	// Every bisector and edge point made so far, the first Used of each are in this sweep
+	std::vector<Bisector*> Bisectors;
+	std::vector<Point*> EdgePoints;
+	size_t UsedBisectors;
+	size_t UsedEdgePoints;
 
 public:
 // Voronoi Needed Variables
-	double MinX, MinY, MaxX, MaxY;
+	Real MinX, MinY, MaxX, MaxY;
 };
 
-struct Point;
-
-// We combine the ideas of a perpindicular bisector and a halfedge to create an edge
-// These can be used to render the Voronoi Diagram as well
-namespace BL
-{
-	class Edge
-	{
-	public:
-		Edge(Point* start, VoronoiSite* left, VoronoiSite* right);
-		~Edge();
-
-		Point* Start;
-		Point* End;
-		VoronoiSite* Left;
-		VoronoiSite* Right;
-		DCEL::HalfEdge* HalfEdge;
-		DCEL::HalfEdge* TriHalfEdge;
-
-		Edge* Neighbour;
-		Point Line;
-		Point Direction;
-		bool IsVertical;
-
-		Point* Intersect(Edge* edge);
-		Point RenderEdge(double y);
-	};
-
-	class Arc
-	{
-	public:
-		enum TreeColor
-		{
-			Red,
-			Black
-		};
-
-		Arc(VoronoiSite* site);
-		Arc(Edge* site);
-		VoronoiSite* Site;
-		Edge* Edge;
-		EventPoint* CircleEvent;
-		Arc* Parent;
-		Arc* Left;
-		Arc* Right;
-
-
-		bool Leaf;
-		TreeColor Color;
-
-		void SetLeft(Arc* a);
-		void SetRight(Arc* a);
-	};
-}
+typedef BasicFortunesAlgorithm<double> FortunesAlgorithm;
 
 // Parameters
 //		left   : the left parabola focus point
@@ -141,12 +144,14 @@ namespace BL
 //		lh     : the line height of the sweep line
 // Uses equation presented on page 153 of Computational Geometry Algorithms and Applications 3rd Edition
 // too calculate the intersection between two parabolas and return the point between them.
-double IntersectionX(const Point& left, const Point& right, const double lh);
+template<typename Real>
+Real IntersectionX(const BasicPoint<Real>& left, const BasicPoint<Real>& right, const Real lh);
 
 // Parameters
 //		x     : the x coordinate on the parabola
 //		lh    : the line height of the sweep line
 //		point : the focus point of the parabola
 // The equation presented on page 153 of Computational Geometry Algorithms and Applications 3rd Edition
-double CalculateParabolaY(const double x, const double lh, const Point& point);
+template<typename Real>
+Real CalculateParabolaY(const Real x, const Real lh, const BasicPoint<Real>& point);
 
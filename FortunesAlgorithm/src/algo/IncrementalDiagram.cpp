@@ -0,0 +1,710 @@
+#include "IncrementalDiagram.h"
+
+#include "DelaunayQueries.h"
+#include "FortunesAlgorithm.h"
+#include "Predicates.h"
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	////////////////////////////////////////////////////////////////////
+	// The half-edges leaving the vertex, counterclockwise. False when the vertex is on the
+	// hull or its fan does not close.
+	template<typename T>
+	bool Spokes(DCEL::BasicVertex<T>* vertex, std::vector<DCEL::BasicHalfEdge<T>*>& spokes)
+	{
+		typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+		spokes.clear();
+		HalfEdge* start = vertex->incidentEdge;
+		HalfEdge* edge = start;
+		do
+		{
+			if (nullptr == edge || edge->origin != vertex || nullptr == edge->incidentFace || edge->incidentFace->Unbounded
+				|| nullptr == edge->prev || spokes.size() > FanLimit)
+				return false;
+			spokes.push_back(edge);
+			edge = edge->prev->twin;
+		} while (edge != start);
+		return true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicIncrementalDiagram<T>::BasicIncrementalDiagram(VoronoiDiagram& diagram)
+	: Diagram(diagram)
+	, Changed()
+	, LastRebuilt(false)
+	, Hint(nullptr)
+	, Sampler()
+	, MinX(0)
+	, MinY(0)
+	, MaxX(0)
+	, MaxY(0)
+	, Snap(0)
+{
+	MeasureBox();
+	for (size_t input = 0; input < Diagram.SiteOfInput.size(); input++)
+	{
+		const int index = Diagram.SiteOfInput[input];
+		if (index > 0 && Diagram.InputOrder[index - 1] != int(input))
+			OtherInputs.insert({ index, int(input) });
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicIncrementalDiagram<T>::VoronoiSite* BasicIncrementalDiagram<T>::InsertSite(const BasicPoint<T>& input)
+{
+	Changed.clear();
+	LastRebuilt = false;
+	if (!CoordinateTraits<T>::Holds(input))
+		return nullptr;
+
+	const Point point(Real(input.x), Real(input.y));
+	VoronoiSite* existing = nullptr;
+	Face* triangle = LocateTriangle(point, existing);
+	if (existing)
+		return existing;
+
+	// Record the site the way the diagram's constructor does
+	const int index = int(Diagram.Sites.size()) + 1;
+	Diagram.Points.push_back(input);
+	Diagram.InputOrder.push_back(int(Diagram.Points.size()) - 1);
+	Diagram.SiteOfInput.push_back(index);
+	Diagram.MinX = std::min(Diagram.MinX, point.x);
+	Diagram.MinY = std::min(Diagram.MinY, point.y);
+	Diagram.MaxX = std::max(Diagram.MaxX, point.x);
+	Diagram.MaxY = std::max(Diagram.MaxY, point.y);
+
+	VoronoiSite* site = new VoronoiSite({ point, nullptr, nullptr, index });
+	Diagram.Sites.push_back(site);
+	Diagram.InvalidateMetrics();
+	Hint = site;
+
+	// Outside the hull the hull itself changes
+	if (nullptr == triangle)
+	{
+		RebuildAll();
+		return site;
+	}
+
+	site->face = Diagram.NewFace({ site, nullptr, nullptr, false, 0 });
+	AddBounded(Diagram.Faces, site->face);
+	site->triVertex = Diagram.NewVertex({ index, point, nullptr });
+	Diagram.TriangulationVertices.push_back(site->triVertex);
+
+	HalfEdge* onEdge = nullptr;
+	HalfEdge* edge = triangle->outerComponent;
+	for (int i = 0; i < 3; i++, edge = edge->next)
+	{
+		if (0 == SitePredicates<T>::Orientation(edge->origin->point, edge->dest->point, point))
+			onEdge = edge;
+	}
+
+	std::vector<HalfEdge*> suspect;
+	auto newEdge = [this]() { return NewTriangleEdge(Diagram, SpareTriangleEdges); };
+	auto newTriangle = [this]() { return NewTriangle(Diagram, SpareTriangles); };
+	if (nullptr == onEdge)
+	{
+		// The edges facing the new vertex are those of its fan
+		SplitTriangle(triangle, site->triVertex, newEdge, newTriangle);
+		HalfEdge* spoke = site->triVertex->incidentEdge;
+		for (int i = 0; i < 3; i++, spoke = spoke->prev->twin)
+			suspect.push_back(spoke->next);
+	}
+	else if (onEdge->twin && onEdge->twin->incidentFace && !onEdge->twin->incidentFace->Unbounded)
+	{
+		SplitEdge(onEdge, site->triVertex, newEdge, newTriangle);
+		HalfEdge* spoke = site->triVertex->incidentEdge;
+		for (int i = 0; i < 4; i++, spoke = spoke->prev->twin)
+			suspect.push_back(spoke->next);
+	}
+	else
+	{
+		// On a hull edge
+		RebuildAll();
+		return site;
+	}
+	Legalize(suspect, site->triVertex);
+
+	std::vector<HalfEdge*> spokes;
+	std::vector<VoronoiSite*> affected = { site };
+	if (Spokes(site->triVertex, spokes))
+	{
+		for (HalfEdge* spoke : spokes)
+			affected.push_back(Diagram.Sites[spoke->dest->index - 1]);
+	}
+
+	if (affected.size() < 4 || !RebuildCells(affected, nullptr))
+		RebuildAll();
+	return site;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicIncrementalDiagram<T>::RemoveSite(VoronoiSite* site)
+{
+	Changed.clear();
+	LastRebuilt = false;
+	Diagram.InvalidateMetrics();
+	if (Hint == site)
+		Hint = nullptr;
+
+	Face* removedFace = site->face;
+	Vertex* removedVertex = site->triVertex;
+	std::vector<VoronoiSite*> ring;
+	const bool local = removedVertex && RemoveFromTriangulation(site, ring);
+
+	// The last site fills the gap so no other site is renumbered
+	const int index = site->index;
+	const int last = int(Diagram.Sites.size());
+	VoronoiSite* moved = Diagram.Sites.back();
+	Diagram.Sites[index - 1] = moved;
+	Diagram.Sites.pop_back();
+	Diagram.SiteOfInput[Diagram.InputOrder[index - 1]] = 0;
+	Diagram.InputOrder[index - 1] = Diagram.InputOrder.back();
+	Diagram.InputOrder.pop_back();
+	const auto removedInputs = OtherInputs.equal_range(index);
+	for (auto input = removedInputs.first; input != removedInputs.second; ++input)
+		Diagram.SiteOfInput[input->second] = 0;
+	OtherInputs.erase(index);
+	if (moved != site)
+	{
+		moved->index = index;
+		if (moved->triVertex)
+			moved->triVertex->index = index;
+		Diagram.SiteOfInput[Diagram.InputOrder[index - 1]] = index;
+		const auto movedInputs = OtherInputs.equal_range(last);
+		std::vector<int> inputs;
+		for (auto input = movedInputs.first; input != movedInputs.second; ++input)
+			inputs.push_back(input->second);
+		OtherInputs.erase(last);
+		for (int input : inputs)
+		{
+			Diagram.SiteOfInput[input] = index;
+			OtherInputs.insert({ index, input });
+		}
+	}
+
+	if (local && RebuildCells(ring, removedFace))
+	{
+		std::vector<Face*> faces = { removedFace };
+		TakeOutRecords(Diagram.Faces, faces, [this](Face* from, Face* to)
+		{
+			std::replace(Changed.begin(), Changed.end(), from, to);
+		});
+		std::vector<Vertex*> vertices = { removedVertex };
+		TakeOutRecords(Diagram.TriangulationVertices, vertices, [this](Vertex* from, Vertex* to)
+		{
+			Diagram.Sites[to->index - 1]->triVertex = to;
+		});
+	}
+	else
+	{
+		RebuildAll();
+	}
+	delete site;
+}
+
+////////////////////////////////////////////////////////////////////
+// Walks from the nearest site's triangles towards the point, crossing whichever edge has
+// the point on its outer side. Returns nullptr outside the hull, or with existing set
+// when a site is already at the point.
+template<typename T>
+typename BasicIncrementalDiagram<T>::Face* BasicIncrementalDiagram<T>::LocateTriangle(const Point& point, VoronoiSite*& existing)
+{
+	existing = nullptr;
+	if (Diagram.Sites.empty())
+		return nullptr;
+
+	// The walk starts from the nearest of about the cube root of the sites, taken at
+	// random, which cuts it from about the square root of the sites to the cube root
+	auto distance = [&point](const VoronoiSite* site)
+	{
+		const Real dx = site->point.x - point.x, dy = site->point.y - point.y;
+		return dx * dx + dy * dy;
+	};
+	VoronoiSite* start = Hint;
+	const size_t samples = size_t(std::cbrt(double(Diagram.Sites.size())));
+	for (size_t i = 0; i < samples; i++)
+	{
+		VoronoiSite* sample = Diagram.Sites[Sampler() % Diagram.Sites.size()];
+		if (nullptr == start || distance(sample) < distance(start))
+			start = sample;
+	}
+
+	VoronoiSite* nearest = NearestSite(Diagram, point, start);
+	if (nearest->point == point)
+	{
+		existing = nearest;
+		return nullptr;
+	}
+
+	Vertex* vertex = nearest->triVertex;
+	HalfEdge* edge = vertex ? vertex->incidentEdge : nullptr;
+	for (size_t steps = 0; edge && edge->incidentFace && edge->incidentFace->Unbounded && steps < FanLimit; steps++)
+		edge = edge->prev ? edge->prev->twin : nullptr;
+	if (nullptr == edge || nullptr == edge->incidentFace || edge->incidentFace->Unbounded)
+		return nullptr;
+
+	Face* triangle = edge->incidentFace;
+	const size_t limit = Diagram.TriangulationFaces.size() + 1;
+	for (size_t step = 0; step < limit; step++)
+	{
+		// Testing from a different edge each step keeps the walk from circling
+		HalfEdge* first = triangle->outerComponent;
+		for (size_t skip = step % 3; skip > 0; skip--)
+			first = first->next;
+
+		HalfEdge* across = nullptr;
+		HalfEdge* side = first;
+		for (int i = 0; i < 3; i++, side = side->next)
+		{
+			if (SitePredicates<T>::Orientation(side->origin->point, side->dest->point, point) < 0)
+			{
+				across = side;
+				break;
+			}
+		}
+		if (nullptr == across)
+			return triangle;
+
+		triangle = across->twin ? across->twin->incidentFace : nullptr;
+		if (nullptr == triangle || triangle->Unbounded)
+			return nullptr;
+	}
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+// Every edge facing the new vertex whose far triangle has the vertex inside its circle is
+// flipped to the vertex, and the two edges that then face it are checked in turn
+template<typename T>
+void BasicIncrementalDiagram<T>::Legalize(std::vector<HalfEdge*>& edges, Vertex* v)
+{
+	while (!edges.empty())
+	{
+		HalfEdge* edge = edges.back();
+		edges.pop_back();
+
+		HalfEdge* twin = edge->twin;
+		if (nullptr == twin || nullptr == twin->incidentFace || twin->incidentFace->Unbounded)
+			continue;
+
+		const Vertex* far = twin->next->dest;
+		if (SitePredicates<T>::InCircle(edge->origin->point, edge->dest->point, v->point, far->point) > 0)
+		{
+			HalfEdge* xz = twin->next;
+			HalfEdge* zy = twin->prev;
+			FlipEdge(edge);
+			edges.push_back(xz);
+			edges.push_back(zy);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Takes out the site's triangles and fills the hole with ears whose circles hold no other
+// corner of the hole, which are the Delaunay triangles of the hole. Returns false, having
+// changed nothing, when the site is on the hull.
+template<typename T>
+bool BasicIncrementalDiagram<T>::RemoveFromTriangulation(VoronoiSite* site, std::vector<VoronoiSite*>& ring)
+{
+	std::vector<HalfEdge*> spokes;
+	if (!Spokes(site->triVertex, spokes) || spokes.size() < 3)
+		return false;
+
+	std::vector<Vertex*> corners;
+	std::vector<HalfEdge*> sides;
+	for (HalfEdge* spoke : spokes)
+	{
+		corners.push_back(spoke->dest);
+		sides.push_back(spoke->next);
+		ring.push_back(Diagram.Sites[spoke->dest->index - 1]);
+
+		SpareTriangles.push_back(spoke->incidentFace);
+		SpareTriangleEdges.push_back(spoke);
+		SpareTriangleEdges.push_back(spoke->twin);
+	}
+	for (size_t i = 0; i < corners.size(); i++)
+		corners[i]->incidentEdge = sides[i];
+
+	const std::vector<Vertex*> hole = corners;
+	while (corners.size() > 3)
+	{
+		const size_t count = corners.size();
+		size_t ear = count, convex = count;
+		for (size_t i = 0; i < count && ear == count; i++)
+		{
+			const Vertex* a = corners[(i + count - 1) % count];
+			const Vertex* b = corners[i];
+			const Vertex* c = corners[(i + 1) % count];
+			if (SitePredicates<T>::Orientation(a->point, b->point, c->point) <= 0)
+				continue;
+			if (count == convex)
+				convex = i;
+
+			bool empty = true;
+			for (const Vertex* other : hole)
+			{
+				if (other != a && other != b && other != c && SitePredicates<T>::InCircle(a->point, b->point, c->point, other->point) > 0)
+				{
+					empty = false;
+					break;
+				}
+			}
+			if (empty)
+				ear = i;
+		}
+		if (count == ear)
+			ear = (count == convex) ? 1 : convex;
+
+		const size_t before = (ear + count - 1) % count;
+		const size_t after = (ear + 1) % count;
+		HalfEdge* ca = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		HalfEdge* ac = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		Join(ca, corners[after], corners[before], ac);
+		Join(ac, corners[before], corners[after], ca);
+		LinkTriangle(sides[before], sides[ear], ca, NewTriangle(Diagram, SpareTriangles));
+
+		sides[before] = ac;
+		corners.erase(corners.begin() + ear);
+		sides.erase(sides.begin() + ear);
+	}
+	LinkTriangle(sides[0], sides[1], sides[2], NewTriangle(Diagram, SpareTriangles));
+
+	auto unmoved = [](auto, auto) {};
+	TakeOutRecords(Diagram.TriangulationFaces, SpareTriangles, unmoved);
+	TakeOutRecords(Diagram.TriangulationHalfEdges, SpareTriangleEdges, unmoved);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Rebuilds the cells of the affected sites as the duals of their triangles. Edges shared
+// with cells that are not affected are kept, and tell which vertex records the cells keep.
+// Returns false, having changed nothing, when a cell reaches the box or the old cells do
+// not fit the triangulation.
+template<typename T>
+bool BasicIncrementalDiagram<T>::RebuildCells(const std::vector<VoronoiSite*>& affected, Face* removedFace)
+{
+	const size_t none = size_t(-1);
+	auto position = [&affected](const VoronoiSite* site) -> size_t
+	{
+		return size_t(std::find(affected.begin(), affected.end(), site) - affected.begin());
+	};
+	auto isAffected = [&](const VoronoiSite* site) { return position(site) < affected.size(); };
+
+	std::vector<std::vector<HalfEdge*>> spokes(affected.size());
+	for (size_t i = 0; i < affected.size(); i++)
+	{
+		if (nullptr == affected[i]->triVertex || !Spokes(affected[i]->triVertex, spokes[i]))
+			return false;
+		for (HalfEdge* spoke : spokes[i])
+		{
+			const int index = spoke->dest->index;
+			if (index < 1 || index > int(Diagram.Sites.size()) || Diagram.Sites[index - 1]->triVertex != spoke->dest)
+				return false;
+		}
+	}
+
+	// The old boundaries, as edges to keep and edges between two rebuilt cells
+	std::vector<Face*> oldFaces;
+	for (VoronoiSite* site : affected)
+	{
+		if (site->face && site->face->outerComponent)
+			oldFaces.push_back(site->face);
+	}
+	if (removedFace)
+		oldFaces.push_back(removedFace);
+
+	std::vector<HalfEdge*> kept, internal;
+	const size_t limit = Diagram.HalfEdges.size();
+	for (Face* face : oldFaces)
+	{
+		HalfEdge* edge = face->outerComponent;
+		size_t steps = 0;
+		do
+		{
+			if (nullptr == edge || nullptr == edge->origin || nullptr == edge->dest || edge->origin->box || edge->dest->box
+				|| edge->incidentFace != face || nullptr == edge->twin || nullptr == edge->twin->incidentFace
+				|| edge->twin->incidentFace->Unbounded || nullptr == edge->twin->incidentFace->site || steps++ > limit)
+				return false;
+
+			const Face* across = edge->twin->incidentFace;
+			if (across == removedFace || isAffected(across->site))
+				internal.push_back(edge);
+			else
+				kept.push_back(edge);
+			edge = edge->next;
+		} while (edge != face->outerComponent);
+	}
+
+	// The corner every triangle about the affected sites maps to
+	std::vector<Corner> corners;
+	std::vector<Face*> triangles;
+	std::vector<size_t> cornerOf;
+	auto slot = [&](Face* triangle) -> size_t&
+	{
+		for (size_t i = 0; i < triangles.size(); i++)
+		{
+			if (triangles[i] == triangle)
+				return cornerOf[i];
+		}
+		triangles.push_back(triangle);
+		cornerOf.push_back(none);
+		return cornerOf.back();
+	};
+	auto cornerOfRecord = [&](Vertex* record) -> size_t
+	{
+		for (size_t i = 0; i < corners.size(); i++)
+		{
+			if (corners[i].record == record)
+				return i;
+		}
+		corners.push_back({ record->point, record });
+		return corners.size() - 1;
+	};
+	auto keptBetween = [&](const VoronoiSite* site, const VoronoiSite* other) -> HalfEdge*
+	{
+		for (HalfEdge* edge : kept)
+		{
+			if (edge->incidentFace->site == site && edge->twin->incidentFace->site == other)
+				return edge;
+		}
+		return nullptr;
+	};
+
+	// A kept edge runs from the vertex of the triangle right of its Delaunay edge to the
+	// vertex of the one left of it, as every cell runs counterclockwise
+	for (HalfEdge* edge : kept)
+	{
+		const size_t i = position(edge->incidentFace->site);
+		const Vertex* other = edge->twin->incidentFace->site->triVertex;
+		HalfEdge* spoke = nullptr;
+		for (HalfEdge* candidate : spokes[i])
+		{
+			if (candidate->dest == other)
+				spoke = candidate;
+		}
+		if (nullptr == spoke)
+			return false;
+
+		const size_t right = cornerOfRecord(edge->origin);
+		const size_t left = cornerOfRecord(edge->dest);
+		size_t& rightSlot = slot(spoke->twin->incidentFace);
+		if (none != rightSlot && right != rightSlot)
+			return false;
+		rightSlot = right;
+		size_t& leftSlot = slot(spoke->incidentFace);
+		if (none != leftSlot && left != leftSlot)
+			return false;
+		leftSlot = left;
+	}
+
+	// The other triangles get their circumcentre, or a corner already within the snap of it
+	for (size_t i = 0; i < affected.size(); i++)
+	{
+		for (HalfEdge* spoke : spokes[i])
+		{
+			size_t& corner = slot(spoke->incidentFace);
+			if (none != corner)
+				continue;
+
+			const HalfEdge* first = spoke->incidentFace->outerComponent;
+			const Point centre = Circumcentre(first->origin->point, first->next->origin->point, first->prev->origin->point);
+			if (!(centre.x > MinX && centre.x < MaxX && centre.y > MinY && centre.y < MaxY))
+				return false;
+
+			for (size_t k = 0; k < corners.size() && none == corner; k++)
+			{
+				if (std::abs(corners[k].point.x - centre.x) <= Snap && std::abs(corners[k].point.y - centre.y) <= Snap)
+					corner = k;
+			}
+			if (none == corner)
+			{
+				corners.push_back({ centre, nullptr });
+				corner = corners.size() - 1;
+			}
+		}
+	}
+
+	// A neighbour that is kept but shares no kept edge meets the cell in a point
+	for (size_t i = 0; i < affected.size(); i++)
+	{
+		for (HalfEdge* spoke : spokes[i])
+		{
+			const VoronoiSite* other = Diagram.Sites[spoke->dest->index - 1];
+			if (!isAffected(other) && slot(spoke->twin->incidentFace) != slot(spoke->incidentFace) && !keptBetween(affected[i], other))
+				return false;
+		}
+	}
+
+	// From here on the diagram changes. Records the old cells no longer need are reused
+	// before new ones are made.
+	std::vector<Vertex*> spareVertices;
+	auto retire = [&](Vertex* vertex)
+	{
+		for (const Corner& corner : corners)
+		{
+			if (corner.record == vertex)
+				return;
+		}
+		if (std::find(spareVertices.begin(), spareVertices.end(), vertex) == spareVertices.end())
+			spareVertices.push_back(vertex);
+	};
+	for (HalfEdge* edge : internal)
+	{
+		retire(edge->origin);
+		retire(edge->dest);
+	}
+	std::vector<HalfEdge*> spareEdges = internal;
+
+	for (Corner& corner : corners)
+	{
+		if (corner.record)
+			continue;
+		if (spareVertices.empty())
+		{
+			corner.record = Diagram.NewVertex({ 0, corner.point, nullptr });
+			Diagram.Vertices.push_back(corner.record);
+		}
+		else
+		{
+			corner.record = spareVertices.back();
+			spareVertices.pop_back();
+			*corner.record = Vertex({ 0, corner.point, nullptr });
+		}
+		corner.record->index = int(Diagram.Vertices.size());
+	}
+
+	auto newEdge = [&]() -> HalfEdge*
+	{
+		if (spareEdges.empty())
+		{
+			Diagram.HalfEdges.push_back(Diagram.NewHalfEdge(HalfEdge()));
+			return Diagram.HalfEdges.back();
+		}
+		HalfEdge* edge = spareEdges.back();
+		spareEdges.pop_back();
+		*edge = HalfEdge();
+		return edge;
+	};
+
+	std::vector<std::pair<const VoronoiSite*, HalfEdge*>> made;
+	std::vector<HalfEdge*> loop;
+	for (size_t i = 0; i < affected.size(); i++)
+	{
+		VoronoiSite* site = affected[i];
+		loop.clear();
+		for (HalfEdge* spoke : spokes[i])
+		{
+			VoronoiSite* other = Diagram.Sites[spoke->dest->index - 1];
+			const size_t right = slot(spoke->twin->incidentFace);
+			const size_t left = slot(spoke->incidentFace);
+			if (right == left)
+				continue;
+
+			HalfEdge* edge = nullptr;
+			if (!isAffected(other))
+			{
+				edge = keptBetween(site, other);
+			}
+			else
+			{
+				// The neighbour may have made this edge already, as the twin of its own
+				for (const std::pair<const VoronoiSite*, HalfEdge*>& pair : made)
+				{
+					if (pair.first == other && pair.second->twin->incidentFace == site->face)
+						edge = pair.second->twin;
+				}
+				if (nullptr == edge)
+				{
+					edge = newEdge();
+					HalfEdge* twin = newEdge();
+					Join(edge, corners[right].record, corners[left].record, twin);
+					Join(twin, corners[left].record, corners[right].record, edge);
+					twin->incidentFace = other->face;
+					made.push_back({ site, edge });
+				}
+			}
+			loop.push_back(edge);
+		}
+
+		for (size_t j = 0; j < loop.size(); j++)
+		{
+			HalfEdge* next = loop[(j + 1) % loop.size()];
+			loop[j]->next = next;
+			next->prev = loop[j];
+			loop[j]->incidentFace = site->face;
+			loop[j]->origin->incidentEdge = loop[j];
+		}
+		site->face->outerComponent = loop.empty() ? nullptr : loop.front();
+		Changed.push_back(site->face);
+	}
+
+	auto unmoved = [](auto, auto) {};
+	TakeOutRecords(Diagram.HalfEdges, spareEdges, unmoved);
+	TakeOutRecords(Diagram.Vertices, spareVertices, unmoved);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicIncrementalDiagram<T>::RebuildAll()
+{
+	// Spares are still in the containers, which the clear sets aside
+	SpareTriangles.clear();
+	SpareTriangleEdges.clear();
+
+	Diagram.ClearDCEL();
+	if (!Diagram.Sites.empty())
+	{
+		BasicFortunesAlgorithm<T> algorithm(Diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+	}
+	MeasureBox();
+
+	Changed.clear();
+	for (VoronoiSite* site : Diagram.Sites)
+	{
+		if (site->face)
+			Changed.push_back(site->face);
+	}
+	LastRebuilt = true;
+}
+
+////////////////////////////////////////////////////////////////////
+// With no box left by the sweep no circumcentre is inside it and every update rebuilds
+template<typename T>
+void BasicIncrementalDiagram<T>::MeasureBox()
+{
+	MinX = MinY = std::numeric_limits<Real>::max();
+	MaxX = MaxY = -std::numeric_limits<Real>::max();
+	for (const Vertex* vertex : Diagram.Vertices)
+	{
+		if (!vertex->box)
+			continue;
+		MinX = std::min(MinX, vertex->point.x);
+		MinY = std::min(MinY, vertex->point.y);
+		MaxX = std::max(MaxX, vertex->point.x);
+		MaxY = std::max(MaxY, vertex->point.y);
+	}
+
+	// As the sweep snaps its own vertices
+	const Real extent = std::max({ Real(1), Diagram.MaxX - Diagram.MinX, Diagram.MaxY - Diagram.MinY });
+	Snap = Real(64) * std::numeric_limits<Real>::epsilon() * extent;
+}
+
+template class BasicIncrementalDiagram<float>;
+template class BasicIncrementalDiagram<double>;
+template class BasicIncrementalDiagram<int64_t>;
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Adds and removes sites on a finished diagram without sweeping it again. The Delaunay
+// triangulation is updated in place, inserting by splitting the triangle holding the new
+// site and flipping until every edge is Delaunay again, removing by cutting the hole the
+// site leaves into Delaunay ears. Only the cells of the sites whose triangles changed are
+// then rebuilt, from the circumcentres of their triangles. The edges they share with the
+// rest of the diagram are kept as they are, so the work follows the size of the change.
+// Updates on the hull, whose cells run out to the bounding box, or whose new vertices
+// would fall outside that box, sweep the whole diagram again instead. The triangulation
+// kept is the Delaunay one, for unweighted sites.
+template<typename T>
+class BasicIncrementalDiagram
+{
+public:
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	// The diagram must have been run to completion
+	BasicIncrementalDiagram(VoronoiDiagram& diagram);
+
+	// Adds the point as a site with the next index and returns it. A point on an existing
+	// site changes nothing and returns that site, a point outside
+	// CoordinateTraits<T>::Holds is not added and returns nullptr.
+	VoronoiSite* InsertSite(const BasicPoint<T>& point);
+
+	// Deletes the site. The last site takes its place in Sites and its index, and
+	// SiteOfInput maps the inputs of the removed site to 0. The records it frees are
+	// filled by those at the end of the diagram's containers, so the records of another
+	// cell may change address.
+	void RemoveSite(VoronoiSite* site);
+
+	// The cells the last update created or changed
+	const std::vector<Face*>& ChangedFaces() const { return Changed; }
+	// Whether the last update swept the whole diagram again
+	bool Rebuilt() const { return LastRebuilt; }
+
+private:
+	// A Voronoi vertex as the rebuild of some cells needs it, either a record the cells
+	// keep or a circumcentre still to be given one
+	struct Corner
+	{
+		Point point;
+		Vertex* record;
+	};
+
+	Face* LocateTriangle(const Point& point, VoronoiSite*& existing);
+	void Legalize(std::vector<HalfEdge*>& edges, Vertex* vertex);
+	bool RemoveFromTriangulation(VoronoiSite* site, std::vector<VoronoiSite*>& ring);
+	bool RebuildCells(const std::vector<VoronoiSite*>& affected, Face* removedFace);
+	void RebuildAll();
+	void MeasureBox();
+
+	VoronoiDiagram& Diagram;
+	std::vector<Face*> Changed;
+	bool LastRebuilt;
+	VoronoiSite* Hint;
+	// Picks the sites a location compares before it walks
+	std::minstd_rand Sampler;
+
+	// The box the sweep clipped the diagram to and the distance below which two
+	// circumcentres are one Voronoi vertex
+	Real MinX, MinY, MaxX, MaxY;
+	Real Snap;
+
+	// Triangulation records a removal frees and reuses before deleting the rest
+	std::vector<Face*> SpareTriangles;
+	std::vector<HalfEdge*> SpareTriangleEdges;
+
+	// The inputs a site stands for besides the one InputOrder gives, which the prepass
+	// folds into it, so a removal need not scan SiteOfInput
+	std::unordered_multimap<int, int> OtherInputs;
+};
+
+typedef BasicIncrementalDiagram<double> IncrementalDiagram;
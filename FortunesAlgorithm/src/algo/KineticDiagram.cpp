@@ -0,0 +1,382 @@
+#include "KineticDiagram.h"
+
+#include "FortunesAlgorithm.h"
+#include "Predicates.h"
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	// The smallest part of a step the motion is cut into before sweeping again instead
+	const double MinimumPart = 1.0 / 65536.0;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicKineticDiagram<T>::BasicKineticDiagram(VoronoiDiagram& diagram)
+	: Diagram(diagram)
+	, Outside(nullptr)
+	, Cells(diagram)
+{
+	for (Face* face : Diagram.TriangulationFaces)
+	{
+		if (face->Unbounded)
+			Outside = face;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+KineticReport BasicKineticDiagram<T>::Advance(const BasicPoint<T>* positions)
+{
+	KineticReport report = { 0, 0, 0, false };
+	const size_t n = Diagram.Sites.size();
+	if (0 == n)
+		return report;
+
+	From.resize(n, Point(0, 0));
+	To.resize(n, Point(0, 0));
+	bool followed = nullptr != Outside && nullptr != Outside->innerComponent;
+	for (size_t i = 0; i < n; i++)
+	{
+		const BasicPoint<T>& position = positions[Diagram.InputOrder[i]];
+		From[i] = Diagram.Sites[i]->point;
+		To[i] = CoordinateTraits<T>::Holds(position) ? Point(Real(position.x), Real(position.y)) : From[i];
+		followed = followed && Diagram.Sites[i]->triVertex;
+	}
+	for (size_t i = 0; i < Diagram.Points.size(); i++)
+		if (CoordinateTraits<T>::Holds(positions[i]))
+			Diagram.Points[i] = positions[i];
+
+	Diagram.MinX = Diagram.MaxX = To[0].x;
+	Diagram.MinY = Diagram.MaxY = To[0].y;
+	for (const Point& point : To)
+	{
+		Diagram.MinX = std::min(Diagram.MinX, point.x);
+		Diagram.MinY = std::min(Diagram.MinY, point.y);
+		Diagram.MaxX = std::max(Diagram.MaxX, point.x);
+		Diagram.MaxY = std::max(Diagram.MaxY, point.y);
+	}
+	Diagram.InvalidateMetrics();
+
+	// Cut the motion in half until no triangle turns over within a part, and grow the
+	// parts again once past the trouble
+	double done = 0, part = 1;
+	while (followed && done < 1)
+	{
+		const double until = std::min(1.0, done + part);
+		Place(until);
+		if (Certify())
+		{
+			followed = Repair(report);
+			done = until;
+			part = std::min(1.0, part * 2);
+			report.Substeps++;
+		}
+		else
+		{
+			part /= 2;
+			followed = part >= MinimumPart;
+		}
+	}
+
+	if (!followed || !Cells.Build(Outside, false))
+		RebuildAll(report);
+	return report;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicKineticDiagram<T>::Place(double fraction)
+{
+	for (size_t i = 0; i < Diagram.Sites.size(); i++)
+	{
+		const Point point = (fraction >= 1) ? To[i] : Point(
+			From[i].x + (To[i].x - From[i].x) * Real(fraction),
+			From[i].y + (To[i].y - From[i].y) * Real(fraction));
+		Diagram.Sites[i]->point = point;
+		if (Diagram.Sites[i]->triVertex)
+			Diagram.Sites[i]->triVertex->point = point;
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Every triangle must still be counterclockwise and every hull corner convex. The only
+// failures that can be repaired are a hull triangle whose far corner crossed its hull
+// edge and a reflex hull corner, and only when no two of them share a site.
+template<typename T>
+bool BasicKineticDiagram<T>::Certify()
+{
+	Removals.clear();
+	Additions.clear();
+	std::vector<const Vertex*> touched;
+
+	for (Face* triangle : Diagram.TriangulationFaces)
+	{
+		if (triangle == Outside)
+			continue;
+
+		HalfEdge* first = triangle->outerComponent;
+		const double orientation = SitePredicates<T>::Orientation(first->origin->point, first->dest->point, first->next->dest->point);
+		if (orientation > 0)
+			continue;
+
+		HalfEdge* hullEdge = nullptr;
+		int onHull = 0;
+		HalfEdge* edge = first;
+		for (int i = 0; i < 3; i++, edge = edge->next)
+		{
+			if (edge->twin->incidentFace == Outside)
+			{
+				hullEdge = edge;
+				onHull++;
+			}
+		}
+		if (0 == orientation || 1 != onHull || !IsInterior(hullEdge->prev->origin))
+			return false;
+
+		Removals.push_back(hullEdge);
+		touched.insert(touched.end(), { hullEdge->origin, hullEdge->dest, hullEdge->prev->origin });
+	}
+
+	// The outside loop runs b to a after c to b for hull corners a, b, c counterclockwise
+	HalfEdge* start = Outside->innerComponent;
+	HalfEdge* edge = start;
+	size_t steps = 0;
+	do
+	{
+		const Vertex* a = edge->dest;
+		const Vertex* b = edge->origin;
+		const Vertex* c = edge->prev->origin;
+		if (SitePredicates<T>::Orientation(a->point, b->point, c->point) < 0)
+		{
+			Additions.push_back(edge);
+			touched.insert(touched.end(), { a, b, c });
+		}
+		edge = edge->next;
+		if (++steps > Diagram.TriangulationHalfEdges.size())
+			return false;
+	} while (edge != start);
+
+	std::sort(touched.begin(), touched.end());
+	return std::adjacent_find(touched.begin(), touched.end()) == touched.end();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+bool BasicKineticDiagram<T>::Repair(KineticReport& report)
+{
+	if (!Removals.empty() || !Additions.empty())
+	{
+		for (HalfEdge* hullEdge : Removals)
+			RemoveHullTriangle(hullEdge);
+		for (HalfEdge* outside : Additions)
+		{
+			if (!AddHullTriangle(outside))
+				return false;
+		}
+		report.HullEvents += Removals.size() + Additions.size();
+
+		// A corner next to a triangle taken away can have turned reflex
+		const size_t limit = Diagram.TriangulationHalfEdges.size();
+		for (size_t added = 0; ; )
+		{
+			HalfEdge* start = Outside->innerComponent;
+			HalfEdge* edge = start;
+			HalfEdge* reflex = nullptr;
+			size_t steps = 0;
+			do
+			{
+				if (SitePredicates<T>::Orientation(edge->dest->point, edge->origin->point, edge->prev->origin->point) < 0)
+					reflex = edge;
+				edge = edge->next;
+				if (++steps > limit)
+					return false;
+			} while (edge != start && nullptr == reflex);
+
+			if (nullptr == reflex)
+				break;
+			if (++added > limit || !AddHullTriangle(reflex))
+				return false;
+			report.HullEvents++;
+		}
+
+		DropRecords(Diagram.TriangulationFaces, SpareTriangles);
+		DropRecords(Diagram.TriangulationHalfEdges, SpareTriangleEdges);
+	}
+	return Legalize(report);
+}
+
+////////////////////////////////////////////////////////////////////
+// Takes away the triangle a, b, c on the hull edge a to b, its far corner c joins the hull
+template<typename T>
+void BasicKineticDiagram<T>::RemoveHullTriangle(HalfEdge* hullEdge)
+{
+	HalfEdge* outside = hullEdge->twin;
+	HalfEdge* bc = hullEdge->next;
+	HalfEdge* ca = bc->next;
+	HalfEdge* before = outside->prev;
+	HalfEdge* after = outside->next;
+
+	before->next = bc;
+	bc->prev = before;
+	bc->next = ca;
+	ca->prev = bc;
+	ca->next = after;
+	after->prev = ca;
+	bc->incidentFace = ca->incidentFace = Outside;
+	if (Outside->innerComponent == outside)
+		Outside->innerComponent = bc;
+
+	hullEdge->origin->incidentEdge = ca->twin;
+	hullEdge->dest->incidentEdge = before->twin;
+	ca->origin->incidentEdge = bc->twin;
+
+	SpareTriangles.push_back(hullEdge->incidentFace);
+	SpareTriangleEdges.push_back(hullEdge);
+	SpareTriangleEdges.push_back(outside);
+}
+
+////////////////////////////////////////////////////////////////////
+// Fills the reflex hull corner b between a and c with the triangle a, c, b. Returns
+// false, having changed nothing, when a neighbour of b stands inside it.
+template<typename T>
+bool BasicKineticDiagram<T>::AddHullTriangle(HalfEdge* outside)
+{
+	HalfEdge* cb = outside->prev;
+	HalfEdge* before = cb->prev;
+	HalfEdge* after = outside->next;
+	Vertex* a = outside->dest;
+	Vertex* b = outside->origin;
+	Vertex* c = cb->origin;
+	if (before == after)
+		return false;
+
+	size_t steps = 0;
+	HalfEdge* spoke = b->incidentEdge;
+	do
+	{
+		const Point& d = spoke->dest->point;
+		if (spoke->dest != a && spoke->dest != c
+			&& SitePredicates<T>::Orientation(a->point, c->point, d) > 0
+			&& SitePredicates<T>::Orientation(c->point, b->point, d) > 0
+			&& SitePredicates<T>::Orientation(b->point, a->point, d) > 0)
+			return false;
+		spoke = spoke->prev->twin;
+	} while (spoke != b->incidentEdge && ++steps < FanLimit);
+
+	steps = 0;
+	spoke = c->incidentEdge;
+	do
+	{
+		if (spoke->dest == a)
+			return false;
+		spoke = spoke->prev->twin;
+	} while (spoke != c->incidentEdge && ++steps < FanLimit);
+
+	HalfEdge* ac = NewTriangleEdge(Diagram, SpareTriangleEdges);
+	HalfEdge* ca = NewTriangleEdge(Diagram, SpareTriangleEdges);
+	ac->origin = ca->dest = a;
+	ac->dest = ca->origin = c;
+	ac->twin = ca;
+	ca->twin = ac;
+
+	before->next = ca;
+	ca->prev = before;
+	ca->next = after;
+	after->prev = ca;
+	ca->incidentFace = Outside;
+	if (Outside->innerComponent == outside || Outside->innerComponent == cb)
+		Outside->innerComponent = ca;
+
+	LinkTriangle(ac, cb, outside, NewTriangle(Diagram, SpareTriangles));
+	b->incidentEdge = outside;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+// Lawson's flips. With every triangle counterclockwise an edge that is not Delaunay has
+// a convex quadrilateral about it, so it can always be flipped, and the flips end in
+// the Delaunay triangulation.
+template<typename T>
+bool BasicKineticDiagram<T>::Legalize(KineticReport& report)
+{
+	Suspect.clear();
+	for (HalfEdge* edge : Diagram.TriangulationHalfEdges)
+	{
+		if (edge < edge->twin && edge->incidentFace != Outside && edge->twin->incidentFace != Outside)
+			Suspect.push_back(edge);
+	}
+
+	const size_t limit = 8 * Diagram.TriangulationHalfEdges.size() + 64;
+	size_t flips = 0;
+	while (!Suspect.empty())
+	{
+		HalfEdge* edge = Suspect.back();
+		Suspect.pop_back();
+
+		HalfEdge* twin = edge->twin;
+		if (edge->incidentFace == Outside || twin->incidentFace == Outside)
+			continue;
+		if (SitePredicates<T>::InCircle(edge->origin->point, edge->dest->point, edge->next->dest->point, twin->next->dest->point) <= 0)
+			continue;
+
+		if (++flips > limit)
+			return false;
+		Suspect.insert(Suspect.end(), { edge->next, edge->prev, twin->next, twin->prev });
+		FlipEdge(edge);
+	}
+
+	report.Flips += flips;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicKineticDiagram<T>::RebuildAll(KineticReport& report)
+{
+	// Spares are still in the containers, which the clear sets aside
+	SpareTriangles.clear();
+	SpareTriangleEdges.clear();
+
+	Place(1);
+	Diagram.ClearDCEL();
+	{
+		BasicFortunesAlgorithm<T> algorithm(Diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+	}
+
+	Outside = nullptr;
+	for (Face* face : Diagram.TriangulationFaces)
+	{
+		if (face->Unbounded)
+			Outside = face;
+	}
+	report.Rebuilt = true;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+bool BasicKineticDiagram<T>::IsInterior(const Vertex* vertex) const
+{
+	HalfEdge* first = vertex->incidentEdge;
+	HalfEdge* spoke = first;
+	size_t steps = 0;
+	do
+	{
+		if (spoke->incidentFace == Outside || ++steps > FanLimit)
+			return false;
+		spoke = spoke->prev->twin;
+	} while (spoke != first);
+	return true;
+}
+
+template class BasicKineticDiagram<float>;
+template class BasicKineticDiagram<double>;
+template class BasicKineticDiagram<int64_t>;
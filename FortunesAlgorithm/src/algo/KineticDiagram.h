@@ -0,0 +1,85 @@
+#pragma once
+
+#include "DualCells.h"
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// What a kinetic step did
+struct KineticReport
+{
+	// Parts the motion was cut into so no triangle turned over within one
+	size_t Substeps;
+	// Delaunay edges flipped
+	size_t Flips;
+	// Triangles added or taken away as sites joined or left the hull
+	size_t HullEvents;
+	// The motion could not be followed and the diagram was swept again
+	bool Rebuilt;
+};
+
+// Follows sites that move a little at a time. The Delaunay triangulation is kept from
+// step to step and its certificates checked at the new positions: every triangle must
+// keep its orientation, every hull corner must stay convex, and every edge must stay
+// Delaunay. A failed orientation splits the motion into smaller parts, a failed hull
+// corner adds or takes away the triangle at it, and a failed edge is flipped. The
+// Voronoi diagram is then rebuilt in place as the dual of the triangulation, one
+// circumcentre per triangle and a ray per hull edge out to the bounding box, reusing its
+// records, which costs a linear pass rather than a sweep. Motion that cannot be followed
+// sweeps the diagram again. The certificates are those of unweighted sites.
+template<typename T>
+class BasicKineticDiagram
+{
+public:
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	// The diagram must have been run to completion
+	BasicKineticDiagram(VoronoiDiagram& diagram);
+
+	// Parameters
+	//		positions : the new position of every input, in the order of Points
+	// Moves every site to the position of the input it was made from and updates the
+	// diagram. Inputs that shared a site follow it. A position outside
+	// CoordinateTraits<T>::Holds is ignored and its input stays where it was.
+	KineticReport Advance(const BasicPoint<T>* positions);
+
+private:
+	void Place(double fraction);
+	bool Certify();
+	bool Repair(KineticReport& report);
+	void RemoveHullTriangle(HalfEdge* hullEdge);
+	bool AddHullTriangle(HalfEdge* outside);
+	bool Legalize(KineticReport& report);
+	void RebuildAll(KineticReport& report);
+
+	bool IsInterior(const Vertex* vertex) const;
+
+	VoronoiDiagram& Diagram;
+	// The unbounded face of the triangulation, its loop runs clockwise along the hull
+	Face* Outside;
+
+	// Positions at the start and end of the step
+	std::vector<Point> From, To;
+
+	// Hull edges whose triangle turned over and hull corners that turned reflex
+	std::vector<HalfEdge*> Removals, Additions;
+
+	// Edges still to check by Legalize
+	std::vector<HalfEdge*> Suspect;
+	// Rebuilds the cells, its working space kept between steps
+	BasicDualCells<T> Cells;
+
+	// Triangulation records hull events free and reuse
+	std::vector<Face*> SpareTriangles;
+	std::vector<HalfEdge*> SpareTriangleEdges;
+};
+
+typedef BasicKineticDiagram<double> KineticDiagram;
@@ -0,0 +1,185 @@
+#include "LloydRelaxation.h"
+
+#include "FortunesAlgorithm.h"
+#include "../utils/Clipping.h"
+#include "../utils/Parallel.h"
+#include "../utils/Shoelace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+	////////////////////////////////////////////////////////////////////
+	// Sorts the sites into the order the event queue pops them, highest first and left
+	// to right along a row, and renumbers them. After a Lloyd step the last order is
+	// nearly right, so insertion sort does it in close to linear time, it hands over to a
+	// full sort if the sites moved far.
+	template<typename T>
+	void SortForSweep(BasicVoronoiDiagram<T>& diagram)
+	{
+		typedef BasicVoronoiSite<T> VoronoiSite;
+
+		auto before = [](const VoronoiSite* a, const VoronoiSite* b)
+		{
+			return a->point.y > b->point.y || (a->point.y == b->point.y && a->point.x < b->point.x);
+		};
+
+		std::vector<VoronoiSite*>& sites = diagram.Sites;
+		const size_t budget = 8 * sites.size();
+		size_t shifts = 0;
+		for (size_t i = 1; i < sites.size() && shifts <= budget; i++)
+		{
+			VoronoiSite* site = sites[i];
+			size_t j = i;
+			for (; j > 0 && before(site, sites[j - 1]) && shifts <= budget; j--, shifts++)
+				sites[j] = sites[j - 1];
+			sites[j] = site;
+		}
+		if (shifts > budget)
+			std::sort(sites.begin(), sites.end(), before);
+
+		std::vector<int> newIndex(sites.size() + 1, 0);
+		std::vector<int> inputOrder(sites.size());
+		for (size_t i = 0; i < sites.size(); i++)
+		{
+			inputOrder[i] = diagram.InputOrder[sites[i]->index - 1];
+			newIndex[sites[i]->index] = int(i) + 1;
+			sites[i]->index = int(i) + 1;
+		}
+		diagram.InputOrder.swap(inputOrder);
+		for (int& site : diagram.SiteOfInput)
+			site = newIndex[site];
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+RelaxationReport Relax(BasicVoronoiDiagram<T>& diagram, size_t iterations,
+	typename CoordinateTraits<T>::Real tolerance, unsigned threads)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> Point;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	RelaxationReport report = { 0, 0.0, false };
+	const size_t n = diagram.Sites.size();
+	if (0 == n)
+		return report;
+
+	Real minX = diagram.Sites[0]->point.x, minY = diagram.Sites[0]->point.y;
+	Real maxX = minX, maxY = minY;
+	for (const BasicVoronoiSite<T>* site : diagram.Sites)
+	{
+		minX = std::min(minX, site->point.x);
+		minY = std::min(minY, site->point.y);
+		maxX = std::max(maxX, site->point.x);
+		maxY = std::max(maxY, site->point.y);
+	}
+
+	// One sweep serves every iteration, reset in place between them
+	const bool swept = !diagram.Faces.empty();
+	if (!swept)
+		SortForSweep(diagram);
+	BasicFortunesAlgorithm<T> algorithm(diagram);
+	algorithm.SetVerbose(false);
+	if (!swept)
+		algorithm.Run();
+
+	if (0 == threads)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (n < ParallelThreshold)
+		threads = 1;
+
+	// Kept across iterations, the targets and one move and polygon pair per thread
+	std::vector<Point> targets(n, Point(0, 0));
+	std::vector<Real> largest(threads);
+	std::vector<std::vector<Point>> polygons(threads), scratch(threads);
+	const size_t chunk = (n + threads - 1) / threads;
+
+	while (report.Iterations < iterations)
+	{
+		ParallelFor(threads, threads, 0, [&](size_t first, size_t last)
+		{
+			for (size_t t = first; t < last; t++)
+			{
+				std::vector<Point>& polygon = polygons[t];
+				largest[t] = 0;
+
+				const size_t end = std::min(n, (t + 1) * chunk);
+				for (size_t i = t * chunk; i < end; i++)
+				{
+					const BasicVoronoiSite<T>* site = diagram.Sites[i];
+					targets[i] = site->point;
+
+					polygon.clear();
+					const HalfEdge* start = site->face ? site->face->outerComponent : nullptr;
+					const HalfEdge* edge = start;
+					bool closed = false;
+					while (edge && edge->origin && polygon.size() <= diagram.HalfEdges.size())
+					{
+						polygon.push_back(edge->origin->point);
+						edge = edge->next;
+						if (edge == start)
+						{
+							closed = true;
+							break;
+						}
+					}
+					if (!closed)
+						continue;
+
+					ClipToRectangle(polygon, scratch[t], minX, minY, maxX, maxY);
+					if (polygon.size() < 3)
+						continue;
+
+					ShoelaceSums<Real> sums;
+					for (size_t j = 0; j < polygon.size(); j++)
+					{
+						const Point& a = polygon[j];
+						const Point& b = polygon[(j + 1) % polygon.size()];
+						sums.AddEdge(a.x - site->point.x, a.y - site->point.y, b.x - site->point.x, b.y - site->point.y);
+					}
+					if (Real(0) == sums.TwiceArea)
+						continue;
+
+					Point target(site->point.x + sums.CentroidX(), site->point.y + sums.CentroidY());
+					// Integer sites stay on the integers the exact predicates need
+					if (std::numeric_limits<T>::is_integer)
+						target = Point(std::round(target.x), std::round(target.y));
+					targets[i] = target;
+
+					const Real changeX = target.x - site->point.x, changeY = target.y - site->point.y;
+					largest[t] = std::max(largest[t], std::sqrt(changeX * changeX + changeY * changeY));
+				}
+			}
+		});
+
+		for (size_t i = 0; i < n; i++)
+			diagram.Sites[i]->point = targets[i];
+
+		const Real move = *std::max_element(largest.begin(), largest.end());
+		report.LargestMove = double(move);
+		report.Iterations++;
+
+		diagram.ClearDCEL();
+		SortForSweep(diagram);
+		algorithm.Reset();
+		algorithm.Run();
+
+		if (move <= tolerance)
+		{
+			report.Converged = true;
+			break;
+		}
+	}
+
+	return report;
+}
+
+template RelaxationReport Relax(BasicVoronoiDiagram<float>&, size_t, double, unsigned);
+template RelaxationReport Relax(BasicVoronoiDiagram<double>&, size_t, double, unsigned);
+template RelaxationReport Relax(BasicVoronoiDiagram<int64_t>&, size_t, long double, unsigned);
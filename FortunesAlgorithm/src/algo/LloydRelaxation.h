@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+
+// What Relax did
+struct RelaxationReport
+{
+	// Sweeps run after moving the sites
+	size_t Iterations;
+	// Furthest any site moved in the last iteration
+	double LargestMove;
+	// The last move was within the tolerance
+	bool Converged;
+};
+
+// Parameters
+//		diagram    : a diagram, swept or not
+//		iterations : the most times to move the sites
+//		tolerance  : stop once no site moves further than this
+//		threads    : threads to find the centroids on, 0 uses every hardware thread
+// Lloyd relaxation. Every iteration moves each site to the centroid of its cell clipped to
+// the bounds of the sites as they were on entry, then sweeps again. One quiet sweep is
+// reset between iterations, the DCEL records are recycled and every container keeps its
+// capacity. The sites stay in the order the sweep takes them, so the next sweep's event
+// queue is built without swaps and the sites only need a short insertion sort after each
+// move. The sites are renumbered into that order, InputOrder and SiteOfInput follow them.
+// A site whose cell does not close stays where it is. The diagram holds the diagram of
+// the final sites on return.
+template<typename T>
+RelaxationReport Relax(BasicVoronoiDiagram<T>& diagram, size_t iterations,
+	typename CoordinateTraits<T>::Real tolerance = 0, unsigned threads = 0);
@@ -0,0 +1,758 @@
+#include "PowerDiagram.h"
+
+#include "DualCells.h"
+#include "Predicates.h"
+#include "../utils/HilbertCurve.h"
+#include "../utils/TriangleEdits.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// The regular triangulation of the sites of a diagram, built in the diagram's
+	// triangulation records
+	template<typename T>
+	class RegularTriangulation
+	{
+	public:
+		typedef typename CoordinateTraits<T>::Real Real;
+		typedef BasicPoint<Real> Point;
+		typedef BasicVoronoiDiagram<T> VoronoiDiagram;
+		typedef BasicVoronoiSite<T> VoronoiSite;
+		typedef DCEL::BasicVertex<T> Vertex;
+		typedef DCEL::BasicFace<T> Face;
+		typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+		RegularTriangulation(VoronoiDiagram& diagram);
+
+		// False, having changed nothing, when there are no sites
+		bool Build(PowerDiagramReport& report);
+		Face* GetOutside() const { return Outside; }
+		// The vertices that keep a cell in order along the line when the sites are all on
+		// one line, and empty when there are triangles
+		const std::vector<Vertex*>& GetChain() const { return Chain; }
+
+	private:
+		void Reset();
+		void BuildChain(const std::vector<VoronoiSite*>& sites);
+		void BuildHull(const std::vector<Vertex*>& corners, std::vector<HalfEdge*>& sides);
+		HalfEdge* InsertOnHull(HalfEdge* edge, Vertex* v);
+		void Insert(Vertex* v);
+		Face* Locate(const Point& point);
+		void Legalize(Vertex* v);
+		bool TakeOut(Vertex* r, Vertex* v, bool straight);
+
+		double Power(const Vertex* a, const Vertex* b, const Vertex* c, const Vertex* d) const;
+		Real WeightOf(const Vertex* vertex) const { return Diagram.Sites[vertex->index - 1]->weight; }
+		void Drop(Vertex* vertex);
+		void DropUnused(PowerDiagramReport& report);
+
+		VoronoiDiagram& Diagram;
+		Face* Outside;
+		Vertex* Hint;
+		uint64_t Random;
+		size_t Flips;
+
+		std::vector<HalfEdge*> Suspect, Spokes;
+		std::vector<Vertex*> Dropped, Chain;
+		std::vector<Face*> SpareTriangles;
+		std::vector<HalfEdge*> SpareTriangleEdges;
+	};
+
+	////////////////////////////////////////////////////////////////////
+	template<typename T>
+	RegularTriangulation<T>::RegularTriangulation(VoronoiDiagram& diagram)
+		: Diagram(diagram)
+		, Outside(nullptr)
+		, Hint(nullptr)
+		, Random(0x9E3779B97F4A7C15ull)
+		, Flips(0)
+	{
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename T>
+	bool RegularTriangulation<T>::Build(PowerDiagramReport& report)
+	{
+		const size_t n = Diagram.Sites.size();
+		if (0 == n)
+			return false;
+
+		// Of sites at one point the heaviest stands for them
+		std::vector<VoronoiSite*> sorted(Diagram.Sites);
+		std::sort(sorted.begin(), sorted.end(), [](const VoronoiSite* a, const VoronoiSite* b)
+		{
+			if (a->point.x != b->point.x)
+				return a->point.x < b->point.x;
+			if (a->point.y != b->point.y)
+				return a->point.y < b->point.y;
+			if (a->weight != b->weight)
+				return a->weight > b->weight;
+			return a->index < b->index;
+		});
+		std::vector<VoronoiSite*> unique, hidden;
+		for (VoronoiSite* site : sorted)
+		{
+			if (!unique.empty() && unique.back()->point == site->point)
+				hidden.push_back(site);
+			else
+				unique.push_back(site);
+		}
+
+		// The hull counterclockwise with the sites on its sides, by monotone chain
+		std::vector<VoronoiSite*> hull;
+		auto chain = [&hull](VoronoiSite* site, size_t floor)
+		{
+			while (hull.size() >= floor + 2
+				&& SitePredicates<T>::Orientation(hull[hull.size() - 2]->point, hull.back()->point, site->point) < 0)
+				hull.pop_back();
+			hull.push_back(site);
+		};
+		for (VoronoiSite* site : unique)
+			chain(site, 0);
+		const size_t lower = hull.size() - 1;
+		hull.pop_back();
+		for (size_t i = unique.size(); i-- > 0;)
+			chain(unique[i], lower);
+		hull.pop_back();
+
+		std::vector<size_t> cornerAt;
+		for (size_t i = 0; i < hull.size(); i++)
+		{
+			const Point& before = hull[(i + hull.size() - 1) % hull.size()]->point;
+			const Point& after = hull[(i + 1) % hull.size()]->point;
+			if (SitePredicates<T>::Orientation(before, hull[i]->point, after) > 0)
+				cornerAt.push_back(i);
+		}
+		if (cornerAt.size() < 3)
+		{
+			Reset();
+			for (VoronoiSite* site : hidden)
+				Drop(site->triVertex);
+			BuildChain(unique);
+			DropUnused(report);
+			return true;
+		}
+
+		std::vector<char> onHull(n + 1, 0);
+		for (VoronoiSite* site : hull)
+		{
+			if (onHull[site->index])
+				return false;
+			onHull[site->index] = 1;
+		}
+
+		Reset();
+		for (VoronoiSite* site : hidden)
+			Drop(site->triVertex);
+
+		std::vector<Vertex*> corners;
+		for (size_t i : cornerAt)
+			corners.push_back(hull[i]->triVertex);
+		std::vector<HalfEdge*> sides;
+		BuildHull(corners, sides);
+
+		// A site on a side keeps its cell when it lifts below the lifted side, which only
+		// the sites on that side decide, so those that do are added first
+		std::vector<Vertex*> kept;
+		for (size_t j = 0; j < cornerAt.size(); j++)
+		{
+			const size_t from = cornerAt[j];
+			const size_t to = cornerAt[(j + 1) % cornerAt.size()];
+			const Vertex* beyond = corners[(j + 2) % corners.size()];
+
+			kept.assign(1, corners[j]);
+			for (size_t i = (from + 1) % hull.size(); ; i = (i + 1) % hull.size())
+			{
+				Vertex* next = hull[i]->triVertex;
+				while (kept.size() >= 2 && Power(kept[kept.size() - 2], next, beyond, kept.back()) <= 0)
+				{
+					Drop(kept.back());
+					kept.pop_back();
+				}
+				kept.push_back(next);
+				if (i == to)
+					break;
+			}
+
+			HalfEdge* piece = sides[j];
+			for (size_t i = 1; i + 1 < kept.size(); i++)
+			{
+				piece = InsertOnHull(piece, kept[i]);
+				Legalize(kept[i]);
+			}
+		}
+
+		// The rest go in along a Hilbert curve so each is found near the last
+		Real minX = unique[0]->point.x, minY = unique[0]->point.y, maxX = minX, maxY = minY;
+		for (const VoronoiSite* site : unique)
+		{
+			minX = std::min(minX, site->point.x);
+			minY = std::min(minY, site->point.y);
+			maxX = std::max(maxX, site->point.x);
+			maxY = std::max(maxY, site->point.y);
+		}
+		const Real cells = Real((uint32_t(1) << HilbertOrder) - 1);
+		const Real width = maxX > minX ? maxX - minX : Real(1);
+		const Real height = maxY > minY ? maxY - minY : Real(1);
+
+		std::vector<std::pair<uint64_t, Vertex*>> interior;
+		interior.reserve(unique.size() - hull.size());
+		for (VoronoiSite* site : unique)
+		{
+			if (onHull[site->index])
+				continue;
+			const Real x = (site->point.x - minX) / width;
+			const Real y = (site->point.y - minY) / height;
+			interior.push_back({ HilbertIndex(uint32_t(x * cells), uint32_t(y * cells)), site->triVertex });
+		}
+		std::sort(interior.begin(), interior.end(),
+			[](const std::pair<uint64_t, Vertex*>& a, const std::pair<uint64_t, Vertex*>& b) { return a.first < b.first; });
+
+		for (const std::pair<uint64_t, Vertex*>& entry : interior)
+			Insert(entry.second);
+
+		DropUnused(report);
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Sites on one line, in order along it, keep a cell when they lift below the segment
+	// between their neighbours that do, which is the lower hull of x * x + y * y - weight
+	// over the position t along the line. The kept ones are joined in a path around the
+	// outside.
+	template<typename T>
+	void RegularTriangulation<T>::BuildChain(const std::vector<VoronoiSite*>& sites)
+	{
+		const Point& first = sites.front()->point;
+		const Real dx = sites.back()->point.x - first.x;
+		const Real dy = sites.back()->point.y - first.y;
+		auto along = [&](const Vertex* vertex) { return (vertex->point.x - first.x) * dx + (vertex->point.y - first.y) * dy; };
+		auto lift = [this](const Vertex* vertex) { return vertex->point.x * vertex->point.x + vertex->point.y * vertex->point.y - WeightOf(vertex); };
+
+		Chain.clear();
+		for (VoronoiSite* site : sites)
+		{
+			Vertex* c = site->triVertex;
+			while (Chain.size() >= 2)
+			{
+				const Vertex* a = Chain[Chain.size() - 2];
+				const Vertex* b = Chain.back();
+				if ((lift(b) - lift(a)) * (along(c) - along(b)) < (lift(c) - lift(b)) * (along(b) - along(a)))
+					break;
+				Drop(Chain.back());
+				Chain.pop_back();
+			}
+			Chain.push_back(c);
+		}
+
+		// Forward along the chain and back again
+		const size_t k = Chain.size();
+		std::vector<HalfEdge*> forward(k > 1 ? k - 1 : 0), back(forward.size());
+		for (size_t i = 0; i + 1 < k; i++)
+		{
+			forward[i] = NewTriangleEdge(Diagram, SpareTriangleEdges);
+			back[i] = NewTriangleEdge(Diagram, SpareTriangleEdges);
+			Join(forward[i], Chain[i], Chain[i + 1], back[i]);
+			Join(back[i], Chain[i + 1], Chain[i], forward[i]);
+			forward[i]->incidentFace = Outside;
+			back[i]->incidentFace = Outside;
+			Chain[i]->incidentEdge = forward[i];
+		}
+		for (size_t i = 0; i < forward.size(); i++)
+		{
+			forward[i]->next = (i + 1 < forward.size()) ? forward[i + 1] : back[i];
+			forward[i]->next->prev = forward[i];
+			back[i]->next = (i > 0) ? back[i - 1] : forward[0];
+			back[i]->next->prev = back[i];
+		}
+		if (k > 1)
+			Chain.back()->incidentEdge = back.back();
+		Outside->innerComponent = forward.empty() ? nullptr : forward[0];
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Empties the triangulation into the spares, keeping its unbounded face last, and
+	// gives every site a vertex on no triangle
+	template<typename T>
+	void RegularTriangulation<T>::Reset()
+	{
+		std::vector<Face*>& faces = Diagram.TriangulationFaces;
+		for (size_t i = 0; i < faces.size(); i++)
+		{
+			if (faces[i]->Unbounded)
+			{
+				std::swap(faces[i], faces.back());
+				Outside = faces.back();
+				break;
+			}
+		}
+		if (nullptr == Outside)
+		{
+			Outside = Diagram.NewFace(Face());
+			faces.push_back(Outside);
+		}
+		*Outside = Face();
+		Outside->Unbounded = true;
+
+		for (Face* face : faces)
+		{
+			if (face == Outside)
+				continue;
+			*face = Face();
+			SpareTriangles.push_back(face);
+		}
+		for (HalfEdge* edge : Diagram.TriangulationHalfEdges)
+		{
+			*edge = HalfEdge();
+			SpareTriangleEdges.push_back(edge);
+		}
+
+		std::vector<Vertex*> strays;
+		for (Vertex* vertex : Diagram.TriangulationVertices)
+		{
+			if (vertex->index < 1 || size_t(vertex->index) > Diagram.Sites.size() || Diagram.Sites[vertex->index - 1]->triVertex != vertex)
+				strays.push_back(vertex);
+		}
+		DropRecords(Diagram.TriangulationVertices, strays);
+
+		for (VoronoiSite* site : Diagram.Sites)
+		{
+			if (nullptr == site->triVertex)
+			{
+				site->triVertex = Diagram.NewVertex({ site->index, site->point, nullptr });
+				Diagram.TriangulationVertices.push_back(site->triVertex);
+			}
+			*site->triVertex = Vertex({ site->index, site->point, nullptr });
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Fans the corners of the hull from the first and flips the fan regular. The corners
+	// are in convex position, so every flip can be made. sides[j] is the edge from corner
+	// j to corner j + 1.
+	template<typename T>
+	void RegularTriangulation<T>::BuildHull(const std::vector<Vertex*>& corners, std::vector<HalfEdge*>& sides)
+	{
+		const size_t k = corners.size();
+		std::vector<HalfEdge*> outer(k);
+		sides.resize(k);
+		for (size_t j = 0; j < k; j++)
+		{
+			sides[j] = NewTriangleEdge(Diagram, SpareTriangleEdges);
+			outer[j] = NewTriangleEdge(Diagram, SpareTriangleEdges);
+			Join(sides[j], corners[j], corners[(j + 1) % k], outer[j]);
+			Join(outer[j], corners[(j + 1) % k], corners[j], sides[j]);
+			outer[j]->incidentFace = Outside;
+			corners[j]->incidentEdge = sides[j];
+		}
+
+		// The outside runs clockwise
+		for (size_t j = 0; j < k; j++)
+		{
+			outer[j]->next = outer[(j + k - 1) % k];
+			outer[j]->prev = outer[(j + 1) % k];
+		}
+		Outside->innerComponent = outer[0];
+		Hint = corners[0];
+
+		Suspect.clear();
+		HalfEdge* closing = nullptr;
+		for (size_t i = 1; i + 1 < k; i++)
+		{
+			HalfEdge* opening = sides[0];
+			if (i > 1)
+			{
+				opening = NewTriangleEdge(Diagram, SpareTriangleEdges);
+				Join(opening, corners[0], corners[i], closing);
+				closing->twin = opening;
+				Suspect.push_back(opening);
+			}
+			closing = sides[k - 1];
+			if (i + 2 < k)
+			{
+				closing = NewTriangleEdge(Diagram, SpareTriangleEdges);
+				closing->origin = corners[i + 1];
+				closing->dest = corners[0];
+			}
+			LinkTriangle(opening, sides[i], closing, NewTriangle(Diagram, SpareTriangles));
+		}
+
+		while (!Suspect.empty())
+		{
+			HalfEdge* edge = Suspect.back();
+			Suspect.pop_back();
+
+			HalfEdge* twin = edge->twin;
+			if (twin->incidentFace == Outside)
+				continue;
+			const Vertex* x = edge->origin;
+			const Vertex* y = edge->dest;
+			const Vertex* v = edge->prev->origin;
+			const Vertex* z = twin->next->dest;
+			if (Power(x, y, v, z) > 0
+				&& SitePredicates<T>::Orientation(v->point, x->point, z->point) > 0
+				&& SitePredicates<T>::Orientation(z->point, y->point, v->point) > 0)
+			{
+				Suspect.insert(Suspect.end(), { edge->next, edge->prev, twin->next, twin->prev });
+				FlipEdge(edge);
+				Flips++;
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Splits the triangle x, y, w on the hull edge x to y about v into x, v, w and v, y, w
+	// and returns the edge from v to y
+	template<typename T>
+	typename RegularTriangulation<T>::HalfEdge* RegularTriangulation<T>::InsertOnHull(HalfEdge* edge, Vertex* v)
+	{
+		HalfEdge* outer = edge->twin;
+		HalfEdge* yw = edge->next;
+		HalfEdge* wx = edge->prev;
+		Vertex* x = edge->origin;
+		Vertex* y = edge->dest;
+		Vertex* w = wx->origin;
+
+		HalfEdge* vw = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		HalfEdge* wv = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		HalfEdge* vy = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		HalfEdge* vx = NewTriangleEdge(Diagram, SpareTriangleEdges);
+		Join(vw, v, w, wv);
+		Join(wv, w, v, vw);
+		Join(vy, v, y, outer);
+		Join(vx, v, x, edge);
+		edge->dest = v;
+		edge->twin = vx;
+		outer->dest = v;
+		outer->twin = vy;
+
+		LinkTriangle(edge, vw, wx, edge->incidentFace);
+		LinkTriangle(vy, yw, wv, NewTriangle(Diagram, SpareTriangles));
+
+		vx->incidentFace = Outside;
+		vx->prev = outer;
+		vx->next = outer->next;
+		outer->next->prev = vx;
+		outer->next = vx;
+
+		v->incidentEdge = vw;
+		Suspect.assign({ wx, yw });
+		return vy;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Adds a vertex inside the hull, unless it lifts above the triangle holding it
+	template<typename T>
+	void RegularTriangulation<T>::Insert(Vertex* v)
+	{
+		Face* triangle = Locate(v->point);
+		if (nullptr == triangle)
+		{
+			Drop(v);
+			return;
+		}
+
+		HalfEdge* first = triangle->outerComponent;
+		HalfEdge* onEdge = nullptr;
+		HalfEdge* side = first;
+		for (int i = 0; i < 3; i++, side = side->next)
+		{
+			if (side->origin->point == v->point)
+			{
+				Drop(v);
+				return;
+			}
+			if (0 == SitePredicates<T>::Orientation(side->origin->point, side->dest->point, v->point))
+				onEdge = side;
+		}
+		if (Power(first->origin, first->dest, first->prev->origin, v) <= 0)
+		{
+			Drop(v);
+			return;
+		}
+
+		auto newEdge = [this]() { return NewTriangleEdge(Diagram, SpareTriangleEdges); };
+		auto newTriangle = [this]() { return NewTriangle(Diagram, SpareTriangles); };
+		Suspect.clear();
+		if (nullptr == onEdge)
+		{
+			SplitTriangle(triangle, v, newEdge, newTriangle);
+		}
+		else if (onEdge->twin->incidentFace == Outside)
+		{
+			InsertOnHull(onEdge, v);
+			Legalize(v);
+			Hint = v;
+			return;
+		}
+		else
+		{
+			SplitEdge(onEdge, v, newEdge, newTriangle);
+		}
+
+		HalfEdge* spoke = v->incidentEdge;
+		do
+		{
+			Suspect.push_back(spoke->next);
+			spoke = spoke->prev->twin;
+		} while (spoke != v->incidentEdge);
+
+		Legalize(v);
+		Hint = v;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Walks from the last vertex added towards the point, crossing an edge with the point
+	// on its outer side. Regular triangulations can turn a walk in circles, so the edge
+	// tried first is picked at random, and a walk that runs too long looks at every
+	// triangle instead.
+	template<typename T>
+	typename RegularTriangulation<T>::Face* RegularTriangulation<T>::Locate(const Point& point)
+	{
+		HalfEdge* edge = Hint->incidentEdge;
+		for (size_t steps = 0; edge->incidentFace == Outside && steps < FanLimit; steps++)
+			edge = edge->prev->twin;
+
+		Face* triangle = edge->incidentFace;
+		const size_t limit = 4 * Diagram.TriangulationFaces.size();
+		for (size_t step = 0; step < limit && triangle != Outside; step++)
+		{
+			Random ^= Random << 13;
+			Random ^= Random >> 7;
+			Random ^= Random << 17;
+
+			HalfEdge* side = triangle->outerComponent;
+			for (uint64_t skip = Random % 3; skip > 0; skip--)
+				side = side->next;
+
+			HalfEdge* across = nullptr;
+			for (int i = 0; i < 3 && nullptr == across; i++, side = side->next)
+			{
+				if (SitePredicates<T>::Orientation(side->origin->point, side->dest->point, point) < 0)
+					across = side;
+			}
+			if (nullptr == across)
+				return triangle;
+			triangle = across->twin->incidentFace;
+		}
+
+		for (Face* candidate : Diagram.TriangulationFaces)
+		{
+			HalfEdge* first = candidate->outerComponent;
+			if (candidate == Outside || nullptr == first)
+				continue;
+			if (SitePredicates<T>::Orientation(first->origin->point, first->dest->point, point) >= 0
+				&& SitePredicates<T>::Orientation(first->next->origin->point, first->next->dest->point, point) >= 0
+				&& SitePredicates<T>::Orientation(first->prev->origin->point, first->prev->dest->point, point) >= 0)
+				return candidate;
+		}
+		return nullptr;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Checks the edges facing the new vertex. An edge whose far corner lifts below the
+	// plane of the vertex's triangle is flipped when the two triangles are convex, and
+	// otherwise the corner at the reflex or straight angle is taken out when it has the
+	// fewest neighbours it can and lifts above the triangles that would replace it. Any
+	// other edge is left for a later flip to settle.
+	template<typename T>
+	void RegularTriangulation<T>::Legalize(Vertex* v)
+	{
+		while (!Suspect.empty())
+		{
+			HalfEdge* edge = Suspect.back();
+			Suspect.pop_back();
+
+			// Edges freed by taking out a vertex, or reused since, no longer face it
+			if (nullptr == edge->next || edge->next->dest != v)
+				continue;
+			HalfEdge* twin = edge->twin;
+			if (twin->incidentFace == Outside)
+				continue;
+
+			Vertex* x = edge->origin;
+			Vertex* y = edge->dest;
+			const Vertex* z = twin->next->dest;
+			if (Power(x, y, v, z) <= 0)
+				continue;
+
+			const double atX = SitePredicates<T>::Orientation(v->point, x->point, z->point);
+			const double atY = SitePredicates<T>::Orientation(z->point, y->point, v->point);
+			if (atX > 0 && atY > 0)
+			{
+				HalfEdge* xz = twin->next;
+				HalfEdge* zy = twin->prev;
+				FlipEdge(edge);
+				Suspect.push_back(xz);
+				Suspect.push_back(zy);
+				Flips++;
+			}
+			else if (atX <= 0)
+			{
+				TakeOut(x, v, 0 == atX);
+			}
+			else
+			{
+				TakeOut(y, v, 0 == atY);
+			}
+		}
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Replaces the triangles about r by a fan from v over its neighbours, which are three,
+	// or four with r on the line from v to the one opposite. The edges of the fan facing v
+	// are checked in turn.
+	template<typename T>
+	bool RegularTriangulation<T>::TakeOut(Vertex* r, Vertex* v, bool straight)
+	{
+		Spokes.clear();
+		HalfEdge* spoke = r->incidentEdge;
+		do
+		{
+			if (spoke->incidentFace == Outside || Spokes.size() > 4)
+				return false;
+			Spokes.push_back(spoke);
+			spoke = spoke->prev->twin;
+		} while (spoke != r->incidentEdge);
+
+		const size_t k = Spokes.size();
+		if (k != (straight ? 4u : 3u))
+			return false;
+		const size_t at = std::find_if(Spokes.begin(), Spokes.end(), [v](const HalfEdge* edge) { return edge->dest == v; }) - Spokes.begin();
+		if (at == k)
+			return false;
+		std::rotate(Spokes.begin(), Spokes.begin() + at, Spokes.end());
+
+		HalfEdge* rim[4];
+		Vertex* ring[4];
+		for (size_t i = 0; i < k; i++)
+		{
+			rim[i] = Spokes[i]->next;
+			ring[i] = Spokes[i]->dest;
+		}
+		for (size_t i = 1; i + 1 < k; i++)
+		{
+			if (SitePredicates<T>::Orientation(v->point, ring[i]->point, ring[i + 1]->point) <= 0
+				|| Power(v, ring[i], ring[i + 1], r) > 0)
+				return false;
+		}
+
+		Face* faces[4];
+		for (size_t i = 0; i < k; i++)
+			faces[i] = Spokes[i]->incidentFace;
+
+		size_t used = 1;
+		if (3 == k)
+		{
+			LinkTriangle(rim[0], rim[1], rim[2], faces[0]);
+		}
+		else
+		{
+			HalfEdge* diagonal = Spokes[0];
+			HalfEdge* back = diagonal->twin;
+			Join(diagonal, ring[2], v, back);
+			Join(back, v, ring[2], diagonal);
+			LinkTriangle(rim[0], rim[1], diagonal, faces[0]);
+			LinkTriangle(back, rim[2], rim[3], faces[1]);
+			used = 2;
+		}
+
+		for (size_t i = used; i < k; i++)
+		{
+			*faces[i] = Face();
+			SpareTriangles.push_back(faces[i]);
+		}
+		for (size_t i = (3 == k) ? 0 : 1; i < k; i++)
+		{
+			HalfEdge* twin = Spokes[i]->twin;
+			*Spokes[i] = HalfEdge();
+			*twin = HalfEdge();
+			SpareTriangleEdges.push_back(Spokes[i]);
+			SpareTriangleEdges.push_back(twin);
+		}
+		for (size_t i = 0; i < k; i++)
+			ring[i]->incidentEdge = rim[i];
+
+		for (size_t i = 1; i + 1 < k; i++)
+			Suspect.push_back(rim[i]);
+		Drop(r);
+		if (Hint == r)
+			Hint = v;
+		Flips++;
+		return true;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename T>
+	double RegularTriangulation<T>::Power(const Vertex* a, const Vertex* b, const Vertex* c, const Vertex* d) const
+	{
+		return SitePredicates<T>::PowerTest(a->point, WeightOf(a), b->point, WeightOf(b), c->point, WeightOf(c), d->point, WeightOf(d));
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename T>
+	void RegularTriangulation<T>::Drop(Vertex* vertex)
+	{
+		vertex->incidentEdge = nullptr;
+		Dropped.push_back(vertex);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Records no triangle uses any more
+	template<typename T>
+	void RegularTriangulation<T>::DropUnused(PowerDiagramReport& report)
+	{
+		report.EmptyCells = Dropped.size();
+		report.Flips = Flips;
+		for (Vertex* vertex : Dropped)
+			Diagram.Sites[vertex->index - 1]->triVertex = nullptr;
+		DropRecords(Diagram.TriangulationVertices, Dropped);
+		DropRecords(Diagram.TriangulationFaces, SpareTriangles);
+		DropRecords(Diagram.TriangulationHalfEdges, SpareTriangleEdges);
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+PowerDiagramReport ApplyWeights(BasicVoronoiDiagram<T>& diagram)
+{
+	PowerDiagramReport report = { 0, 0, false };
+
+	bool weighted = false;
+	for (const BasicVoronoiSite<T>* site : diagram.Sites)
+		weighted = weighted || site->weight != 0;
+	if (!weighted)
+		return report;
+
+	// A diagram that was never swept, or was cleared, has no cells to rebuild yet
+	for (BasicVoronoiSite<T>* site : diagram.Sites)
+	{
+		if (nullptr == site->face)
+		{
+			site->face = diagram.NewFace({ site, nullptr, nullptr, false, 0 });
+			diagram.Faces.push_back(site->face);
+		}
+	}
+	if (diagram.Faces.empty() || !diagram.Faces.back()->Unbounded)
+		diagram.Faces.push_back(diagram.NewFace({ nullptr, nullptr, nullptr, true, 0 }));
+
+	RegularTriangulation<T> triangulation(diagram);
+	if (!triangulation.Build(report))
+		return report;
+
+	BasicDualCells<T> cells(diagram);
+	if (triangulation.GetChain().empty())
+		report.Applied = cells.Build(triangulation.GetOutside(), true);
+	else
+		report.Applied = cells.BuildStrips(triangulation.GetChain(), true);
+	diagram.InvalidateMetrics();
+	return report;
+}
+
+template PowerDiagramReport ApplyWeights(BasicVoronoiDiagram<float>&);
+template PowerDiagramReport ApplyWeights(BasicVoronoiDiagram<double>&);
+template PowerDiagramReport ApplyWeights(BasicVoronoiDiagram<int64_t>&);
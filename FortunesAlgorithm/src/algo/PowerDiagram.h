@@ -0,0 +1,32 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+
+// What ApplyWeights did
+struct PowerDiagramReport
+{
+	// Sites whose weight left them without a cell
+	size_t EmptyCells;
+	// Edges flipped and vertices taken out while the triangulation was built
+	size_t Flips;
+	// The diagram is now the power diagram of its sites
+	bool Applied;
+};
+
+// Parameters
+//		diagram : a diagram run to completion, or one whose DCEL is empty
+// Turns the diagram into the power diagram of its sites, where a point belongs to the
+// site s of least power |p - s|^2 - s.weight, so heavier sites take more room. Lifting
+// every site to x * x + y * y - weight, the regular triangulation of the sites is the
+// lower hull of the lifted points. It is built incrementally within the convex hull of
+// the sites, along a Hilbert curve, flipping edges whose far corner lifts below the plane
+// of the triangle facing it and taking out vertices that end up above it (Edelsbrunner
+// and Shah, "Incremental Topological Flipping Works for Regular Triangulations"). The
+// cells are then built as its dual. A site that lifts above the hull of the others has
+// no vertex in the triangulation and a cell with no boundary, and of sites at one point
+// only the heaviest keeps a cell. Sites on one line have no triangle, their cells are
+// strips between parallel edges. Sites all of weight 0 leave the diagram as it is.
+template<typename T>
+PowerDiagramReport ApplyWeights(BasicVoronoiDiagram<T>& diagram);
@@ -0,0 +1,399 @@
+#include "Predicates.h"
+
+#include "../utils/NoContraction.h"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	// A value held exactly as a sum of non-overlapping doubles, smallest magnitude first
+	typedef std::vector<double> Expansion;
+
+	const double Epsilon = std::ldexp(1.0, -53);
+	// 2^27 + 1, splits a double into two halves of 26 bits
+	const double Splitter = std::ldexp(1.0, 27) + 1.0;
+
+	const double OrientationErrorBound = (3.0 + 16.0 * Epsilon) * Epsilon;
+	const double InCircleErrorBound = (10.0 + 96.0 * Epsilon) * Epsilon;
+	// InCircle's bound with room for the rounding of the weight differences
+	const double PowerTestErrorBound = (12.0 + 128.0 * Epsilon) * Epsilon;
+
+	////////////////////////////////////////////////////////////////////
+	// x + y == a + b exactly, given |a| >= |b|
+	inline void FastTwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		y = b - (x - a);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// x + y == a + b exactly
+	inline void TwoSum(double a, double b, double& x, double& y)
+	{
+		x = a + b;
+		const double bVirtual = x - a;
+		const double aVirtual = x - bVirtual;
+		y = (a - aVirtual) + (b - bVirtual);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// x + y == a - b exactly
+	inline void TwoDiff(double a, double b, double& x, double& y)
+	{
+		x = a - b;
+		const double bVirtual = a - x;
+		const double aVirtual = x + bVirtual;
+		y = (a - aVirtual) + (bVirtual - b);
+	}
+
+	////////////////////////////////////////////////////////////////////
+	inline void Split(double a, double& high, double& low)
+	{
+		const double c = Splitter * a;
+		high = c - (c - a);
+		low = a - high;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// x + y == a * b exactly
+	inline void TwoProduct(double a, double b, double& x, double& y)
+	{
+		x = a * b;
+		double aHigh, aLow, bHigh, bLow;
+		Split(a, aHigh, aLow);
+		Split(b, bHigh, bLow);
+		const double err1 = x - (aHigh * bHigh);
+		const double err2 = err1 - (aLow * bHigh);
+		const double err3 = err2 - (aHigh * bLow);
+		y = (aLow * bLow) - err3;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	Expansion Difference(double a, double b)
+	{
+		double x, y;
+		TwoDiff(a, b, x, y);
+		if (0.0 == y) return Expansion{ x };
+		return Expansion{ y, x };
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Merges the components of both by magnitude and carries them through a chain
+	// of exact sums, dropping the zeros that fall out.
+	Expansion Sum(const Expansion& e, const Expansion& f)
+	{
+		Expansion h;
+		h.reserve(e.size() + f.size());
+
+		size_t ei = 0, fi = 0;
+		auto takeE = [&]() { return fi == f.size() || (ei < e.size() && ((f[fi] > e[ei]) == (f[fi] > -e[ei]))); };
+
+		double q = takeE() ? e[ei++] : f[fi++];
+		double qNew, hh;
+		bool first = true;
+		while (ei < e.size() || fi < f.size())
+		{
+			const double next = takeE() ? e[ei++] : f[fi++];
+			if (first)
+				FastTwoSum(next, q, qNew, hh);
+			else
+				TwoSum(q, next, qNew, hh);
+			first = false;
+
+			q = qNew;
+			if (0.0 != hh) h.push_back(hh);
+		}
+
+		if (0.0 != q || h.empty()) h.push_back(q);
+		return h;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	Expansion Scale(const Expansion& e, double b)
+	{
+		Expansion h;
+		h.reserve(2 * e.size());
+
+		double q, hh;
+		TwoProduct(e[0], b, q, hh);
+		if (0.0 != hh) h.push_back(hh);
+
+		for (size_t i = 1; i < e.size(); i++)
+		{
+			double product1, product0, sum;
+			TwoProduct(e[i], b, product1, product0);
+			TwoSum(q, product0, sum, hh);
+			if (0.0 != hh) h.push_back(hh);
+			FastTwoSum(product1, sum, q, hh);
+			if (0.0 != hh) h.push_back(hh);
+		}
+
+		if (0.0 != q || h.empty()) h.push_back(q);
+		return h;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	Expansion Product(const Expansion& e, const Expansion& f)
+	{
+		Expansion h = Scale(e, f[0]);
+		for (size_t i = 1; i < f.size(); i++)
+		{
+			h = Sum(h, Scale(e, f[i]));
+		}
+		return h;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	Expansion Negate(Expansion e)
+	{
+		for (double& component : e)
+		{
+			component = -component;
+		}
+		return e;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	double OrientationExact(const Point& a, const Point& b, const Point& c)
+	{
+		const Expansion acx = Difference(a.x, c.x);
+		const Expansion acy = Difference(a.y, c.y);
+		const Expansion bcx = Difference(b.x, c.x);
+		const Expansion bcy = Difference(b.y, c.y);
+
+		const Expansion det = Sum(Product(acx, bcy), Negate(Product(acy, bcx)));
+		// The largest component carries the sign
+		return det.back();
+	}
+
+	////////////////////////////////////////////////////////////////////
+	double InCircleExact(const Point& a, const Point& b, const Point& c, const Point& d)
+	{
+		const Expansion adx = Difference(a.x, d.x);
+		const Expansion ady = Difference(a.y, d.y);
+		const Expansion bdx = Difference(b.x, d.x);
+		const Expansion bdy = Difference(b.y, d.y);
+		const Expansion cdx = Difference(c.x, d.x);
+		const Expansion cdy = Difference(c.y, d.y);
+
+		const Expansion aLift = Sum(Product(adx, adx), Product(ady, ady));
+		const Expansion bLift = Sum(Product(bdx, bdx), Product(bdy, bdy));
+		const Expansion cLift = Sum(Product(cdx, cdx), Product(cdy, cdy));
+
+		const Expansion bc = Sum(Product(bdx, cdy), Negate(Product(cdx, bdy)));
+		const Expansion ca = Sum(Product(cdx, ady), Negate(Product(adx, cdy)));
+		const Expansion ab = Sum(Product(adx, bdy), Negate(Product(bdx, ady)));
+
+		const Expansion det = Sum(Sum(Product(aLift, bc), Product(bLift, ca)), Product(cLift, ab));
+		return det.back();
+	}
+
+	////////////////////////////////////////////////////////////////////
+	double PowerTestExact(const Point& a, double aw, const Point& b, double bw, const Point& c, double cw, const Point& d, double dw)
+	{
+		const Expansion adx = Difference(a.x, d.x);
+		const Expansion ady = Difference(a.y, d.y);
+		const Expansion bdx = Difference(b.x, d.x);
+		const Expansion bdy = Difference(b.y, d.y);
+		const Expansion cdx = Difference(c.x, d.x);
+		const Expansion cdy = Difference(c.y, d.y);
+
+		const Expansion aLift = Sum(Sum(Product(adx, adx), Product(ady, ady)), Negate(Difference(aw, dw)));
+		const Expansion bLift = Sum(Sum(Product(bdx, bdx), Product(bdy, bdy)), Negate(Difference(bw, dw)));
+		const Expansion cLift = Sum(Sum(Product(cdx, cdx), Product(cdy, cdy)), Negate(Difference(cw, dw)));
+
+		const Expansion bc = Sum(Product(bdx, cdy), Negate(Product(cdx, bdy)));
+		const Expansion ca = Sum(Product(cdx, ady), Negate(Product(adx, cdy)));
+		const Expansion ab = Sum(Product(adx, bdy), Negate(Product(bdx, ady)));
+
+		const Expansion det = Sum(Sum(Product(aLift, bc), Product(bLift, ca)), Product(cLift, ab));
+		return det.back();
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+double Orientation(const Point& a, const Point& b, const Point& c)
+{
+	const double detLeft = (a.x - c.x) * (b.y - c.y);
+	const double detRight = (a.y - c.y) * (b.x - c.x);
+	const double det = detLeft - detRight;
+
+	// When the two products differ in sign the subtraction cannot cancel
+	double detSum;
+	if (detLeft > 0.0)
+	{
+		if (detRight <= 0.0) return det;
+		detSum = detLeft + detRight;
+	}
+	else if (detLeft < 0.0)
+	{
+		if (detRight >= 0.0) return det;
+		detSum = -detLeft - detRight;
+	}
+	else
+	{
+		return det;
+	}
+
+	const double errorBound = OrientationErrorBound * detSum;
+	if (det >= errorBound || -det >= errorBound) return det;
+
+	return OrientationExact(a, b, c);
+}
+
+////////////////////////////////////////////////////////////////////
+double InCircle(const Point& a, const Point& b, const Point& c, const Point& d)
+{
+	const double adx = a.x - d.x;
+	const double bdx = b.x - d.x;
+	const double cdx = c.x - d.x;
+	const double ady = a.y - d.y;
+	const double bdy = b.y - d.y;
+	const double cdy = c.y - d.y;
+
+	const double bdxcdy = bdx * cdy;
+	const double cdxbdy = cdx * bdy;
+	const double aLift = adx * adx + ady * ady;
+
+	const double cdxady = cdx * ady;
+	const double adxcdy = adx * cdy;
+	const double bLift = bdx * bdx + bdy * bdy;
+
+	const double adxbdy = adx * bdy;
+	const double bdxady = bdx * ady;
+	const double cLift = cdx * cdx + cdy * cdy;
+
+	const double det = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+
+	const double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * aLift
+		+ (std::fabs(cdxady) + std::fabs(adxcdy)) * bLift
+		+ (std::fabs(adxbdy) + std::fabs(bdxady)) * cLift;
+	const double errorBound = InCircleErrorBound * permanent;
+	if (det > errorBound || -det > errorBound) return det;
+
+	return InCircleExact(a, b, c, d);
+}
+
+////////////////////////////////////////////////////////////////////
+double PowerTest(const Point& a, double aw, const Point& b, double bw, const Point& c, double cw, const Point& d, double dw)
+{
+	const double adx = a.x - d.x;
+	const double bdx = b.x - d.x;
+	const double cdx = c.x - d.x;
+	const double ady = a.y - d.y;
+	const double bdy = b.y - d.y;
+	const double cdy = c.y - d.y;
+	const double adw = aw - dw;
+	const double bdw = bw - dw;
+	const double cdw = cw - dw;
+
+	const double bdxcdy = bdx * cdy;
+	const double cdxbdy = cdx * bdy;
+	const double aSquare = adx * adx + ady * ady;
+
+	const double cdxady = cdx * ady;
+	const double adxcdy = adx * cdy;
+	const double bSquare = bdx * bdx + bdy * bdy;
+
+	const double adxbdy = adx * bdy;
+	const double bdxady = bdx * ady;
+	const double cSquare = cdx * cdx + cdy * cdy;
+
+	const double det = (aSquare - adw) * (bdxcdy - cdxbdy) + (bSquare - bdw) * (cdxady - adxcdy) + (cSquare - cdw) * (adxbdy - bdxady);
+
+	const double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * (aSquare + std::fabs(adw))
+		+ (std::fabs(cdxady) + std::fabs(adxcdy)) * (bSquare + std::fabs(bdw))
+		+ (std::fabs(adxbdy) + std::fabs(bdxady)) * (cSquare + std::fabs(cdw));
+	const double errorBound = PowerTestErrorBound * permanent;
+	if (det > errorBound || -det > errorBound) return det;
+
+	return PowerTestExact(a, aw, b, bw, c, cw, d, dw);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+double SitePredicates<T>::Orientation(const SitePoint& a, const SitePoint& b, const SitePoint& c)
+{
+	return ::Orientation(Point(double(a.x), double(a.y)), Point(double(b.x), double(b.y)), Point(double(c.x), double(c.y)));
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+double SitePredicates<T>::InCircle(const SitePoint& a, const SitePoint& b, const SitePoint& c, const SitePoint& d)
+{
+	return ::InCircle(Point(double(a.x), double(a.y)), Point(double(b.x), double(b.y)),
+		Point(double(c.x), double(c.y)), Point(double(d.x), double(d.y)));
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+double SitePredicates<T>::PowerTest(const SitePoint& a, Real aw, const SitePoint& b, Real bw, const SitePoint& c, Real cw, const SitePoint& d, Real dw)
+{
+	return ::PowerTest(Point(double(a.x), double(a.y)), double(aw), Point(double(b.x), double(b.y)), double(bw),
+		Point(double(c.x), double(c.y)), double(cw), Point(double(d.x), double(d.y)), double(dw));
+}
+
+////////////////////////////////////////////////////////////////////
+// Integer sites within 2^29 of the origin have differences below 2^31, so both
+// products of the determinant fit in an int64_t and the sign is exact. Larger
+// sites fall back to the double predicate, exact within CoordinateTraits<int64_t>::Limit.
+template<>
+double SitePredicates<int64_t>::Orientation(const SitePoint& a, const SitePoint& b, const SitePoint& c)
+{
+	const long double limit = 536870912.0L;
+	const bool small = std::fabs(a.x) <= limit && std::fabs(a.y) <= limit
+		&& std::fabs(b.x) <= limit && std::fabs(b.y) <= limit
+		&& std::fabs(c.x) <= limit && std::fabs(c.y) <= limit;
+
+	if (!small)
+		return ::Orientation(Point(double(a.x), double(a.y)), Point(double(b.x), double(b.y)), Point(double(c.x), double(c.y)));
+
+	const int64_t det = (int64_t(a.x) - int64_t(c.x)) * (int64_t(b.y) - int64_t(c.y))
+		- (int64_t(a.y) - int64_t(c.y)) * (int64_t(b.x) - int64_t(c.x));
+	return double(det);
+}
+
+////////////////////////////////////////////////////////////////////
+// Integer sites within 2^29 of the origin have differences within 2^30, so the lifts
+// and the 2x2 minors fit in an int64_t and each of their three products in 2^122. The
+// determinant sums them exactly in 128 bits. Larger sites, or a compiler without
+// 128 bit integers, take the double predicate.
+template<>
+double SitePredicates<int64_t>::InCircle(const SitePoint& a, const SitePoint& b, const SitePoint& c, const SitePoint& d)
+{
+#if defined(__SIZEOF_INT128__)
+	const long double limit = 536870912.0L;
+	const bool small = std::fabs(a.x) <= limit && std::fabs(a.y) <= limit
+		&& std::fabs(b.x) <= limit && std::fabs(b.y) <= limit
+		&& std::fabs(c.x) <= limit && std::fabs(c.y) <= limit
+		&& std::fabs(d.x) <= limit && std::fabs(d.y) <= limit;
+
+	if (small)
+	{
+		const int64_t adx = int64_t(a.x) - int64_t(d.x);
+		const int64_t ady = int64_t(a.y) - int64_t(d.y);
+		const int64_t bdx = int64_t(b.x) - int64_t(d.x);
+		const int64_t bdy = int64_t(b.y) - int64_t(d.y);
+		const int64_t cdx = int64_t(c.x) - int64_t(d.x);
+		const int64_t cdy = int64_t(c.y) - int64_t(d.y);
+
+		const int64_t aLift = adx * adx + ady * ady;
+		const int64_t bLift = bdx * bdx + bdy * bdy;
+		const int64_t cLift = cdx * cdx + cdy * cdy;
+
+		const __int128 det = __int128(aLift) * (bdx * cdy - cdx * bdy)
+			+ __int128(bLift) * (cdx * ady - adx * cdy)
+			+ __int128(cLift) * (adx * bdy - bdx * ady);
+		return double(det);
+	}
+#endif
+
+	return ::InCircle(Point(double(a.x), double(a.y)), Point(double(b.x), double(b.y)),
+		Point(double(c.x), double(c.y)), Point(double(d.x), double(d.y)));
+}
+
+template struct SitePredicates<float>;
+template struct SitePredicates<double>;
+template struct SitePredicates<int64_t>;
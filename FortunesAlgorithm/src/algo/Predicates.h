@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../types/Point.h"
+
+// Geometric predicates whose sign is always correct. Each one first evaluates the
+// determinant in plain floating point along with a bound on its rounding error,
+// and only when the result is closer to zero than that bound does it redo the
+// determinant exactly with floating point expansions. Random input almost never
+// needs the exact path, grid and co-circular input gets the right answer from it.
+// The approach and error bounds follow Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates".
+
+// Parameters
+//		a, b, c : the points of the triangle
+// Positive when a, b and c turn counterclockwise, negative when they turn
+// clockwise and zero when they are collinear. The magnitude approximates twice
+// the signed area of the triangle.
+double Orientation(const Point& a, const Point& b, const Point& c);
+
+// Parameters
+//		a, b, c : the points on the circle, in counterclockwise order
+//		d       : the point to test
+// Positive when d lies inside the circle through a, b and c, negative when it lies
+// outside and zero when the four points are co-circular. The sign flips when a, b
+// and c are given clockwise.
+double InCircle(const Point& a, const Point& b, const Point& c, const Point& d);
+
+// Parameters
+//		a, b, c          : the points of the triangle, in counterclockwise order
+//		d                : the point to test
+//		aw, bw, cw, dw   : the weights of the points
+// InCircle on the points lifted to x * x + y * y - w. Positive when d lifts below the
+// plane through the other three, so that it is closer in power than their common
+// orthogonal circle, negative when it lifts above and zero when all four lie on one
+// plane. With equal weights it is InCircle.
+double PowerTest(const Point& a, double aw, const Point& b, double bw, const Point& c, double cw, const Point& d, double dw);
+
+// The predicates as the sweep calls them, on sites stored in the working precision
+// of the coordinate type T. Float sites widen to double without loss. Integer sites
+// small enough that the determinant fits in 64 bits, or in 128 bits for InCircle where
+// the compiler has them, take an exact integer path. The rest go through the double
+// predicates, exact within CoordinateTraits<int64_t>::Limit.
+template<typename T>
+struct SitePredicates
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicPoint<Real> SitePoint;
+
+	static double Orientation(const SitePoint& a, const SitePoint& b, const SitePoint& c);
+	static double InCircle(const SitePoint& a, const SitePoint& b, const SitePoint& c, const SitePoint& d);
+	static double PowerTest(const SitePoint& a, Real aw, const SitePoint& b, Real bw, const SitePoint& c, Real cw, const SitePoint& d, Real dw);
+};
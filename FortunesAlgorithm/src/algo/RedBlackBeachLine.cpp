@@ -0,0 +1,424 @@
+#include "RedBlackBeachLine.h"
+
+#include "FortunesAlgorithm.h"
+#include "../types/Event.h"
+
+using namespace BL;
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+RedBlackBeachLine<T>::RedBlackBeachLine()
+	: Nodes()
+	, Root(NullNode)
+{
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::Clear()
+{
+	Nodes.Clear();
+	Root = NullNode;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef RedBlackBeachLine<T>::Start(VoronoiSite* site)
+{
+	Root = Nodes.NewLeaf(site);
+	return Root;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef RedBlackBeachLine<T>::FindArcAtX(Real x, Real lh) const
+{
+	NodeRef root = Root;
+	while (NullNode != root && !NodePool<T>::IsLeaf(root))
+	{
+		const Edge edge = Nodes.Internal(root).Edge();
+		// Error - A leaf has become an internal node (only edge nodes should be internal)
+		if (edge.IsNull()) return NullArc;
+		if ((edge.IsVertical() && x < edge.Start()->x) ||
+			x < IntersectionX(edge.Left()->point, edge.Right()->point, lh))
+		{
+			root = Nodes.Internal(root).Left;
+		}
+		else
+			root = Nodes.Internal(root).Right;
+	}
+	return root;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::SplitArc(ArcRef arc, VoronoiSite* left, VoronoiSite* right, const Edge& edge,
+	ArcRef& leftArc, ArcRef& rightArc)
+{
+	NodeRef breakpoint = SplitLeaf(arc, edge);
+	leftArc = Nodes.NewLeaf(left);
+	rightArc = Nodes.NewLeaf(right);
+	Nodes.SetLeft(breakpoint, leftArc);
+	Nodes.SetRight(breakpoint, rightArc);
+
+	FixRedBlackPropertiesAfterInsert(breakpoint);
+}
+
+////////////////////////////////////////////////////////////////////
+// The right breakpoint takes the arc's place, the left one hangs below it
+//   er
+//   +-- el
+//   |   +-- pl
+//   |   +-- pm
+//   +-- pr
+template<typename T>
+void RedBlackBeachLine<T>::InsertArc(ArcRef arc, VoronoiSite* site, const Edge& leftEdge, const Edge& rightEdge,
+	ArcRef& leftArc, ArcRef& middleArc, ArcRef& rightArc)
+{
+	VoronoiSite* arcSite = Nodes.Leaf(arc).Site;
+	NodeRef erArc = SplitLeaf(arc, rightEdge);
+
+	leftArc = Nodes.NewLeaf(arcSite);
+	middleArc = Nodes.NewLeaf(site);
+	rightArc = Nodes.NewLeaf(arcSite);
+
+	NodeRef elArc = Nodes.NewInternal(leftEdge);
+
+	Nodes.SetRight(erArc, rightArc);
+	Nodes.SetLeft(erArc, elArc);
+
+	Nodes.SetLeft(elArc, leftArc);
+	Nodes.SetRight(elArc, middleArc);
+
+	FixRedBlackPropertiesAfterInsert(erArc);
+	FixRedBlackPropertiesAfterInsert(elArc);
+}
+
+////////////////////////////////////////////////////////////////////
+// One of the two breakpoints is the arc's parent, the other is further up.
+// The higher one takes the new edge and the parent is spliced out with the arc.
+template<typename T>
+void RedBlackBeachLine<T>::RemoveArc(ArcRef arc, const Edge& edge)
+{
+	NodeRef leftEdge = GetLeftParent(arc);
+	NodeRef rightEdge = GetRightParent(arc);
+
+	NodeRef higherNode = NullNode;
+	NodeRef tmp = arc;
+
+	while (Nodes.Parent(tmp) != NullNode)
+	{
+		tmp = Nodes.Parent(tmp);
+		if (tmp == leftEdge)
+			higherNode = leftEdge;
+
+		if (tmp == rightEdge)
+			higherNode = rightEdge;
+	}
+
+	Nodes.Internal(higherNode).SetEdge(edge);
+
+	NodeRef parent = Nodes.Parent(arc);
+	NodeRef grandParent = Nodes.Parent(parent);
+	NodeRef movedUp = (arc == Nodes.Internal(parent).Left) ? Nodes.Internal(parent).Right : Nodes.Internal(parent).Left;
+	if (Nodes.Internal(grandParent).Left == parent)
+	{
+		Nodes.SetLeft(grandParent, movedUp);
+	}
+	else {
+		Nodes.SetRight(grandParent, movedUp);
+	}
+
+	if (Nodes.Color(parent) == TreeColor::Black)
+	{
+		FixRedBlackPropertiesAfterDelete(movedUp);
+	}
+	Nodes.Free(parent);
+	Nodes.Free(arc);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef RedBlackBeachLine<T>::First() const
+{
+	NodeRef node = Root;
+	while (NullNode != node && !NodePool<T>::IsLeaf(node))
+		node = Nodes.Internal(node).Left;
+	return node;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef RedBlackBeachLine<T>::LeftArc(ArcRef arc) const
+{
+	NodeRef parent = GetLeftParent(arc);
+	return (NullNode == parent) ? NullArc : GetClosestLeftChild(parent);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+ArcRef RedBlackBeachLine<T>::RightArc(ArcRef arc) const
+{
+	NodeRef parent = GetRightParent(arc);
+	return (NullNode == parent) ? NullArc : GetClosestRightChild(parent);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename RedBlackBeachLine<T>::Edge RedBlackBeachLine<T>::LeftBreakpoint(ArcRef arc) const
+{
+	NodeRef parent = GetLeftParent(arc);
+	return (NullNode == parent) ? Edge() : Nodes.Internal(parent).Edge();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename RedBlackBeachLine<T>::Edge RedBlackBeachLine<T>::RightBreakpoint(ArcRef arc) const
+{
+	NodeRef parent = GetRightParent(arc);
+	return (NullNode == parent) ? Edge() : Nodes.Internal(parent).Edge();
+}
+
+////////////////////////////////////////////////////////////////////
+// Turns an arc into the breakpoint that is about to split it. The new
+// node takes the leaf's place in the tree and the leaf is released.
+template<typename T>
+NodeRef RedBlackBeachLine<T>::SplitLeaf(NodeRef leaf, const Edge& edge)
+{
+	NodeRef node = Nodes.NewInternal(edge);
+	ReplaceParentsChild(Nodes.Parent(leaf), leaf, node);
+	Nodes.Free(leaf);
+	return node;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+NodeRef RedBlackBeachLine<T>::GetLeftParent(NodeRef root) const
+{
+	NodeRef parent = Nodes.Parent(root);
+	while (NullNode != parent && Nodes.Internal(parent).Left == root)
+	{
+		root = parent;
+		parent = Nodes.Parent(parent);
+	}
+	return parent;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+NodeRef RedBlackBeachLine<T>::GetRightParent(NodeRef root) const
+{
+	NodeRef parent = Nodes.Parent(root);
+	while (NullNode != parent && Nodes.Internal(parent).Right == root)
+	{
+		root = parent;
+		parent = Nodes.Parent(parent);
+	}
+	return parent;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+NodeRef RedBlackBeachLine<T>::GetClosestLeftChild(NodeRef root) const
+{
+	NodeRef child = Nodes.Internal(root).Left;
+	while (NullNode != child && !NodePool<T>::IsLeaf(child))
+	{
+		child = Nodes.Internal(child).Right;
+	}
+	return child;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+NodeRef RedBlackBeachLine<T>::GetClosestRightChild(NodeRef root) const
+{
+	NodeRef child = Nodes.Internal(root).Right;
+	while (NullNode != child && !NodePool<T>::IsLeaf(child))
+	{
+		child = Nodes.Internal(child).Left;
+	}
+	return child;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::RightRotation(NodeRef arc)
+{
+	NodeRef parent = Nodes.Parent(arc);
+	NodeRef leftChild = Nodes.Internal(arc).Left;
+
+	Nodes.SetLeft(arc, Nodes.Right(leftChild));
+	Nodes.SetRight(leftChild, arc);
+
+	ReplaceParentsChild(parent, arc, leftChild);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::LeftRotation(NodeRef arc) {
+	NodeRef parent = Nodes.Parent(arc);
+	NodeRef rightChild = Nodes.Internal(arc).Right;
+
+	Nodes.SetRight(arc, Nodes.Left(rightChild));
+	Nodes.SetLeft(rightChild, arc);
+
+	ReplaceParentsChild(parent, arc, rightChild);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::ReplaceParentsChild(NodeRef parent, NodeRef oldChild, NodeRef newChild)
+{
+	if (parent == NullNode) {
+		Root = newChild;
+	}
+	else if (Nodes.Internal(parent).Left == oldChild) {
+		Nodes.Internal(parent).Left = newChild;
+	}
+	else if (Nodes.Internal(parent).Right == oldChild) {
+		Nodes.Internal(parent).Right = newChild;
+	}
+
+	if (newChild != NullNode) {
+		Nodes.SetParent(newChild, parent);
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::FixRedBlackPropertiesAfterInsert(NodeRef arc)
+{
+	NodeRef parent = Nodes.Parent(arc);
+
+	if (parent == NullNode) {
+		Nodes.SetColor(arc, TreeColor::Black);
+		return;
+	}
+
+	if (Nodes.Color(parent) == TreeColor::Black) {
+		return;
+	}
+
+	NodeRef grandparent = Nodes.Parent(parent);
+
+	if (grandparent == NullNode) {
+		Nodes.SetColor(parent, TreeColor::Black);
+		return;
+	}
+
+	NodeRef uncle = GetUncle(parent);
+
+	if (uncle != NullNode && Nodes.Color(uncle) == TreeColor::Red) {
+		Nodes.SetColor(parent, TreeColor::Black);
+		Nodes.SetColor(grandparent, TreeColor::Red);
+		Nodes.SetColor(uncle, TreeColor::Black);
+
+		FixRedBlackPropertiesAfterInsert(grandparent);
+	}
+
+	else if (parent == Nodes.Internal(grandparent).Left) {
+		if (arc == Nodes.Internal(parent).Right) {
+			LeftRotation(parent);
+
+			parent = arc;
+		}
+
+		RightRotation(grandparent);
+
+		Nodes.SetColor(parent, TreeColor::Black);
+		Nodes.SetColor(grandparent, TreeColor::Red);
+	}
+
+	else {
+		if (arc == Nodes.Internal(parent).Left) {
+			RightRotation(parent);
+			parent = arc;
+		}
+
+		LeftRotation(grandparent);
+
+		Nodes.SetColor(parent, TreeColor::Black);
+		Nodes.SetColor(grandparent, TreeColor::Red);
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void RedBlackBeachLine<T>::FixRedBlackPropertiesAfterDelete(NodeRef arc)
+{
+	if (arc == Root) {
+		Nodes.SetColor(arc, TreeColor::Black);
+		return;
+	}
+
+	NodeRef parent = Nodes.Parent(arc);
+	NodeRef sibling = (arc == Nodes.Internal(parent).Left) ? Nodes.Internal(parent).Right : Nodes.Internal(parent).Left;
+
+	if (Nodes.Color(sibling) == TreeColor::Red) {
+		Nodes.SetColor(sibling, TreeColor::Black);
+		Nodes.SetColor(parent, TreeColor::Red);
+		if (arc == Nodes.Internal(parent).Left) {
+			LeftRotation(parent);
+		}
+		else {
+			RightRotation(parent);
+		}
+		parent = Nodes.Parent(arc);
+		sibling = (arc == Nodes.Internal(parent).Left) ? Nodes.Internal(parent).Right : Nodes.Internal(parent).Left;
+	}
+
+	if (Nodes.Color(Nodes.Left(sibling)) == TreeColor::Black && Nodes.Color(Nodes.Right(sibling)) == TreeColor::Black) {
+		Nodes.SetColor(sibling, TreeColor::Red);
+
+		if (Nodes.Color(parent) == TreeColor::Red) {
+			Nodes.SetColor(parent, TreeColor::Black);
+		}
+
+		else 
+		{
+			FixRedBlackPropertiesAfterDelete(parent);
+		}
+	} else 
+	{
+		bool isLeftChild = arc == Nodes.Internal(parent).Left;
+
+		if (isLeftChild && Nodes.Color(Nodes.Right(sibling)) == TreeColor::Black) {
+			Nodes.SetColor(Nodes.Left(sibling), TreeColor::Black);
+			Nodes.SetColor(sibling, TreeColor::Red);
+			RightRotation(sibling);
+			sibling = Nodes.Internal(parent).Right;
+		}
+		else if (!isLeftChild && Nodes.Color(Nodes.Left(sibling)) == TreeColor::Black) {
+			Nodes.SetColor(Nodes.Right(sibling), TreeColor::Black);
+			Nodes.SetColor(sibling, TreeColor::Red);
+			LeftRotation(sibling);
+			sibling = Nodes.Internal(parent).Left;
+		}
+
+		Nodes.SetColor(sibling, Nodes.Color(parent));
+		Nodes.SetColor(parent, TreeColor::Black);
+		if (isLeftChild) {
+			Nodes.SetColor(Nodes.Right(sibling), TreeColor::Black);
+			LeftRotation(parent);
+		}
+		else {
+			Nodes.SetColor(Nodes.Left(sibling), TreeColor::Black);
+			RightRotation(parent);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+NodeRef RedBlackBeachLine<T>::GetUncle(NodeRef parent) const {
+	NodeRef grandparent = Nodes.Parent(parent);
+	if (Nodes.Internal(grandparent).Left == parent) {
+		return Nodes.Internal(grandparent).Right;
+	}
+	return Nodes.Internal(grandparent).Left;
+}
+
+template class BL::RedBlackBeachLine<float>;
+template class BL::RedBlackBeachLine<double>;
+template class BL::RedBlackBeachLine<int64_t>;
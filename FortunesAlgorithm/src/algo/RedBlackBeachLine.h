@@ -0,0 +1,63 @@
+#pragma once
+
+#include "../types/BeachLine.h"
+#include "../types/BeachLineNode.h"
+
+namespace BL
+{
+	// The beach line as a red-black tree with the arcs as leaves and the
+	// breakpoints as internal nodes. Arc handles are the leaf NodeRefs.
+	template<typename T>
+	class RedBlackBeachLine : public BasicBeachLine<T>
+	{
+	public:
+		typedef typename BasicBeachLine<T>::Real Real;
+		typedef typename BasicBeachLine<T>::VoronoiSite VoronoiSite;
+		typedef typename BasicBeachLine<T>::EventPoint EventPoint;
+		typedef typename BasicBeachLine<T>::Edge Edge;
+
+		RedBlackBeachLine();
+
+		bool IsEmpty() const override { return NullNode == Root; }
+		void Clear() override;
+
+		ArcRef Start(VoronoiSite* site) override;
+		ArcRef FindArcAtX(Real x, Real lh) const override;
+
+		void SplitArc(ArcRef arc, VoronoiSite* left, VoronoiSite* right, const Edge& edge,
+			ArcRef& leftArc, ArcRef& rightArc) override;
+		void InsertArc(ArcRef arc, VoronoiSite* site, const Edge& leftEdge, const Edge& rightEdge,
+			ArcRef& leftArc, ArcRef& middleArc, ArcRef& rightArc) override;
+		void RemoveArc(ArcRef arc, const Edge& edge) override;
+
+		ArcRef First() const override;
+		ArcRef LeftArc(ArcRef arc) const override;
+		ArcRef RightArc(ArcRef arc) const override;
+		Edge LeftBreakpoint(ArcRef arc) const override;
+		Edge RightBreakpoint(ArcRef arc) const override;
+
+		VoronoiSite* Site(ArcRef arc) const override { return Nodes.Leaf(arc).Site; }
+		EventPoint* CircleEvent(ArcRef arc) const override { return Nodes.Leaf(arc).CircleEvent; }
+		void SetCircleEvent(ArcRef arc, EventPoint* event) override { Nodes.Leaf(arc).CircleEvent = event; }
+
+	private:
+		NodeRef SplitLeaf(NodeRef leaf, const Edge& edge);
+
+		NodeRef GetLeftParent(NodeRef root) const;
+		NodeRef GetRightParent(NodeRef root) const;
+
+		NodeRef GetClosestLeftChild(NodeRef root) const;
+		NodeRef GetClosestRightChild(NodeRef root) const;
+
+		void RightRotation(NodeRef arc);
+		void LeftRotation(NodeRef arc);
+		void ReplaceParentsChild(NodeRef parent, NodeRef oldChild, NodeRef newChild);
+
+		void FixRedBlackPropertiesAfterInsert(NodeRef arc);
+		void FixRedBlackPropertiesAfterDelete(NodeRef arc);
+		NodeRef GetUncle(NodeRef parent) const;
+
+		NodePool<T> Nodes;
+		NodeRef Root;
+	};
+}
@@ -0,0 +1,971 @@
+#include "SelfCheck.h"
+
+#include "BidirectionalSweep.h"
+#include "BreakpointBatch.h"
+#include "CellGeometry.h"
+#include "CellLocator.h"
+#include "DelaunayQueries.h"
+#include "FortunesAlgorithm.h"
+#include "IncrementalDiagram.h"
+#include "KineticDiagram.h"
+#include "LloydRelaxation.h"
+#include "Predicates.h"
+#include "SitePrepass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+////////////////////////////////////////////////////////////////////
+size_t ValidateDCEL(const VoronoiDiagram& diagram, std::ostream& os)
+{
+	size_t links = 0, faces = 0, triangles = 0;
+	for (const DCEL::HalfEdge* edge : diagram.HalfEdges)
+	{
+		if (nullptr == edge->twin || edge->twin->twin != edge || nullptr == edge->next || edge->next->prev != edge ||
+			nullptr == edge->origin || nullptr == edge->dest || edge->next->origin != edge->dest)
+			links++;
+		else if (edge->incidentFace != edge->next->incidentFace)
+			faces++;
+	}
+
+	for (const DCEL::HalfEdge* edge : diagram.TriangulationHalfEdges)
+	{
+		if (nullptr == edge->twin || edge->twin->twin != edge || edge->twin->origin != edge->dest ||
+			nullptr == edge->next || edge->next->prev != edge)
+			triangles++;
+	}
+
+	if (0 != links) os << "  " << links << " Voronoi half edges with broken links" << std::endl;
+	if (0 != faces) os << "  " << faces << " Voronoi half edges leaving their face" << std::endl;
+	if (0 != triangles) os << "  " << triangles << " Delaunay half edges with broken links" << std::endl;
+	return links + faces + triangles;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckLattices(std::ostream& os)
+{
+	const BL::BeachLineType beachLines[] = { BL::BeachLineType::RedBlack, BL::BeachLineType::BTree };
+	const SweepAxis axes[] = { SweepAxis::Y, SweepAxis::X };
+
+	bool passed = true;
+	for (size_t n = 2; n <= 30; n++)
+	{
+		std::vector<Point> points;
+		for (size_t i = 0; i < n; i++)
+			for (size_t j = 0; j < n; j++)
+				points.push_back(Point(10.0 * i, 10.0 * j));
+
+		for (BL::BeachLineType beachLine : beachLines)
+		{
+			for (SweepAxis axis : axes)
+			{
+				VoronoiDiagram diagram(points);
+				FortunesAlgorithm algorithm(diagram, axis, beachLine);
+				algorithm.SetVerbose(false);
+				algorithm.Run();
+
+				size_t triangles = 0;
+				for (const DCEL::Face* face : diagram.TriangulationFaces)
+					triangles += face->Unbounded ? 0 : 1;
+
+				const size_t faults = ValidateDCEL(diagram, os);
+				if (0 == faults && 2 * (n - 1) * (n - 1) == triangles)
+					continue;
+
+				os << "Lattice " << n << "x" << n << (BL::BeachLineType::BTree == beachLine ? " BTree" : " RedBlack")
+					<< (SweepAxis::X == axis ? " along x" : " along y") << ": " << triangles << " triangles" << std::endl;
+				passed = false;
+			}
+		}
+	}
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckSimdLevels(std::ostream& os)
+{
+	// Not a multiple of any vector width, so the tails run too
+	const size_t count = 10007;
+	const double lh = 0.5;
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> coordinate(-1000.0, 1000.0);
+	std::vector<double> leftX(count), leftY(count), rightX(count), rightY(count), x(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		leftX[i] = coordinate(random);
+		rightX[i] = coordinate(random);
+		leftY[i] = (0 == i % 13) ? lh : lh + 1000.0 + coordinate(random);
+		rightY[i] = (0 == i % 11) ? leftY[i] : (0 == i % 17) ? lh : lh + 1000.0 + coordinate(random);
+		x[i] = coordinate(random);
+	}
+	const Point focus(coordinate(random), lh + 1000.0 + coordinate(random));
+
+	const SimdLevel previous = GetSimdLevel();
+	std::vector<double> scalarX(count), scalarY(count), levelX(count), levelY(count);
+	SetSimdLevel(SimdLevel::Scalar);
+	IntersectionXBatch(leftX.data(), leftY.data(), rightX.data(), rightY.data(), lh, scalarX.data(), count);
+	CalculateParabolaYBatch(x.data(), lh, focus, scalarY.data(), count);
+
+	bool passed = true;
+	const SimdLevel levels[] = { SimdLevel::AVX2, SimdLevel::AVX512 };
+	for (SimdLevel level : levels)
+	{
+		SetSimdLevel(level);
+		if (level != GetSimdLevel())
+			continue;
+
+		IntersectionXBatch(leftX.data(), leftY.data(), rightX.data(), rightY.data(), lh, levelX.data(), count);
+		CalculateParabolaYBatch(x.data(), lh, focus, levelY.data(), count);
+
+		size_t breakpoints = 0, parabolas = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			breakpoints += 0 != std::memcmp(&levelX[i], &scalarX[i], sizeof(double)) ? 1 : 0;
+			parabolas += 0 != std::memcmp(&levelY[i], &scalarY[i], sizeof(double)) ? 1 : 0;
+		}
+
+		if (0 == breakpoints && 0 == parabolas)
+			continue;
+
+		os << "SIMD level " << int(level) << ": " << breakpoints << " breakpoints and "
+			<< parabolas << " parabola points differ from scalar" << std::endl;
+		passed = false;
+	}
+
+	SetSimdLevel(previous);
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+// Whether the point is on the inner side of every edge of the cell
+static bool InCell(const DCEL::Face* face, const Point& point)
+{
+	const DCEL::HalfEdge* edge = face->outerComponent;
+	if (nullptr == edge)
+		return false;
+	do
+	{
+		const Point& a = edge->origin->point;
+		const Point& b = edge->dest->point;
+		if ((b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x) < -1e-6)
+			return false;
+		edge = edge->next;
+	} while (edge != face->outerComponent);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckPowerDiagrams(std::ostream& os)
+{
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+
+	std::vector<std::vector<Point>> inputs;
+	inputs.push_back({ Point(0, 0), Point(10, 1), Point(20, 2), Point(30, 3) });
+	inputs.push_back({});
+	for (int i = 0; i < 300; i++)
+		inputs.back().push_back(Point(coordinate(random), coordinate(random)));
+
+	bool passed = true;
+	for (size_t k = 0; k < inputs.size(); k++)
+	{
+		VoronoiDiagram diagram(inputs[k]);
+		for (VoronoiSite* site : diagram.Sites)
+			site->weight = (0 == k) ? (site == diagram.Sites[0] ? 80.0 : 0.0) : 3.0 * coordinate(random);
+		FortunesAlgorithm algorithm(diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+
+		// Random points belong to the cell of the site of least power
+		size_t misplaced = 0;
+		std::uniform_real_distribution<double> x(diagram.MinX - 1.0, diagram.MaxX + 1.0), y(diagram.MinY - 1.0, diagram.MaxY + 1.0);
+		for (int i = 0; i < 1000; i++)
+		{
+			const Point point(x(random), y(random));
+			const VoronoiSite* nearest = nullptr;
+			double least = 0;
+			for (const VoronoiSite* site : diagram.Sites)
+			{
+				const double power = (point.x - site->point.x) * (point.x - site->point.x)
+					+ (point.y - site->point.y) * (point.y - site->point.y) - site->weight;
+				if (nullptr == nearest || power < least)
+				{
+					nearest = site;
+					least = power;
+				}
+			}
+			misplaced += InCell(nearest->face, point) ? 0 : 1;
+		}
+
+		const size_t faults = ValidateDCEL(diagram, os);
+		if (algorithm.GetPowerReport().Applied && 0 == faults && 0 == misplaced)
+			continue;
+
+		os << "Power diagram of " << inputs[k].size() << (0 == k ? " sites on a line: " : " sites: ")
+			<< (algorithm.GetPowerReport().Applied ? "" : "not applied, ") << misplaced << " points outside their cell" << std::endl;
+		passed = false;
+	}
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckSitePrepass(std::ostream& os)
+{
+	bool passed = true;
+
+	// Integer sites one apart at the limit are distinct, the duplicate of one is not and
+	// the input beyond the limit has no site
+	const int64_t far = CoordinateTraits<int64_t>::Limit;
+	std::vector<BasicPoint<int64_t>> integers = { BasicPoint<int64_t>(far, 0), BasicPoint<int64_t>(far - 1, 0),
+		BasicPoint<int64_t>(far, 0), BasicPoint<int64_t>(0, far), BasicPoint<int64_t>(far + 1, 0) };
+	BasicVoronoiDiagram<int64_t> wide(integers);
+	const SitePrepassReport wideReport = PrepareSites(wide);
+	if (1 != wideReport.Duplicates || 3 != wide.Sites.size() || wide.SiteOfInput[0] != wide.SiteOfInput[2] ||
+		0 != wide.SiteOfInput[4])
+	{
+		os << "Prepass of integer sites at 2^53: " << wideReport.Duplicates << " duplicates" << std::endl;
+		passed = false;
+	}
+
+	// A lattice has a co-circular group per square and a top row as long as its left column
+	std::vector<Point> lattice;
+	for (int i = 0; i < 10; i++)
+		for (int j = 0; j < 10; j++)
+			lattice.push_back(Point(10.0 * i, 10.0 * j));
+	VoronoiDiagram grid(lattice);
+	const SitePrepassReport gridReport = PrepareSites(grid);
+	if (81 != gridReport.CoCircularGroups || 10 != gridReport.FirstRowSites || SweepAxis::Y != gridReport.Axis)
+	{
+		os << "Prepass of a 10x10 lattice: " << gridReport.CoCircularGroups << " co-circular groups" << std::endl;
+		passed = false;
+	}
+
+	// Twelve sites on one circle, no four of them the corners of an upright rectangle,
+	// are one group and the sites far outside it are in none
+	std::vector<Point> ring = { Point(100, 100), Point(-100, 100), Point(100, -100) };
+	const int onCircle[][2] = { { 25, 0 }, { 24, 7 }, { 20, 15 }, { 15, 20 }, { 7, 24 }, { 0, 25 },
+		{ -7, 24 }, { -15, 20 }, { -20, 15 }, { -24, 7 }, { -25, 0 }, { -24, -7 } };
+	for (const int* p : onCircle)
+		ring.push_back(Point(p[0], p[1]));
+	VoronoiDiagram hollow(ring);
+	const SitePrepassReport hollowReport = PrepareSites(hollow);
+	const size_t onRing = std::count(hollowReport.Clustered.begin(), hollowReport.Clustered.end(), 1);
+	if (1 != hollowReport.CoCircularGroups || 12 != onRing || hollowReport.Clustered[0] || hollowReport.Clustered[1] || hollowReport.Clustered[2])
+	{
+		os << "Prepass of twelve sites on a circle: " << hollowReport.CoCircularGroups << " co-circular groups, "
+			<< onRing << " sites on them" << std::endl;
+		passed = false;
+	}
+
+	// Enough clustered sites to fold on every thread. Every folded site lies within the
+	// tolerance of its representative and the kept ones are further apart.
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> coordinate(0.0, 100.0);
+	std::vector<Point> clustered;
+	for (int i = 0; i < 6000; i++)
+		clustered.push_back(Point(coordinate(random), coordinate(random)));
+	const double tolerance = 0.5;
+	VoronoiDiagram folded(clustered);
+	const SitePrepassReport foldedReport = PrepareSites(folded, tolerance);
+
+	size_t faults = 0;
+	for (size_t i = 0; i < clustered.size(); i++)
+	{
+		const Point& site = folded.Sites[folded.SiteOfInput[i] - 1]->point;
+		const double dx = site.x - clustered[i].x, dy = site.y - clustered[i].y;
+		faults += (dx * dx + dy * dy <= tolerance * tolerance) ? 0 : 1;
+	}
+	for (size_t i = 0; i < folded.Sites.size(); i++)
+	{
+		for (size_t j = i + 1; j < folded.Sites.size(); j++)
+		{
+			const double dx = folded.Sites[i]->point.x - folded.Sites[j]->point.x;
+			const double dy = folded.Sites[i]->point.y - folded.Sites[j]->point.y;
+			faults += (dx * dx + dy * dy <= tolerance * tolerance) ? 1 : 0;
+		}
+	}
+	if (0 != faults || folded.Sites.size() + foldedReport.Duplicates != clustered.size())
+	{
+		os << "Prepass with a tolerance: " << faults << " sites folded wrongly" << std::endl;
+		passed = false;
+	}
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckReorderForLocality(std::ostream& os)
+{
+	std::mt19937 random(13);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 2000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	{
+		FortunesAlgorithm algorithm(diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+	}
+	std::vector<double> areas(points.size());
+	for (size_t i = 0; i < diagram.Sites.size(); i++)
+		areas[diagram.InputOrder[i]] = diagram.Metrics().Area[i];
+	diagram.ReorderForLocality();
+
+	// Records in order sit at ascending addresses and every cell keeps its area
+	size_t faults = ValidateDCEL(diagram, os);
+	for (size_t i = 1; i < diagram.HalfEdges.size(); i++)
+		faults += (diagram.HalfEdges[i - 1] < diagram.HalfEdges[i]) ? 0 : 1;
+	for (size_t i = 1; i < diagram.Faces.size(); i++)
+		faults += (diagram.Faces[i - 1] < diagram.Faces[i]) ? 0 : 1;
+	for (size_t i = 0; i < diagram.Sites.size(); i++)
+	{
+		const VoronoiSite* site = diagram.Sites[i];
+		faults += (site->index == int(i) + 1 && site->face->site == site) ? 0 : 1;
+		faults += (std::abs(areas[diagram.InputOrder[i]] - diagram.Metrics().Area[i]) <= 1e-9) ? 0 : 1;
+	}
+	if (0 != faults)
+		os << "Reordering for locality: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckReallocations(std::ostream& os)
+{
+	std::mt19937 random(17);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 20000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	const size_t swept = diagram.Reallocations;
+	os << "Sweep of " << points.size() << " sites: " << swept << " container reallocations" << std::endl;
+
+	// Without the reserve, sites added afterwards grow the containers
+	diagram.ShrinkToFit();
+	BasicIncrementalDiagram<double> incremental(diagram);
+	for (int i = 0; i < 100; i++)
+		incremental.InsertSite(Point(coordinate(random), coordinate(random)));
+	const size_t grown = diagram.Reallocations;
+
+	if (0 == swept && 0 != grown)
+		return true;
+	os << "Reallocations: " << swept << " in the sweep, " << grown << " after shrinking" << std::endl;
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckBidirectionalSweep(std::ostream& os)
+{
+	std::mt19937 random(19);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<std::vector<Point>> inputs(2);
+	for (int i = 0; i < 3000; i++)
+		inputs[0].push_back(Point(coordinate(random), coordinate(random)));
+	for (int i = 0; i < 12; i++)
+		for (int j = 0; j < 12; j++)
+			inputs[1].push_back(Point(10.0 * i, 10.0 * j));
+
+	bool passed = true;
+	for (std::vector<Point>& points : inputs)
+	{
+		BidirectionalSweep bidirectional(points);
+		bidirectional.Run();
+		VoronoiDiagram& merged = bidirectional.GetDiagram();
+
+		VoronoiDiagram whole(points);
+		FortunesAlgorithm algorithm(whole);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+
+		// The merged cells are those of the whole sweep
+		size_t faults = ValidateDCEL(merged, os);
+		faults += (merged.TriangulationFaces.size() == whole.TriangulationFaces.size()) ? 0 : 1;
+		for (size_t i = 0; i < whole.Sites.size(); i++)
+		{
+			const double area = whole.Metrics().Area[i];
+			faults += (std::abs(merged.Metrics().Area[i] - area) <= 1e-9 * (1.0 + area)) ? 0 : 1;
+		}
+		if (bidirectional.IsMerged() && 0 == faults)
+			continue;
+
+		os << "Bidirectional sweep of " << points.size() << " sites: " << (bidirectional.IsMerged() ? "" : "not merged, ")
+			<< faults << " faults" << std::endl;
+		passed = false;
+	}
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+// Sweeps the sites of the diagram again and counts the sites whose Delaunay neighbours
+// differ from those of the new sweep
+static size_t CompareWithRebuild(const VoronoiDiagram& diagram)
+{
+	std::vector<Point> points;
+	for (const VoronoiSite* site : diagram.Sites)
+		points.push_back(site->point);
+	VoronoiDiagram rebuilt(points);
+	FortunesAlgorithm algorithm(rebuilt);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+
+	std::vector<size_t> offsets, rebuiltOffsets;
+	std::vector<int> neighbours, rebuiltNeighbours;
+	NeighbourGraph(diagram, offsets, neighbours);
+	NeighbourGraph(rebuilt, rebuiltOffsets, rebuiltNeighbours);
+
+	size_t differ = 0;
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		std::vector<int> row(neighbours.begin() + offsets[i], neighbours.begin() + offsets[i + 1]);
+		std::vector<int> rebuiltRow(rebuiltNeighbours.begin() + rebuiltOffsets[i], rebuiltNeighbours.begin() + rebuiltOffsets[i + 1]);
+		std::sort(row.begin(), row.end());
+		std::sort(rebuiltRow.begin(), rebuiltRow.end());
+		differ += (row == rebuiltRow) ? 0 : 1;
+	}
+	return differ;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckRelaxation(std::ostream& os)
+{
+	std::mt19937 random(23);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 3000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	// Each relaxation moves the sites less than the one before
+	VoronoiDiagram diagram(points);
+	const RelaxationReport first = Relax(diagram, 1);
+	const RelaxationReport later = Relax(diagram, 20);
+	size_t faults = ValidateDCEL(diagram, os);
+	faults += (20 == later.Iterations && later.LargestMove < first.LargestMove) ? 0 : 1;
+	faults += CompareWithRebuild(diagram);
+
+	// A sweep reset between moves holds as many records after many moves as after the first
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	std::uniform_real_distribution<double> jitter(-0.5, 0.5);
+	size_t records = 0, capacity = 0;
+	for (int i = 0; i < 40; i++)
+	{
+		for (VoronoiSite* site : diagram.Sites)
+			site->point = Point(site->point.x + jitter(random), site->point.y + jitter(random));
+		diagram.ClearDCEL();
+		algorithm.Reset();
+		algorithm.Run();
+
+		const size_t held = diagram.Faces.capacity() + diagram.Vertices.capacity() + diagram.HalfEdges.capacity()
+			+ diagram.TriangulationFaces.capacity() + diagram.TriangulationVertices.capacity() + diagram.TriangulationHalfEdges.capacity();
+		if (0 == i)
+		{
+			records = algorithm.GetEdgeRecords();
+			capacity = held;
+		}
+		faults += (algorithm.GetEdgeRecords() <= records + records / 50 && held <= capacity + capacity / 50) ? 0 : 1;
+	}
+	faults += ValidateDCEL(diagram, os);
+
+	if (0 != faults)
+		os << "Lloyd relaxation of " << points.size() << " sites: " << faults << " faults, moves " << first.LargestMove
+			<< " then " << later.LargestMove << ", " << algorithm.GetEdgeRecords() << " edge records held" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckIntegerPredicates(std::ostream& os)
+{
+	typedef SitePredicates<int64_t> Predicates;
+	typedef Predicates::SitePoint SitePoint;
+
+	auto sign = [](double value) { return (value > 0.0) - (value < 0.0); };
+
+	// The integer path must agree with the exact double one, near the origin and at the
+	// edge of the range where it still applies
+	std::mt19937_64 random(36);
+	size_t wrong = 0;
+	for (const int64_t spread : { int64_t(8), int64_t(1) << 20, int64_t(1) << 29 })
+	{
+		std::uniform_int_distribution<int64_t> coordinate(-spread, spread);
+		for (int i = 0; i < 20000; i++)
+		{
+			SitePoint p[4] = { SitePoint(0, 0), SitePoint(0, 0), SitePoint(0, 0), SitePoint(0, 0) };
+			for (SitePoint& q : p)
+				q = SitePoint(Predicates::Real(coordinate(random)), Predicates::Real(coordinate(random)));
+
+			const double integer = Predicates::InCircle(p[0], p[1], p[2], p[3]);
+			const double exact = ::InCircle(Point(double(p[0].x), double(p[0].y)), Point(double(p[1].x), double(p[1].y)),
+				Point(double(p[2].x), double(p[2].y)), Point(double(p[3].x), double(p[3].y)));
+			wrong += sign(integer) == sign(exact) ? 0 : 1;
+		}
+	}
+
+	// Points on one circle of radius 5^4 about a centre near 2^29 are co-circular
+	const Predicates::Real centre = Predicates::Real((int64_t(1) << 29) - 625);
+	const SitePoint circle[4] = { SitePoint(centre + 625, centre), SitePoint(centre + 375, centre + 500),
+		SitePoint(centre - 336, centre + 527), SitePoint(centre, centre - 625) };
+	const double onCircle = Predicates::InCircle(circle[0], circle[1], circle[2], circle[3]);
+	const double inside = Predicates::InCircle(circle[0], circle[1], circle[2], SitePoint(centre + 1, centre));
+
+	if (0 != wrong || 0.0 != onCircle || inside <= 0.0)
+	{
+		os << "Integer InCircle: " << wrong << " signs differ, " << onCircle << " on the circle, " << inside
+			<< " inside" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////
+static double SquaredDistance(const Point& a, const Point& b)
+{
+	return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+////////////////////////////////////////////////////////////////////
+// The squared distance from the point to the nearest site, by looking at every site
+static double NearestByScan(const VoronoiDiagram& diagram, const Point& point)
+{
+	double nearest = std::numeric_limits<double>::max();
+	for (const VoronoiSite* site : diagram.Sites)
+		nearest = std::min(nearest, SquaredDistance(site->point, point));
+	return nearest;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckCellLocator(std::ostream& os)
+{
+	std::mt19937 random(29);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 2000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	CellLocator locator(diagram);
+
+	// Queries reach past the sites so the cells along the hull are asked for as well
+	std::uniform_real_distribution<double> query(-200.0, 1200.0);
+	std::vector<Point> queries;
+	for (int i = 0; i < 5000; i++)
+		queries.push_back(Point(query(random), query(random)));
+	std::vector<DCEL::Face*> cells(queries.size());
+	locator.LocateCells(queries.data(), queries.size(), cells.data());
+
+	size_t faults = 0;
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		const DCEL::Face* cell = locator.LocateCell(queries[i]);
+		const double nearest = NearestByScan(diagram, queries[i]);
+		faults += (nullptr != cell && SquaredDistance(cell->site->point, queries[i]) <= nearest * (1.0 + 1e-12)) ? 0 : 1;
+		faults += (cells[i] == cell) ? 0 : 1;
+	}
+	if (0 != faults)
+		os << "Cell locator on " << points.size() << " sites: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckNearestSite(std::ostream& os)
+{
+	std::mt19937 random(31);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 2000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+	// A lattice block puts four co-circular sites around many of the queries
+	for (int i = 0; i < 10; i++)
+		for (int j = 0; j < 10; j++)
+			points.push_back(Point(1100.0 + 10.0 * i, 10.0 * j));
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+
+	// Cold walks from the first site, warm ones along a path from the previous answer,
+	// and the batch in Hilbert order
+	std::uniform_real_distribution<double> query(-200.0, 1300.0);
+	std::vector<Point> queries;
+	for (int i = 0; i < 3000; i++)
+	{
+		const Point last = queries.empty() ? Point(0.0, 0.0) : queries.back();
+		queries.push_back(0 == i % 2 ? Point(query(random), query(random)) : Point(last.x + 3.0, last.y - 2.0));
+	}
+	std::vector<VoronoiSite*> batch(queries.size());
+	NearestSites(diagram, queries.data(), queries.size(), batch.data());
+
+	size_t faults = 0;
+	VoronoiSite* warm = nullptr;
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		const double nearest = NearestByScan(diagram, queries[i]) * (1.0 + 1e-12);
+		const VoronoiSite* cold = NearestSite(diagram, queries[i]);
+		warm = NearestSite(diagram, queries[i], warm);
+		faults += (nullptr != cold && SquaredDistance(cold->point, queries[i]) <= nearest) ? 0 : 1;
+		faults += (nullptr != warm && SquaredDistance(warm->point, queries[i]) <= nearest) ? 0 : 1;
+		faults += (nullptr != batch[i] && SquaredDistance(batch[i]->point, queries[i]) <= nearest) ? 0 : 1;
+	}
+	if (0 != faults)
+		os << "Nearest site walks on " << points.size() << " sites: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckKNearest(std::ostream& os)
+{
+	std::mt19937 random(37);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 1500; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	const size_t n = diagram.Sites.size();
+
+	// The k found are as near as the k nearest of a sorted scan, nearest first
+	const size_t k = 10;
+	size_t faults = 0;
+	std::vector<VoronoiSite*> found;
+	std::vector<double> scan(n);
+	for (int i = 0; i < 300; i++)
+	{
+		const Point query(coordinate(random), coordinate(random));
+		KNearest(diagram, query, k, found);
+		for (size_t j = 0; j < n; j++)
+			scan[j] = SquaredDistance(diagram.Sites[j]->point, query);
+		std::partial_sort(scan.begin(), scan.begin() + k, scan.end());
+		faults += (k == found.size()) ? 0 : 1;
+		for (size_t j = 0; j < found.size() && j < k; j++)
+			faults += (std::abs(SquaredDistance(found[j]->point, query) - scan[j]) <= 1e-9 * (1.0 + scan[j])) ? 0 : 1;
+	}
+
+	// Every row of the graph holds k other sites, their distances are those of a scan, and
+	// a site nearer to its neighbour than that neighbour's k-th is in the neighbour's row
+	const size_t row = 6;
+	std::vector<size_t> offsets;
+	std::vector<int> neighbours;
+	KNearestGraph(diagram, row, offsets, neighbours);
+	faults += (n + 1 == offsets.size() && n * row == offsets[n] && n * row == neighbours.size()) ? 0 : 1;
+	auto distance = [&diagram](int a, int b) { return SquaredDistance(diagram.Sites[a - 1]->point, diagram.Sites[b - 1]->point); };
+	for (size_t i = 0; 0 == faults && i < n; i++)
+	{
+		const int index = int(i) + 1;
+		for (size_t j = 0; j < n; j++)
+			scan[j] = (j == i) ? std::numeric_limits<double>::max() : distance(index, int(j) + 1);
+		std::partial_sort(scan.begin(), scan.begin() + row, scan.end());
+		for (size_t j = offsets[i]; j < offsets[i + 1]; j++)
+		{
+			const int other = neighbours[j];
+			faults += (other >= 1 && other <= int(n) && other != index) ? 0 : 1;
+			if (other < 1 || other > int(n))
+				continue;
+			faults += (std::abs(distance(index, other) - scan[j - offsets[i]]) <= 1e-9 * (1.0 + scan[j - offsets[i]])) ? 0 : 1;
+
+			const int* otherRow = &neighbours[offsets[other - 1]];
+			if (distance(index, other) < distance(other, otherRow[row - 1]))
+				faults += (std::find(otherRow, otherRow + row, index) != otherRow + row) ? 0 : 1;
+		}
+	}
+	if (0 != faults)
+		os << "K nearest on " << n << " sites: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckNeighbourGraph(std::ostream& os)
+{
+	std::mt19937 random(41);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<std::vector<Point>> inputs(2);
+	for (int i = 0; i < 2000; i++)
+		inputs[0].push_back(Point(coordinate(random), coordinate(random)));
+	for (int i = 0; i < 15; i++)
+		for (int j = 0; j < 15; j++)
+			inputs[1].push_back(Point(10.0 * i, 10.0 * j));
+
+	bool passed = true;
+	for (std::vector<Point>& points : inputs)
+	{
+		VoronoiDiagram diagram(points);
+		FortunesAlgorithm algorithm(diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+		const size_t n = diagram.Sites.size();
+
+		std::vector<size_t> offsets, serialOffsets;
+		std::vector<int> neighbours, serialNeighbours;
+		std::vector<double> lengths, serialLengths;
+		NeighbourGraph(diagram, offsets, neighbours, &lengths);
+		NeighbourGraph(diagram, serialOffsets, serialNeighbours, &serialLengths, 1);
+
+		// The rows hold each Delaunay edge once from either end, so the degrees sum to the
+		// half edges, whatever the threads
+		std::vector<std::pair<int, int>> pairs;
+		for (const DCEL::HalfEdge* edge : diagram.TriangulationHalfEdges)
+			pairs.push_back({ edge->origin->index, edge->dest->index });
+		std::sort(pairs.begin(), pairs.end());
+		pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+		size_t faults = (n + 1 == offsets.size() && pairs.size() == offsets[n] && neighbours.size() == offsets[n]
+			&& lengths.size() == offsets[n]) ? 0 : 1;
+		faults += (offsets == serialOffsets && neighbours == serialNeighbours && lengths == serialLengths) ? 0 : 1;
+
+		// Every neighbour is a Delaunay neighbour and the pair agrees on the length of its edge
+		for (size_t i = 0; 0 == faults && i < n; i++)
+		{
+			const int index = int(i) + 1;
+			for (size_t j = offsets[i]; j < offsets[i + 1]; j++)
+			{
+				const int other = neighbours[j];
+				faults += std::binary_search(pairs.begin(), pairs.end(), std::make_pair(index, other)) ? 0 : 1;
+				if (other < 1 || other > int(n))
+					continue;
+
+				const int* begin = &neighbours[offsets[other - 1]];
+				const int* end = begin + (offsets[other] - offsets[other - 1]);
+				const int* back = std::find(begin, end, index);
+				faults += (back != end && lengths[offsets[other - 1] + (back - begin)] == lengths[j] && lengths[j] >= 0.0) ? 0 : 1;
+			}
+		}
+		if (0 == faults)
+			continue;
+
+		os << "Neighbour graph of " << n << " sites: " << faults << " faults" << std::endl;
+		passed = false;
+	}
+	return passed;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckCellExtraction(std::ostream& os)
+{
+	std::mt19937 random(43);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 3000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	{
+		FortunesAlgorithm algorithm(diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+	}
+	const CellPolygons cells = ExtractCells(diagram, true);
+	const CellPolygons serial = ExtractCells(diagram, true, 1);
+
+	// A sweep the other way with the other beach line measures the same cells
+	VoronoiDiagram fresh(points);
+	FortunesAlgorithm algorithm(fresh, SweepAxis::X, BL::BeachLineType::BTree);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	const VoronoiDiagram::CellMetrics& metrics = fresh.Metrics();
+
+	const size_t n = diagram.Sites.size();
+	size_t faults = (n + 1 == cells.Offsets.size() && n == cells.Areas.size() && 2 * n == cells.Centroids.size()
+		&& 2 * cells.Offsets[n] == cells.Coordinates.size()) ? 0 : 1;
+	faults += (cells.Coordinates == serial.Coordinates && cells.Offsets == serial.Offsets && cells.Areas == serial.Areas
+		&& cells.Centroids == serial.Centroids) ? 0 : 1;
+	for (size_t i = 0; 0 == faults && i < n; i++)
+	{
+		const double area = metrics.Area[i];
+		const double tolerance = 1e-9 * (1.0 + area);
+		faults += (std::abs(cells.Areas[i] - area) <= tolerance) ? 0 : 1;
+		faults += (std::abs(cells.Centroids[2 * i] - metrics.CentroidX[i]) <= 1e-9 * 1000.0
+			&& std::abs(cells.Centroids[2 * i + 1] - metrics.CentroidY[i]) <= 1e-9 * 1000.0) ? 0 : 1;
+
+		// The corners run counterclockwise around the area measured
+		double twice = 0.0;
+		const size_t begin = cells.Offsets[i], end = cells.Offsets[i + 1];
+		for (size_t j = begin; j < end; j++)
+		{
+			const size_t k = (j + 1 < end) ? j + 1 : begin;
+			twice += cells.Coordinates[2 * j] * cells.Coordinates[2 * k + 1] - cells.Coordinates[2 * k] * cells.Coordinates[2 * j + 1];
+		}
+		faults += (twice > 0.0 && std::abs(twice / 2.0 - area) <= 1e-6 * (1.0 + area)) ? 0 : 1;
+	}
+	if (0 != faults)
+		os << "Cell extraction of " << n << " sites: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckCellMetrics(std::ostream& os)
+{
+	std::mt19937 random(47);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 3000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	{
+		FortunesAlgorithm algorithm(diagram);
+		algorithm.SetVerbose(false);
+		algorithm.Run();
+	}
+	const VoronoiDiagram::CellMetrics metrics = diagram.Metrics();
+	diagram.InvalidateMetrics();
+	const VoronoiDiagram::CellMetrics& serial = diagram.Metrics(1);
+
+	VoronoiDiagram fresh(points);
+	FortunesAlgorithm algorithm(fresh, SweepAxis::X, BL::BeachLineType::BTree);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+	const VoronoiDiagram::CellMetrics& swept = fresh.Metrics();
+
+	// A cell borders the Delaunay neighbours whose shared edge has some length in the box
+	std::vector<size_t> offsets;
+	std::vector<int> neighbours;
+	std::vector<double> lengths;
+	NeighbourGraph(diagram, offsets, neighbours, &lengths);
+
+	const size_t n = diagram.Sites.size();
+	size_t faults = (metrics.Area == serial.Area && metrics.Perimeter == serial.Perimeter && metrics.CentroidX == serial.CentroidX
+		&& metrics.CentroidY == serial.CentroidY && metrics.Degree == serial.Degree) ? 0 : 1;
+	for (size_t i = 0; i < n; i++)
+	{
+		const double tolerance = 1e-9 * (1.0 + metrics.Area[i] + metrics.Perimeter[i]);
+		faults += (std::abs(metrics.Area[i] - swept.Area[i]) <= tolerance
+			&& std::abs(metrics.Perimeter[i] - swept.Perimeter[i]) <= tolerance
+			&& std::abs(metrics.CentroidX[i] - swept.CentroidX[i]) <= 1e-9 * 1000.0
+			&& std::abs(metrics.CentroidY[i] - swept.CentroidY[i]) <= 1e-9 * 1000.0
+			&& metrics.Degree[i] == swept.Degree[i]) ? 0 : 1;
+
+		int bordering = 0;
+		for (size_t j = offsets[i]; j < offsets[i + 1]; j++)
+			bordering += (lengths[j] > 1e-9) ? 1 : 0;
+		faults += (bordering == metrics.Degree[i]) ? 0 : 1;
+	}
+	if (0 != faults)
+		os << "Cell metrics of " << n << " sites: " << faults << " faults" << std::endl;
+	return 0 == faults;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckIncrementalDiagram(std::ostream& os)
+{
+	std::mt19937 random(53);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::vector<Point> points;
+	for (int i = 0; i < 2000; i++)
+		points.push_back(Point(coordinate(random), coordinate(random)));
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+
+	// Sites come and go inside the hull and beyond it, then the triangulation is that
+	// of a sweep over the sites left
+	BasicIncrementalDiagram<double> incremental(diagram);
+	std::uniform_real_distribution<double> wider(-100.0, 1100.0);
+	size_t faults = 0;
+	for (int i = 0; i < 600; i++)
+	{
+		if (0 == i % 3)
+			incremental.RemoveSite(diagram.Sites[random() % diagram.Sites.size()]);
+		else
+			faults += (nullptr != incremental.InsertSite(Point(wider(random), wider(random)))) ? 0 : 1;
+	}
+	faults += ValidateDCEL(diagram, os);
+
+	// Every input left maps to the site standing at its point
+	for (size_t i = 0; i < diagram.SiteOfInput.size(); i++)
+	{
+		const int index = diagram.SiteOfInput[i];
+		if (index < 0 || index > int(diagram.Sites.size()))
+			faults++;
+		else if (0 != index)
+			faults += (diagram.Sites[index - 1]->point == diagram.Points[i] && diagram.InputOrder[index - 1] == int(i)) ? 0 : 1;
+	}
+	const size_t differ = CompareWithRebuild(diagram);
+	if (0 != faults || 0 != differ)
+		os << "Incremental updates to " << diagram.Sites.size() << " sites: " << faults << " faults, " << differ
+			<< " sites with other neighbours than a rebuild" << std::endl;
+	return 0 == faults && 0 == differ;
+}
+
+////////////////////////////////////////////////////////////////////
+bool CheckKineticDiagram(std::ostream& os)
+{
+	std::mt19937 random(59);
+	std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+	std::uniform_real_distribution<double> speed(-2.0, 2.0);
+	std::vector<Point> points, velocities;
+	for (int i = 0; i < 1500; i++)
+	{
+		points.push_back(Point(coordinate(random), coordinate(random)));
+		velocities.push_back(Point(speed(random), speed(random)));
+	}
+
+	VoronoiDiagram diagram(points);
+	FortunesAlgorithm algorithm(diagram);
+	algorithm.SetVerbose(false);
+	algorithm.Run();
+
+	// Each step flips some edges and the triangulation stays that of a sweep at the
+	// positions reached
+	BasicKineticDiagram<double> kinetic(diagram);
+	size_t faults = 0, flips = 0, rebuilds = 0, differ = 0;
+	const int steps = 20;
+	for (int step = 0; step < steps; step++)
+	{
+		for (size_t i = 0; i < points.size(); i++)
+			points[i] = Point(points[i].x + velocities[i].x, points[i].y + velocities[i].y);
+		const KineticReport report = kinetic.Advance(points.data());
+		flips += report.Flips;
+		rebuilds += report.Rebuilt ? 1 : 0;
+
+		faults += ValidateDCEL(diagram, os);
+		for (size_t i = 0; i < diagram.Sites.size(); i++)
+			faults += (diagram.Sites[i]->point == points[diagram.InputOrder[i]]) ? 0 : 1;
+		differ += CompareWithRebuild(diagram);
+	}
+	if (0 != faults || 0 != differ || 0 == flips || steps == int(rebuilds))
+		os << "Kinetic steps of " << diagram.Sites.size() << " sites: " << faults << " faults, " << differ
+			<< " sites with other neighbours than a rebuild, " << flips << " flips, " << rebuilds << " rebuilds" << std::endl;
+	return 0 == faults && 0 == differ && 0 != flips && steps != int(rebuilds);
+}
+
+////////////////////////////////////////////////////////////////////
+bool RunSelfChecks(std::ostream& os)
+{
+	bool passed = true;
+	passed = CheckLattices(os) && passed;
+	passed = CheckSimdLevels(os) && passed;
+	passed = CheckPowerDiagrams(os) && passed;
+	passed = CheckIntegerPredicates(os) && passed;
+	passed = CheckSitePrepass(os) && passed;
+	passed = CheckReorderForLocality(os) && passed;
+	passed = CheckReallocations(os) && passed;
+	passed = CheckBidirectionalSweep(os) && passed;
+	passed = CheckRelaxation(os) && passed;
+	passed = CheckCellLocator(os) && passed;
+	passed = CheckNearestSite(os) && passed;
+	passed = CheckKNearest(os) && passed;
+	passed = CheckNeighbourGraph(os) && passed;
+	passed = CheckCellExtraction(os) && passed;
+	passed = CheckCellMetrics(os) && passed;
+	passed = CheckIncrementalDiagram(os) && passed;
+	passed = CheckKineticDiagram(os) && passed;
+	os << (passed ? "All checks passed" : "Checks failed") << std::endl;
+	return passed;
+}
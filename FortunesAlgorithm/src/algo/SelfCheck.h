@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <iostream>
+
+// Checks that run the algorithm on inputs known to be hard and report what they find.
+// Application runs them all with the --check argument.
+
+// Parameters
+//		diagram : a diagram that has been run to completion
+//		os      : receives a line for every kind of fault found
+// Walks both DCELs and counts the half edges whose twin, next, prev or face links
+// disagree with each other. Returns the number of faults.
+size_t ValidateDCEL(const VoronoiDiagram& diagram, std::ostream& os);
+
+// Sweeps every n by n square lattice from 2 to 30 with both beach lines along both axes.
+// Lattices have four co-circular sites at every vertex and rows of sites level with the
+// first, each has (n - 1)^2 square cells split into two triangles.
+bool CheckLattices(std::ostream& os);
+
+// Evaluates random breakpoints and parabolas, including level sites and sites on the
+// sweep line, at every SIMD level the CPU has and compares each result bit for bit
+// with the scalar level.
+bool CheckSimdLevels(std::ostream& os);
+
+// Builds the power diagram of four weighted sites on a line and of random weighted sites,
+// and checks that random points lie in the cell of the site of least power.
+bool CheckPowerDiagrams(std::ostream& os);
+
+// Compares the integer InCircle with the double one on random integer sites up to 2^29
+// and tests four integer sites on one circle there.
+bool CheckIntegerPredicates(std::ostream& os);
+
+// Folds duplicate integer sites at 2^53, drops one beyond it, counts the co-circular groups of a lattice
+// and folds clustered sites with a tolerance on several threads, checking every fold.
+bool CheckSitePrepass(std::ostream& os);
+
+// Reorders a finished diagram and checks its links, the addresses of its records and the
+// area of every cell.
+bool CheckReorderForLocality(std::ostream& os);
+
+// Sweeps random sites and reports how often the containers grew, which the reserve should
+// make never, then shrinks them and checks that inserting sites is counted.
+bool CheckReallocations(std::ostream& os);
+
+// Runs the bidirectional sweep over random sites and a lattice and checks that it merges
+// the halves into the cells of the whole sweep.
+bool CheckBidirectionalSweep(std::ostream& os);
+
+// Relaxes random sites and checks that the moves shrink and that the diagram left is that
+// of a sweep over the moved sites, then moves them again and again under one reset sweep
+// and checks that the records it holds stay level.
+bool CheckRelaxation(std::ostream& os);
+
+// Locates random points in and around random sites, one at a time and in a batch, and
+// checks that each lands in the cell of a nearest site found by looking at them all.
+bool CheckCellLocator(std::ostream& os);
+
+// Finds the nearest site of random points and of points along a path, walking from the
+// first site, from the previous answer and in a batch, and checks each against a scan
+// of every site.
+bool CheckNearestSite(std::ostream& os);
+
+// Compares the k nearest sites of random points with a sorted scan of every site, then
+// checks the rows of the k nearest neighbour graph against scans and against each other.
+bool CheckKNearest(std::ostream& os);
+
+// Builds the neighbour graph of random sites and of a lattice on several threads and on
+// one, and checks that the rows agree, are the Delaunay edges and are symmetric in both
+// neighbours and edge lengths.
+bool CheckNeighbourGraph(std::ostream& os);
+
+// Extracts the cells of random sites on several threads and on one, and checks the
+// buffers agree, run counterclockwise and measure what a sweep along the other axis does.
+bool CheckCellExtraction(std::ostream& os);
+
+// Measures the cells of random sites on several threads and on one, and checks the
+// measures agree with each other, with a sweep along the other axis and, for degrees, with
+// the neighbour graph.
+bool CheckCellMetrics(std::ostream& os);
+
+// Inserts and removes random sites inside and around a finished diagram, and checks its
+// links, the inputs each site stands for and the Delaunay neighbours of a rebuild.
+bool CheckIncrementalDiagram(std::ostream& os);
+
+// Moves random sites a little at a time, and after every step checks the links, the
+// positions and the Delaunay neighbours of a rebuild, and that the steps were followed
+// by flips rather than by sweeping again.
+bool CheckKineticDiagram(std::ostream& os);
+
+// Runs every check, returns whether all passed
+bool RunSelfChecks(std::ostream& os);
@@ -0,0 +1,457 @@
+#include "SitePrepass.h"
+
+#include "Predicates.h"
+
+#include "../utils/CellHash.h"
+#include "../utils/Parallel.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	////////////////////////////////////////////////////////////////////
+	// Equal values give equal keys, -0 and 0 included. Integer sites are keyed on their
+	// value, which a double cannot hold beyond 2^53.
+	template<typename T, typename Real>
+	int64_t ExactKey(Real value)
+	{
+		if constexpr (std::is_integral<T>::value)
+			return int64_t(value);
+
+		double d = double(value);
+		if (0.0 == d) d = 0.0;
+		int64_t key;
+		std::memcpy(&key, &d, sizeof(key));
+		return key;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	template<typename Real>
+	int64_t CellOf(Real value, Real tolerance)
+	{
+		const double cell = std::floor(double(value / tolerance));
+		return int64_t(std::max(std::min(cell, 4.0e18), -4.0e18));
+	}
+
+	////////////////////////////////////////////////////////////////////
+	// Columns of cells are grouped in stripes two cells wide. Stripes of one parity are
+	// more than the tolerance apart, so their sites can be folded at the same time.
+	int64_t StripeOf(int64_t cellX)
+	{
+		return (cellX >= 0) ? cellX / 2 : (cellX - 1) / 2;
+	}
+
+	////////////////////////////////////////////////////////////////////
+	size_t Root(std::vector<size_t>& parent, size_t i)
+	{
+		while (parent[i] != i)
+			i = parent[i] = parent[parent[i]];
+		return i;
+	}
+
+	// The sites each site is tested with for co-circular groups, and the most sites of
+	// the grid around it weighed to find them
+	const size_t CircleNeighbours = 12;
+	const size_t CircleCandidates = 64;
+
+	////////////////////////////////////////////////////////////////////
+	// Lays a grid of about four sites per cell over the sites and takes the nearest of
+	// each site's grid neighbours. The corners of the site's Voronoi cell among them are
+	// the centres of the empty circles through it and two of them, and a third one on
+	// such a circle is found as the four sites in order. Quadruples on one circle share
+	// three sites, so those sharing three are joined into one group.
+	template<typename T>
+	void FindCoCircularGroups(const std::vector<BasicVoronoiSite<T>*>& sites, unsigned threads, SitePrepassReport& report)
+	{
+		typedef typename CoordinateTraits<T>::Real Real;
+		typedef BasicPoint<Real> Point;
+		typedef std::array<size_t, 4> Quadruple;
+		const size_t none = size_t(-1);
+
+		const size_t m = sites.size();
+		report.CoCircularGroups = 0;
+		report.Clustered.assign(m, 0);
+		if (m < 4)
+			return;
+
+		Real minX = sites[0]->point.x, minY = sites[0]->point.y;
+		Real maxX = minX, maxY = minY;
+		for (const BasicVoronoiSite<T>* site : sites)
+		{
+			minX = std::min(minX, site->point.x);
+			minY = std::min(minY, site->point.y);
+			maxX = std::max(maxX, site->point.x);
+			maxY = std::max(maxY, site->point.y);
+		}
+		// Sites on one horizontal or vertical line are never co-circular
+		const double width = double(maxX - minX), height = double(maxY - minY);
+		if (!(width > 0) || !(height > 0))
+			return;
+
+		double size = std::sqrt(4.0 * width * height / double(m));
+		size_t columns = 0, rows = 0;
+		do
+		{
+			columns = size_t(width / size) + 1;
+			rows = size_t(height / size) + 1;
+			size *= 2;
+		} while (columns > 4 * m || rows > 4 * m || columns * rows > 4 * m);
+		size /= 2;
+
+		auto columnOf = [&](const Point& p) { return std::min(columns - 1, size_t(double(p.x - minX) / size)); };
+		auto rowOf = [&](const Point& p) { return std::min(rows - 1, size_t(double(p.y - minY) / size)); };
+
+		std::vector<size_t> cellStart(columns * rows + 1, 0);
+		for (const BasicVoronoiSite<T>* site : sites)
+			cellStart[rowOf(site->point) * columns + columnOf(site->point) + 1]++;
+		for (size_t c = 0; c < columns * rows; c++)
+			cellStart[c + 1] += cellStart[c];
+		std::vector<size_t> cellSites(m);
+		std::vector<size_t> next(cellStart.begin(), cellStart.end() - 1);
+		for (size_t i = 0; i < m; i++)
+			cellSites[next[rowOf(sites[i]->point) * columns + columnOf(sites[i]->point)]++] = i;
+		// The points in grid order, which the search reads one cell after another
+		std::vector<Point> points;
+		points.reserve(m);
+		for (size_t k = 0; k < m; k++)
+			points.push_back(sites[cellSites[k]]->point);
+
+		if (0 == threads)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		if (m < ParallelThreshold)
+			threads = 1;
+		const size_t chunk = (m + threads - 1) / threads;
+		std::vector<std::vector<Quadruple>> found(threads);
+		ParallelFor(threads, threads, 0, [&](size_t first, size_t last)
+		{
+			std::vector<std::pair<Real, size_t>> candidates;
+			std::vector<size_t> near;
+			std::vector<Point> cell, cut;
+			std::vector<size_t> sides, cutSides;
+			for (size_t t = first; t < last; t++)
+			{
+				// Sites are taken in grid order, i is a position in points
+				for (size_t i = t * chunk; i < std::min(m, (t + 1) * chunk); i++)
+				{
+					const Point& p = points[i];
+					const size_t column = columnOf(p), row = rowOf(p);
+
+					candidates.clear();
+					for (size_t y = (row > 0 ? row - 1 : 0); y <= std::min(rows - 1, row + 1); y++)
+					{
+						for (size_t x = (column > 0 ? column - 1 : 0); x <= std::min(columns - 1, column + 1); x++)
+						{
+							const size_t bucket = y * columns + x;
+							for (size_t k = cellStart[bucket]; k < cellStart[bucket + 1] && candidates.size() < CircleCandidates; k++)
+							{
+								const Real dx = points[k].x - p.x, dy = points[k].y - p.y;
+								if (k != i)
+									candidates.push_back({ dx * dx + dy * dy, k });
+							}
+						}
+					}
+					const size_t count = std::min(CircleNeighbours, candidates.size());
+					if (count < candidates.size())
+						std::nth_element(candidates.begin(), candidates.begin() + count, candidates.end());
+					std::sort(candidates.begin(), candidates.begin() + count);
+					near.clear();
+					for (size_t k = 0; k < count; k++)
+						near.push_back(candidates[k].second);
+
+					// The site's cell among its neighbours, cut from a box by their bisectors.
+					// Each edge keeps the neighbour whose bisector it lies on, none for the box.
+					Real reach = 0;
+					for (size_t q : near)
+						reach = std::max(reach, std::abs(points[q].x - p.x) + std::abs(points[q].y - p.y));
+					reach *= Real(4);
+					cell = { Point(p.x - reach, p.y - reach), Point(p.x + reach, p.y - reach), Point(p.x + reach, p.y + reach), Point(p.x - reach, p.y + reach) };
+					sides.assign(4, none);
+					for (size_t q : near)
+					{
+						const Real dx = points[q].x - p.x, dy = points[q].y - p.y;
+						const Real mx = p.x + dx / Real(2), my = p.y + dy / Real(2);
+						auto beyond = [&](const Point& v) { return (v.x - mx) * dx + (v.y - my) * dy; };
+
+						cut.clear();
+						cutSides.clear();
+						for (size_t j = 0; j < cell.size(); j++)
+						{
+							const Point& from = cell[j];
+							const Point& to = cell[(j + 1) % cell.size()];
+							const Real f = beyond(from), g = beyond(to);
+							if (f <= 0)
+							{
+								cut.push_back(from);
+								cutSides.push_back(sides[j]);
+							}
+							if ((f <= 0) != (g <= 0))
+							{
+								const Real along = f / (f - g);
+								cut.push_back(Point(from.x + along * (to.x - from.x), from.y + along * (to.y - from.y)));
+								cutSides.push_back(f <= 0 ? q : sides[j]);
+							}
+						}
+						cell.swap(cut);
+						sides.swap(cutSides);
+					}
+
+					// A corner between the bisectors of a and b is the centre of a circle
+					// through the site, a and b holding no neighbour. Neighbours too near
+					// that circle to tell go to the exact test, those on it make a group.
+					for (size_t j = 0; j < cell.size(); j++)
+					{
+						const size_t a = sides[(j + cell.size() - 1) % cell.size()], b = sides[j];
+						if (none == a || none == b || a == b)
+							continue;
+						const Point& pa = points[a];
+						const Point& pb = points[b];
+						const Point& v = cell[j];
+						for (size_t q : near)
+						{
+							if (q == a || q == b)
+								continue;
+							const Point& pq = points[q];
+							const Real dx = pq.x - p.x, dy = pq.y - p.y;
+							const Real vx = v.x - p.x, vy = v.y - p.y;
+							const Real power = (vx - dx / Real(2)) * dx + (vy - dy / Real(2)) * dy;
+							if (std::abs(power) > Real(1e-6) * (vx * vx + vy * vy + dx * dx + dy * dy))
+								continue;
+							if (0 == SitePredicates<T>::Orientation(p, pa, pb) || 0 != SitePredicates<T>::InCircle(p, pa, pb, pq))
+								continue;
+
+							Quadruple quadruple = { cellSites[i], cellSites[a], cellSites[b], cellSites[q] };
+							std::sort(quadruple.begin(), quadruple.end());
+							found[t].push_back(quadruple);
+						}
+					}
+				}
+			}
+		});
+
+		std::vector<Quadruple> quadruples;
+		for (const std::vector<Quadruple>& some : found)
+			quadruples.insert(quadruples.end(), some.begin(), some.end());
+		std::sort(quadruples.begin(), quadruples.end());
+		quadruples.erase(std::unique(quadruples.begin(), quadruples.end()), quadruples.end());
+
+		// Each quadruple's four triples, sorted so that equal triples are adjacent
+		std::vector<std::pair<std::array<size_t, 3>, size_t>> triples;
+		triples.reserve(4 * quadruples.size());
+		for (size_t q = 0; q < quadruples.size(); q++)
+		{
+			const Quadruple& s = quadruples[q];
+			triples.push_back({ { s[1], s[2], s[3] }, q });
+			triples.push_back({ { s[0], s[2], s[3] }, q });
+			triples.push_back({ { s[0], s[1], s[3] }, q });
+			triples.push_back({ { s[0], s[1], s[2] }, q });
+		}
+		std::sort(triples.begin(), triples.end());
+
+		std::vector<size_t> parent(quadruples.size());
+		for (size_t q = 0; q < parent.size(); q++)
+			parent[q] = q;
+		for (size_t k = 0; k + 1 < triples.size(); k++)
+		{
+			if (triples[k].first == triples[k + 1].first)
+				parent[Root(parent, triples[k].second)] = Root(parent, triples[k + 1].second);
+		}
+
+		for (size_t q = 0; q < quadruples.size(); q++)
+		{
+			report.CoCircularGroups += (Root(parent, q) == q) ? 1 : 0;
+			for (size_t i : quadruples[q])
+				report.Clustered[i] = 1;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////
+// Each thread owns the cells of the keys or stripes hashing to it, and folds their sites
+// in input order into its own maps. With a tolerance the even stripes are folded first,
+// seeing only their own sites, then the odd stripes against everything kept so far, which
+// the even stripes no longer change.
+template<typename T>
+SitePrepassReport PrepareSites(BasicVoronoiDiagram<T>& diagram, typename CoordinateTraits<T>::Real tolerance, unsigned threads)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef std::unordered_map<CellKey, std::vector<VoronoiSite*>, CellKeyHash> CellMap;
+
+	SitePrepassReport report = { 0, 0, 0, SweepAxis::Y };
+	std::vector<VoronoiSite*>& sites = diagram.Sites;
+	const size_t n = sites.size();
+	if (0 == n)
+		return report;
+
+	const bool exact = !(tolerance > Real(0));
+	if (0 == threads)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	const unsigned owners = (n < ParallelThreshold) ? 1u : threads;
+
+	auto ownerOf = [owners](int64_t stripe) { return unsigned(std::hash<uint64_t>()(uint64_t(stripe)) % owners); };
+
+	// Cell keys are independent per site, so they are hashed in parallel
+	std::vector<CellKey> keys(n);
+	std::vector<unsigned> owner(n);
+	std::vector<char> odd(n, 0);
+	auto hashRange = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const BasicPoint<Real>& p = sites[i]->point;
+			if (exact)
+			{
+				keys[i] = CellKey{ ExactKey<T>(p.x), ExactKey<T>(p.y) };
+				owner[i] = unsigned(CellKeyHash()(keys[i]) % owners);
+			}
+			else
+			{
+				keys[i] = CellKey{ CellOf(p.x, tolerance), CellOf(p.y, tolerance) };
+				const int64_t stripe = StripeOf(keys[i].x);
+				odd[i] = char(stripe & 1);
+				owner[i] = ownerOf(stripe);
+			}
+		}
+	};
+	ParallelFor(n, threads, ParallelThreshold, hashRange);
+
+	// Maps 2 * owner hold the even stripes, or every key without a tolerance, and
+	// 2 * owner + 1 the odd stripes. The sites are laid out map by map once, in input
+	// order within each.
+	std::vector<size_t> start(2 * owners + 1, 0);
+	for (size_t i = 0; i < n; i++)
+		start[2 * owner[i] + odd[i] + 1]++;
+	for (size_t k = 0; k < 2 * owners; k++)
+		start[k + 1] += start[k];
+	std::vector<size_t> order(n);
+	std::vector<size_t> next(start.begin(), start.end() - 1);
+	for (size_t i = 0; i < n; i++)
+		order[next[2 * owner[i] + odd[i]]++] = i;
+
+	std::vector<CellMap> cells(2 * owners);
+	std::vector<VoronoiSite*> found(n, nullptr);
+	auto fold = [&](unsigned self, char parity)
+	{
+		CellMap& own = cells[2 * self + parity];
+		for (size_t k = start[2 * self + parity]; k < start[2 * self + parity + 1]; k++)
+		{
+			const size_t i = order[k];
+			VoronoiSite* site = sites[i];
+
+			if (exact)
+			{
+				auto it = own.find(keys[i]);
+				if (it != own.end())
+					found[i] = it->second.front();
+			}
+			else
+			{
+				// A site within the tolerance lies in this cell or one of its neighbours
+				for (int64_t dx = -1; dx <= 1 && !found[i]; dx++)
+				{
+					const CellKey key = { keys[i].x + dx, keys[i].y };
+					const int64_t stripe = StripeOf(key.x);
+					if (0 == parity && 0 != (stripe & 1))
+						continue;
+					const CellMap& map = cells[2 * ownerOf(stripe) + (stripe & 1)];
+					for (int64_t dy = -1; dy <= 1 && !found[i]; dy++)
+					{
+						auto it = map.find(CellKey{ key.x, key.y + dy });
+						if (it == map.end())
+							continue;
+						for (VoronoiSite* other : it->second)
+						{
+							const Real changeX = other->point.x - site->point.x;
+							const Real changeY = other->point.y - site->point.y;
+							if (changeX * changeX + changeY * changeY <= tolerance * tolerance)
+							{
+								found[i] = other;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			if (nullptr == found[i])
+				own[keys[i]].push_back(site);
+		}
+	};
+	for (char parity = 0; parity < (exact ? 1 : 2); parity++)
+	{
+		ParallelFor(owners, owners, 1, [&](size_t begin, size_t end)
+		{
+			for (size_t self = begin; self < end; self++)
+				fold(unsigned(self), parity);
+		});
+	}
+
+	// Representatives take the larger weight and the folded sites are deleted
+	std::vector<int> representative(n + 1, 0);
+	std::vector<VoronoiSite*> kept;
+	kept.reserve(n);
+	for (size_t i = 0; i < n; i++)
+	{
+		VoronoiSite* site = sites[i];
+		if (found[i])
+		{
+			representative[site->index] = found[i]->index;
+			found[i]->weight = std::max(found[i]->weight, site->weight);
+			report.Duplicates++;
+			delete site;
+		}
+		else
+		{
+			representative[site->index] = site->index;
+			kept.push_back(site);
+		}
+	}
+
+	// Renumber the survivors and carry the input mappings over
+	std::vector<int> newIndex(n + 1, 0);
+	std::vector<int> inputOrder(kept.size());
+	for (size_t i = 0; i < kept.size(); i++)
+	{
+		inputOrder[i] = diagram.InputOrder[kept[i]->index - 1];
+		newIndex[kept[i]->index] = int(i) + 1;
+	}
+	for (int& site : diagram.SiteOfInput)
+		site = newIndex[representative[site]];
+	for (size_t i = 0; i < kept.size(); i++)
+		kept[i]->index = int(i) + 1;
+	diagram.InputOrder.swap(inputOrder);
+	sites.swap(kept);
+
+	// A Y sweep starts from the top row, an X sweep from the leftmost column
+	Real top = sites[0]->point.y, left = sites[0]->point.x;
+	for (VoronoiSite* site : sites)
+	{
+		top = std::max(top, site->point.y);
+		left = std::min(left, site->point.x);
+	}
+	size_t topRow = 0, leftColumn = 0;
+	for (VoronoiSite* site : sites)
+	{
+		topRow += (site->point.y == top) ? 1 : 0;
+		leftColumn += (site->point.x == left) ? 1 : 0;
+	}
+	report.Axis = (topRow > 1 && leftColumn < topRow) ? SweepAxis::X : SweepAxis::Y;
+	report.FirstRowSites = (SweepAxis::X == report.Axis) ? leftColumn : topRow;
+
+	FindCoCircularGroups<T>(sites, threads, report);
+
+	return report;
+}
+
+template SitePrepassReport PrepareSites(BasicVoronoiDiagram<float>&, double, unsigned);
+template SitePrepassReport PrepareSites(BasicVoronoiDiagram<double>&, double, unsigned);
+template SitePrepassReport PrepareSites(BasicVoronoiDiagram<int64_t>&, long double, unsigned);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "SweepDirection.h"
+
+#include "../types/VoronoiDiagram.h"
+
+#include <cstddef>
+#include <vector>
+
+// What PrepareSites found in the input
+struct SitePrepassReport
+{
+	// Sites folded into a representative and removed from the diagram
+	size_t Duplicates;
+	// Sites level with the first site along Axis, the sweep starts them as a row
+	size_t FirstRowSites;
+	// Circles through four or more sites holding none of the sites near them, each of
+	// which gives the sweep a vertex where more than three cells meet. They are looked
+	// for among the nearest sites of every site, so a circle whose sites are far apart
+	// for their neighbourhood can be missed, the sweep confirms every vertex it merges
+	// with an exact test.
+	size_t CoCircularGroups;
+	// The axis along which fewer sites tie for first, Y when they tie as often
+	SweepAxis Axis;
+	// Per kept site, by index - 1, whether it is on the circle of a co-circular group
+	std::vector<char> Clustered;
+};
+
+// Parameters
+//		diagram   : a diagram that has not been swept yet
+//		tolerance : sites this close or closer are one site, 0 folds exact duplicates only
+//		threads   : threads to hash the sites on, 0 uses every hardware thread
+// Hashes the sites into cells the size of the tolerance and folds every site lying within
+// the tolerance of one kept before it into that site, which becomes its representative
+// and takes the larger of their weights. Exact duplicates fold into the first of them in
+// input order. The hashing, the folding and the search for co-circular groups run on
+// the threads.
+// The removed sites are deleted, the rest renumbered from 1, and SiteOfInput maps every
+// input point to the site standing for it.
+template<typename T>
+SitePrepassReport PrepareSites(BasicVoronoiDiagram<T>& diagram, typename CoordinateTraits<T>::Real tolerance = 0, unsigned threads = 0);
@@ -0,0 +1,92 @@
+#include "SweepDirection.h"
+
+#include <algorithm>
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+double EstimateBeachLineSize(const std::vector<BasicVoronoiSite<T>*>& sites, SweepAxis axis, size_t samples)
+{
+	if (sites.empty() || 0 == samples)
+		return 0.0;
+
+	std::vector<Point> sample;
+	const size_t stride = std::max<size_t>(1, sites.size() / samples);
+	for (size_t i = 0; i < sites.size(); i += stride)
+	{
+		sample.push_back(Point(double(sites[i]->point.x), double(sites[i]->point.y)));
+	}
+
+	double minX = sample[0].x, maxX = sample[0].x, minY = sample[0].y, maxY = sample[0].y;
+	for (const Point& p : sample)
+	{
+		minX = std::min(minX, p.x);
+		maxX = std::max(maxX, p.x);
+		minY = std::min(minY, p.y);
+		maxY = std::max(maxY, p.y);
+	}
+
+	const double width = maxX - minX;
+	const double height = maxY - minY;
+
+	// Every site sits on a single line, which is worst case along that line and trivial across it
+	if (0.0 == width || 0.0 == height)
+	{
+		const bool alongLine = (SweepAxis::Y == axis) ? (0.0 == height) : (0.0 == width);
+		return alongLine ? double(sample.size()) : 1.0;
+	}
+
+	// Square cells so that on average every cell holds one sampled site
+	const double cellSize = std::sqrt(width * height / double(sample.size()));
+	const size_t columns = std::min(sample.size(), size_t(width / cellSize) + 1);
+	const size_t rows = std::min(sample.size(), size_t(height / cellSize) + 1);
+
+	std::vector<bool> occupied(columns * rows, false);
+	for (const Point& p : sample)
+	{
+		size_t column = std::min(columns - 1, size_t((p.x - minX) / width * double(columns)));
+		size_t row = std::min(rows - 1, size_t((p.y - minY) / height * double(rows)));
+		occupied[row * columns + column] = true;
+	}
+
+	// The sweep line runs along rows for a Y sweep and along columns for an X sweep
+	const size_t lines = (SweepAxis::Y == axis) ? rows : columns;
+	const size_t cellsPerLine = (SweepAxis::Y == axis) ? columns : rows;
+
+	size_t occupiedLines = 0, occupiedCells = 0;
+	for (size_t line = 0; line < lines; line++)
+	{
+		size_t count = 0;
+		for (size_t cell = 0; cell < cellsPerLine; cell++)
+		{
+			size_t index = (SweepAxis::Y == axis) ? line * columns + cell : cell * columns + line;
+			if (occupied[index])
+				count++;
+		}
+
+		if (count > 0)
+		{
+			occupiedLines++;
+			occupiedCells += count;
+		}
+	}
+
+	return double(occupiedCells) / double(occupiedLines);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+SweepAxis ChooseSweepAxis(const std::vector<BasicVoronoiSite<T>*>& sites, size_t samples)
+{
+	if (EstimateBeachLineSize(sites, SweepAxis::X, samples) < EstimateBeachLineSize(sites, SweepAxis::Y, samples))
+		return SweepAxis::X;
+	return SweepAxis::Y;
+}
+
+template double EstimateBeachLineSize(const std::vector<BasicVoronoiSite<float>*>&, SweepAxis, size_t);
+template double EstimateBeachLineSize(const std::vector<BasicVoronoiSite<double>*>&, SweepAxis, size_t);
+template double EstimateBeachLineSize(const std::vector<BasicVoronoiSite<int64_t>*>&, SweepAxis, size_t);
+
+template SweepAxis ChooseSweepAxis(const std::vector<BasicVoronoiSite<float>*>&, size_t);
+template SweepAxis ChooseSweepAxis(const std::vector<BasicVoronoiSite<double>*>&, size_t);
+template SweepAxis ChooseSweepAxis(const std::vector<BasicVoronoiSite<int64_t>*>&, size_t);
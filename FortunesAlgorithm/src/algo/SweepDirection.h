@@ -0,0 +1,28 @@
+#pragma once
+
+#include "../types/VoronoiDiagram.h"
+
+#include <vector>
+
+// The axis the sweep line moves along. Y is the classic top-down sweep, X sweeps
+// across the plane instead, and Auto picks whichever should keep the beach line shorter.
+enum class SweepAxis
+{
+	Y,
+	X,
+	Auto
+};
+
+// Parameters
+//		sites   : the input sites
+//		axis    : SweepAxis::X or SweepAxis::Y
+//		samples : how many sites to look at, spread evenly through the input
+// Bins the sampled sites into square cells and returns the average number of occupied
+// cells along the sweep line, which grows with the number of arcs on the beach line.
+// Wide or banded inputs occupy many cells along one axis and few along the other.
+template<typename T>
+double EstimateBeachLineSize(const std::vector<BasicVoronoiSite<T>*>& sites, SweepAxis axis, size_t samples = 4096);
+
+// Returns the axis with the smaller estimated beach line, favouring Y on ties.
+template<typename T>
+SweepAxis ChooseSweepAxis(const std::vector<BasicVoronoiSite<T>*>& sites, size_t samples = 4096);
@@ -0,0 +1,26 @@
+#include "BeachLine.h"
+
+#include "VoronoiDiagram.h"
+
+using namespace BL;
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void BasicBeachLine<T>::Print(std::ostream& stream) const
+{
+	if (IsEmpty())
+		return;
+
+	for (ArcRef arc = First(); NullArc != arc; arc = RightArc(arc))
+	{
+		stream << "P" << Site(arc)->index << " ";
+
+		Edge edge = RightBreakpoint(arc);
+		if (!edge.IsNull())
+			stream << "<" << edge.Left()->index << ", " << edge.Right()->index << "> ";
+	}
+}
+
+template class BL::BasicBeachLine<float>;
+template class BL::BasicBeachLine<double>;
+template class BL::BasicBeachLine<int64_t>;
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Bisector.h"
+
+#include <cstdint>
+#include <iostream>
+
+template<typename T> struct BasicVoronoiSite;
+template<typename T> class BasicEventPoint;
+
+namespace BL
+{
+	// Arcs are referred to by handles that stay valid until the arc leaves the beach line
+	typedef uint32_t ArcRef;
+	const ArcRef NullArc = 0x7FFFFFFF;
+
+	enum class BeachLineType
+	{
+		RedBlack,
+		BTree
+	};
+
+	// The beach line as a sequence of arcs with a breakpoint between each pair of
+	// neighbouring arcs. The sweep only works through this interface so the
+	// containers behind it can be swapped and compared against each other.
+	template<typename T>
+	class BasicBeachLine
+	{
+	public:
+		typedef typename CoordinateTraits<T>::Real Real;
+		typedef BasicVoronoiSite<T> VoronoiSite;
+		typedef BasicEventPoint<T> EventPoint;
+		typedef BasicEdge<T> Edge;
+
+		virtual ~BasicBeachLine() {}
+
+		virtual bool IsEmpty() const = 0;
+		virtual void Clear() = 0;
+
+		// Places the only arc on an empty beach line
+		virtual ArcRef Start(VoronoiSite* site) = 0;
+
+		// Parameters
+		//		x  : the x coordinate below the beach line
+		//		lh : the line height of the sweep line
+		virtual ArcRef FindArcAtX(Real x, Real lh) const = 0;
+
+		// Replaces the arc with two arcs meeting at the edge
+		virtual void SplitArc(ArcRef arc, VoronoiSite* left, VoronoiSite* right, const Edge& edge,
+			ArcRef& leftArc, ArcRef& rightArc) = 0;
+		// Replaces the arc with an arc for the site between two copies of itself
+		virtual void InsertArc(ArcRef arc, VoronoiSite* site, const Edge& leftEdge, const Edge& rightEdge,
+			ArcRef& leftArc, ArcRef& middleArc, ArcRef& rightArc) = 0;
+		// Removes the arc, the breakpoints either side of it are replaced by the edge
+		virtual void RemoveArc(ArcRef arc, const Edge& edge) = 0;
+
+		// Neighbours are NullArc or a null Edge at either end of the beach line
+		virtual ArcRef First() const = 0;
+		virtual ArcRef LeftArc(ArcRef arc) const = 0;
+		virtual ArcRef RightArc(ArcRef arc) const = 0;
+		virtual Edge LeftBreakpoint(ArcRef arc) const = 0;
+		virtual Edge RightBreakpoint(ArcRef arc) const = 0;
+
+		virtual VoronoiSite* Site(ArcRef arc) const = 0;
+		virtual EventPoint* CircleEvent(ArcRef arc) const = 0;
+		virtual void SetCircleEvent(ArcRef arc, EventPoint* event) = 0;
+
+		// Writes the arcs and breakpoints from left to right
+		void Print(std::ostream& stream) const;
+	};
+
+	typedef BasicBeachLine<double> BeachLine;
+}
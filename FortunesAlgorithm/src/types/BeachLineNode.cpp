@@ -0,0 +1,103 @@
+#include "BeachLineNode.h"
+
+using namespace BL;
+
+////////////////////////////////////////////////////////////////////
+// New arcs start black, the leaves act as the black nil nodes of the tree
+template<typename T>
+NodeRef NodePool<T>::NewLeaf(BasicVoronoiSite<T>* site)
+{
+	LeafNode<T> leaf = { NullNode | BlackBit, site, nullptr };
+	if (!FreeLeaves.empty())
+	{
+		uint32_t index = FreeLeaves.back();
+		FreeLeaves.pop_back();
+		Leaves[index] = leaf;
+		return index | LeafBit;
+	}
+
+	Leaves.push_back(leaf);
+	return uint32_t(Leaves.size() - 1) | LeafBit;
+}
+
+////////////////////////////////////////////////////////////////////
+// New breakpoints start red, they are always inserted below an existing node
+template<typename T>
+NodeRef NodePool<T>::NewInternal(const BasicEdge<T>& edge)
+{
+	InternalNode<T> node = { NullNode, NullNode, NullNode, edge.Reversed ? 1u : 0u, edge.Source };
+	if (!FreeInternals.empty())
+	{
+		uint32_t index = FreeInternals.back();
+		FreeInternals.pop_back();
+		Internals[index] = node;
+		return index;
+	}
+
+	Internals.push_back(node);
+	return uint32_t(Internals.size() - 1);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::Free(NodeRef node)
+{
+	if (NullNode == node)
+		return;
+
+	if (IsLeaf(node))
+		FreeLeaves.push_back(node & ~LeafBit);
+	else
+		FreeInternals.push_back(node);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::Clear()
+{
+	Leaves.clear();
+	Internals.clear();
+	FreeLeaves.clear();
+	FreeInternals.clear();
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::SetLeft(NodeRef parent, NodeRef child)
+{
+	Internals[parent].Left = child;
+	if (NullNode != child)
+		SetParent(child, parent);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::SetRight(NodeRef parent, NodeRef child)
+{
+	Internals[parent].Right = child;
+	if (NullNode != child)
+		SetParent(child, parent);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::SetParent(NodeRef node, NodeRef parent)
+{
+	uint32_t& link = ParentLink(node);
+	link = (link & BlackBit) | parent;
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+void NodePool<T>::SetColor(NodeRef node, TreeColor color)
+{
+	if (NullNode == node)
+		return;
+
+	uint32_t& link = ParentLink(node);
+	link = (TreeColor::Black == color) ? (link | BlackBit) : (link & ~BlackBit);
+}
+
+template class BL::NodePool<float>;
+template class BL::NodePool<double>;
+template class BL::NodePool<int64_t>;
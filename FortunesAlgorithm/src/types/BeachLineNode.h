@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Bisector.h"
+
+#include <cstdint>
+#include <vector>
+
+template<typename T> struct BasicVoronoiSite;
+template<typename T> class BasicEventPoint;
+
+namespace BL
+{
+	// Beach line nodes refer to each other by 32 bit handles into a NodePool. A handle
+	// with the top bit set is a leaf (an arc), otherwise it is an internal node (a breakpoint).
+	typedef uint32_t NodeRef;
+	const NodeRef NullNode = 0x7FFFFFFF;
+	const NodeRef LeafBit = 0x80000000;
+
+	enum TreeColor
+	{
+		Red,
+		Black
+	};
+
+	// Both node kinds keep their colour in the top bit of the parent link,
+	// the parent of any node is always an internal node so the bit is spare.
+	const uint32_t BlackBit = 0x80000000;
+
+	template<typename T>
+	struct LeafNode
+	{
+		uint32_t Parent;
+		BasicVoronoiSite<T>* Site;
+		BasicEventPoint<T>* CircleEvent;
+	};
+
+	template<typename T>
+	struct InternalNode
+	{
+		uint32_t Parent;
+		NodeRef Left;
+		NodeRef Right;
+
+		// The breakpoint's view of its bisector, stored unpacked so the flag
+		// sits in what would otherwise be padding
+		uint32_t Reversed;
+		BasicBisector<T>* Source;
+
+		BasicEdge<T> Edge() const { return BasicEdge<T>(Source, 0 != Reversed); }
+		void SetEdge(const BasicEdge<T>& edge) { Source = edge.Source; Reversed = edge.Reversed ? 1 : 0; }
+	};
+
+	template<typename T>
+	class NodePool
+	{
+	public:
+		NodeRef NewLeaf(BasicVoronoiSite<T>* site);
+		NodeRef NewInternal(const BasicEdge<T>& edge);
+		void Free(NodeRef node);
+		void Clear();
+
+		static bool IsLeaf(NodeRef node) { return NullNode != node && 0 != (node & LeafBit); }
+
+		LeafNode<T>& Leaf(NodeRef node) { return Leaves[node & ~LeafBit]; }
+		const LeafNode<T>& Leaf(NodeRef node) const { return Leaves[node & ~LeafBit]; }
+		InternalNode<T>& Internal(NodeRef node) { return Internals[node]; }
+		const InternalNode<T>& Internal(NodeRef node) const { return Internals[node]; }
+
+		// Leaves have no children, these return NullNode for them
+		NodeRef Left(NodeRef node) const { return (NullNode == node || IsLeaf(node)) ? NullNode : Internals[node].Left; }
+		NodeRef Right(NodeRef node) const { return (NullNode == node || IsLeaf(node)) ? NullNode : Internals[node].Right; }
+		void SetLeft(NodeRef parent, NodeRef child);
+		void SetRight(NodeRef parent, NodeRef child);
+
+		NodeRef Parent(NodeRef node) const { return ParentLink(node) & ~BlackBit; }
+		void SetParent(NodeRef node, NodeRef parent);
+
+		// The null node counts as black, like the nil leaves of a textbook red-black tree
+		TreeColor Color(NodeRef node) const { return (NullNode == node || 0 != (ParentLink(node) & BlackBit)) ? TreeColor::Black : TreeColor::Red; }
+		void SetColor(NodeRef node, TreeColor color);
+
+	private:
+		uint32_t ParentLink(NodeRef node) const { return IsLeaf(node) ? Leaves[node & ~LeafBit].Parent : Internals[node].Parent; }
+		uint32_t& ParentLink(NodeRef node) { return IsLeaf(node) ? Leaves[node & ~LeafBit].Parent : Internals[node].Parent; }
+
+		std::vector<LeafNode<T>> Leaves;
+		std::vector<InternalNode<T>> Internals;
+		std::vector<uint32_t> FreeLeaves;
+		std::vector<uint32_t> FreeInternals;
+	};
+}
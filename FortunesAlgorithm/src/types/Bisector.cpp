@@ -0,0 +1,98 @@
+#include "Bisector.h"
+
+#include "../algo/FortunesAlgorithm.h"
+#include "../algo/Predicates.h"
+
+using namespace BL;
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+BasicBisector<T>::BasicBisector(Point* start, VoronoiSite* left, VoronoiSite* right)
+	: Start(start)
+	, Ends{ nullptr, nullptr }
+	, Left(left)
+	, Right(right)
+	, HalfEdge(nullptr)
+	, TriHalfEdge(nullptr)
+	, Line({ 0,0 })
+	, IsVertical(false)
+{
+	if (left->point.y == right->point.y)
+		IsVertical = true;
+
+	// The slope is the same seen from either side, only the direction flips
+	Line.x = (right->point.x - left->point.x) / (left->point.y - right->point.y);
+	Line.y = (start->y - Line.x * start->x);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicEdge<T>::Point BasicEdge<T>::Direction() const
+{
+	const Point& left = Left()->point;
+	const Point& right = Right()->point;
+	return Point(right.y - left.y, left.x - right.x);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+DCEL::BasicHalfEdge<T>* BasicEdge<T>::HalfEdge() const
+{
+	DCEL::BasicHalfEdge<T>* halfEdge = Source->HalfEdge;
+	return (Reversed && nullptr != halfEdge) ? halfEdge->twin : halfEdge;
+}
+
+////////////////////////////////////////////////////////////////////
+// The twin must already be linked, the bisector only keeps the left side
+template<typename T>
+void BasicEdge<T>::SetHalfEdge(DCEL::BasicHalfEdge<T>* halfEdge)
+{
+	Source->HalfEdge = Reversed ? halfEdge->twin : halfEdge;
+}
+
+////////////////////////////////////////////////////////////////////
+// The sweep only crosses the breakpoints either side of an arc, which share the arc's
+// site, so they cross at the circumcentre of the three sites. The exact orientation of
+// the sites settles whether they are parallel, whether the breakpoints move towards the
+// crossing is left to the caller.
+template<typename T>
+typename BasicEdge<T>::Point* BasicEdge<T>::Intersect(const BasicEdge& edge) const
+{
+	const Point& a = Left()->point;
+	const Point& b = Right()->point;
+	const Point& c = edge.Right()->point;
+
+	// Test for parellel
+	const double orientation = SitePredicates<T>::Orientation(a, b, c);
+	if (0.0 == orientation) return nullptr;
+
+	// Relative to the shared site, which keeps the products small
+	const Real ax = a.x - b.x, ay = a.y - b.y;
+	const Real cx = c.x - b.x, cy = c.y - b.y;
+	const Real aa = ax * ax + ay * ay;
+	const Real cc = cx * cx + cy * cy;
+
+	// Twice the signed area of b, a, c, rounding must not flip it against the predicate
+	Real d = ax * cy - ay * cx;
+	if ((d < 0) != (orientation > 0.0) || 0 == d)
+		d = Real(-orientation);
+	d *= 2;
+
+	return new Point(b.x + (cy * aa - ay * cc) / d, b.y + (ax * cc - cx * aa) / d);
+}
+
+////////////////////////////////////////////////////////////////////
+template<typename T>
+typename BasicEdge<T>::Point BasicEdge<T>::RenderEdge(Real y) const
+{
+	Real x = IntersectionX(Left()->point, Right()->point, y);
+	return Point(x, CalculateParabolaY(x, y, Left()->point));
+}
+
+template class BL::BasicBisector<float>;
+template class BL::BasicBisector<double>;
+template class BL::BasicBisector<int64_t>;
+
+template class BL::BasicEdge<float>;
+template class BL::BasicEdge<double>;
+template class BL::BasicEdge<int64_t>;
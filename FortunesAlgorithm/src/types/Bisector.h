@@ -0,0 +1,76 @@
+#pragma once
+
+#include "DCELTypes.h"
+#include "Point.h"
+
+template<typename T> struct BasicVoronoiSite;
+
+// We combine the ideas of a perpindicular bisector and a halfedge to create an edge
+// These can be used to render the Voronoi Diagram as well
+namespace BL
+{
+	// One record per Voronoi edge. The two breakpoints that trace the edge out
+	// from its start point share it, each through its own oriented Edge view.
+	template<typename T>
+	class BasicBisector
+	{
+	public:
+		typedef BasicPoint<typename CoordinateTraits<T>::Real> Point;
+		typedef BasicVoronoiSite<T> VoronoiSite;
+
+		BasicBisector(Point* start, VoronoiSite* left, VoronoiSite* right);
+
+		Point* Start;
+		Point* Ends[2];
+		VoronoiSite* Left;
+		VoronoiSite* Right;
+
+		// The half edge bordering Left, the other side is its twin
+		DCEL::BasicHalfEdge<T>* HalfEdge;
+		// The Delaunay half edge waiting for its twin across this edge
+		DCEL::BasicHalfEdge<T>* TriHalfEdge;
+
+		Point Line;
+		bool IsVertical;
+	};
+
+	// A breakpoint's view of a bisector. The reversed view sees the sites swapped,
+	// runs in the opposite direction and owns the twin half edge.
+	template<typename T>
+	class BasicEdge
+	{
+	public:
+		typedef typename CoordinateTraits<T>::Real Real;
+		typedef BasicPoint<Real> Point;
+		typedef BasicVoronoiSite<T> VoronoiSite;
+		typedef BasicBisector<T> Bisector;
+
+		BasicEdge() : Source(nullptr), Reversed(false) {}
+		BasicEdge(Bisector* source, bool reversed) : Source(source), Reversed(reversed) {}
+
+		bool IsNull() const { return nullptr == Source; }
+
+		Point* Start() const { return Source->Start; }
+		Point*& End() const { return Source->Ends[Reversed]; }
+		VoronoiSite* Left() const { return Reversed ? Source->Right : Source->Left; }
+		VoronoiSite* Right() const { return Reversed ? Source->Left : Source->Right; }
+		const Point& Line() const { return Source->Line; }
+		bool IsVertical() const { return Source->IsVertical; }
+		Point Direction() const;
+
+		DCEL::BasicHalfEdge<T>* HalfEdge() const;
+		void SetHalfEdge(DCEL::BasicHalfEdge<T>* halfEdge);
+		DCEL::BasicHalfEdge<T>*& TriHalfEdge() const { return Source->TriHalfEdge; }
+
+		// The breakpoint to the right of this one across their shared arc, nullptr when
+		// the three sites are collinear
+		Point* Intersect(const BasicEdge& edge) const;
+		Point RenderEdge(Real y) const;
+
+		Bisector* Source;
+		bool Reversed;
+	};
+
+	typedef BasicBisector<double> Bisector;
+	typedef BasicEdge<double> Edge;
+}
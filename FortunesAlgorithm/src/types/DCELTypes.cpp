@@ -1,6 +1,7 @@
 #include "DCELTypes.h"
 
-std::ostream& operator<<(std::ostream& os, DCEL::HalfEdge& rhs)
+template<typename T>
+std::ostream& operator<<(std::ostream& os, DCEL::BasicHalfEdge<T>& rhs)
 {
 	char eOrD = (rhs.incidentFace != nullptr && rhs.incidentFace->index != 0) ? 'd' : 'e';
 	if (rhs.origin)
@@ -31,4 +32,8 @@ std::ostream& operator<<(std::ostream& os, DCEL::HalfEdge& rhs)
 		os << "UK";
 	}
 	return os;
-}
\ No newline at end of file
+}
+
+template std::ostream& operator<<(std::ostream&, DCEL::BasicHalfEdge<float>&);
+template std::ostream& operator<<(std::ostream&, DCEL::BasicHalfEdge<double>&);
+template std::ostream& operator<<(std::ostream&, DCEL::BasicHalfEdge<int64_t>&);
\ No newline at end of file
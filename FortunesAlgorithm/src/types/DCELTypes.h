@@ -1,39 +1,46 @@
 #pragma once
 #include "Point.h"
 #include <iostream>
-struct VoronoiSite;
+template<typename T> struct BasicVoronoiSite;
 
 namespace DCEL {
-	struct Vertex;
-	struct Face;
-	struct HalfEdge;
+	template<typename T> struct BasicVertex;
+	template<typename T> struct BasicFace;
+	template<typename T> struct BasicHalfEdge;
 
-	struct Vertex
+	template<typename T>
+	struct BasicVertex
 	{
 		int index;
-		Point point;
-		HalfEdge* incidentEdge;
+		BasicPoint<typename CoordinateTraits<T>::Real> point;
+		BasicHalfEdge<T>* incidentEdge;
 		bool box = false;
 	};
 
-	struct Face
+	template<typename T>
+	struct BasicFace
 	{
-		VoronoiSite* site;
-		HalfEdge* outerComponent;
-		HalfEdge* innerComponent;
+		BasicVoronoiSite<T>* site;
+		BasicHalfEdge<T>* outerComponent;
+		BasicHalfEdge<T>* innerComponent;
 		bool Unbounded = false;
 		int index;
 	};
 
-	struct HalfEdge {
-		Vertex* origin;
-		Vertex* dest;
-		HalfEdge* twin;
-		Face* incidentFace;
-		HalfEdge* next;
-		HalfEdge* prev;
+	template<typename T>
+	struct BasicHalfEdge {
+		BasicVertex<T>* origin;
+		BasicVertex<T>* dest;
+		BasicHalfEdge<T>* twin;
+		BasicFace<T>* incidentFace;
+		BasicHalfEdge<T>* next;
+		BasicHalfEdge<T>* prev;
 	};
 
+	typedef BasicVertex<double> Vertex;
+	typedef BasicFace<double> Face;
+	typedef BasicHalfEdge<double> HalfEdge;
 }
 
-std::ostream& operator<<(std::ostream& os, DCEL::HalfEdge& rhs);
\ No newline at end of file
+template<typename T>
+std::ostream& operator<<(std::ostream& os, DCEL::BasicHalfEdge<T>& rhs);
@@ -1,42 +1,61 @@
 #pragma once
+#include "BeachLine.h"
 #include "VoronoiDiagram.h"
 
-namespace BL
-{
-	class Arc;
-}
-
 enum EventPointType
 {
 	Site = 0,
 	Circle = 1
 };
 
-class EventPoint {
+template<typename T>
+class BasicEventPoint {
 public:
-	EventPoint(VoronoiSite* site) : Type(EventPointType::Site), Site(site), Arc(nullptr), Radius(0.0), Deleted(false)
+	typedef BasicVoronoiSite<T> VoronoiSite;
+
+	BasicEventPoint(VoronoiSite* site) : Type(EventPointType::Site), Site(site), Arc(BL::NullArc), Radius(0.0), Deleted(false)
 	{
 
 	}
 
-	EventPoint(VoronoiSite* site, EventPointType type) : Type(type), Site(site), Arc(nullptr), Radius(0.0), Deleted(false)
+	BasicEventPoint(VoronoiSite* site, EventPointType type) : Type(type), Site(site), Arc(BL::NullArc), Radius(0.0), Deleted(false)
 	{
 
 	}
 
 	EventPointType Type;
 	VoronoiSite* Site;
-	BL::Arc* Arc;
-	long double Radius;
+	BL::ArcRef Arc;
+	// Kept in the sweep's coordinate type, like the site point it is added to
+	typename CoordinateTraits<T>::Real Radius;
 
 	//CircleSite
 	bool Deleted;
 
 	// We are handling events left to right if equal prioritizing circle events
-	bool isGreater(const EventPoint& point)
+	bool isGreater(const BasicEventPoint& point)
 	{
 		return Site->point.y > point.Site->point.y 
 			|| (Site->point.y == point.Site->point.y && Type == EventPointType::Circle && point.Type == EventPointType::Site)
 			|| (Site->point.y == point.Site->point.y && Site->point.x <= point.Site->point.x);
 	}
 };
+
+typedef BasicEventPoint<double> EventPoint;
+
+// What one step of the sweep did, as yielded by FortunesAlgorithm::Steps
+struct SweepEvent
+{
+	EventPointType Type;
+	// The site for a site event, the new Voronoi vertex for a circle event
+	Point Location;
+	double SweepHeight;
+
+	int ArcsCreated;
+	int ArcsRemoved;
+
+	// Records appended to the diagram by this event
+	size_t VerticesAdded;
+	size_t HalfEdgesAdded;
+	size_t TrianglesAdded;
+};
@@ -1,16 +1,34 @@
 #include "Point.h";
 
-bool operator==(const Point& lhs, const Point& rhs)
+template<typename T>
+bool operator==(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs)
 {
 	return lhs.x == rhs.x && lhs.y == rhs.y;
 }
 
-bool operator!= (const Point& lhs, const Point& rhs)
+template<typename T>
+bool operator!= (const BasicPoint<T>& lhs, const BasicPoint<T>& rhs)
 {
 	return !(lhs == rhs);
 }
 
-std::ostream& operator<<(std::ostream& lhs, const Point& rhs)
+template<typename T>
+std::ostream& operator<<(std::ostream& lhs, const BasicPoint<T>& rhs)
 {
 	return lhs << "(" << rhs.x << ", " << rhs.y << ")";
 }
+
+template bool operator==(const BasicPoint<float>&, const BasicPoint<float>&);
+template bool operator==(const BasicPoint<double>&, const BasicPoint<double>&);
+template bool operator==(const BasicPoint<long double>&, const BasicPoint<long double>&);
+template bool operator==(const BasicPoint<int64_t>&, const BasicPoint<int64_t>&);
+
+template bool operator!=(const BasicPoint<float>&, const BasicPoint<float>&);
+template bool operator!=(const BasicPoint<double>&, const BasicPoint<double>&);
+template bool operator!=(const BasicPoint<long double>&, const BasicPoint<long double>&);
+template bool operator!=(const BasicPoint<int64_t>&, const BasicPoint<int64_t>&);
+
+template std::ostream& operator<<(std::ostream&, const BasicPoint<float>&);
+template std::ostream& operator<<(std::ostream&, const BasicPoint<double>&);
+template std::ostream& operator<<(std::ostream&, const BasicPoint<long double>&);
+template std::ostream& operator<<(std::ostream&, const BasicPoint<int64_t>&);
@@ -1,14 +1,66 @@
 #pragma once
+#include <cstdint>
 #include <iostream>
-struct Point {
+#include <limits>
+
+// A point with coordinates of type T. Diagrams can be built over float, double or
+// int64_t sites, Point is the double one used everywhere else.
+template<typename T>
+struct BasicPoint {
 public:
-	Point(double _x, double _y) : x(_x), y(_y) {}
-	double x;
-	double y;
+	BasicPoint(T _x, T _y) : x(_x), y(_y) {}
+	T x;
+	T y;
+};
+
+typedef BasicPoint<double> Point;
+
+// The type the sweep holds sites and computes breakpoints and Voronoi vertices in for
+// input coordinates of type T. Float sites become double, a float's 24 bits cannot
+// place vertices between nearby sites. Integer sites become long double so the
+// vertices between them keep any extra bits the compiler offers. Only coordinates within
+// 2^53 are held exactly where long double is a double (MSVC), all of int64_t where it
+// has a 64 bit mantissa.
+template<typename T>
+struct CoordinateTraits
+{
+	typedef T Real;
+
+	static bool Holds(const BasicPoint<T>&) { return true; }
+};
+
+template<>
+struct CoordinateTraits<float>
+{
+	typedef double Real;
+
+	static bool Holds(const BasicPoint<float>&) { return true; }
+};
+
+template<>
+struct CoordinateTraits<int64_t>
+{
+	typedef long double Real;
+
+	static_assert(std::numeric_limits<Real>::digits >= std::numeric_limits<double>::digits,
+		"integer sites must be held at least as exactly as in a double");
+
+	// The predicates take integer sites through doubles once they no longer fit an
+	// integer determinant, so coordinates must lie within 2^53 for their signs to stay
+	// exact. Inputs beyond it are not made into sites.
+	static constexpr int64_t Limit = int64_t(1) << 53;
+
+	static bool Holds(const BasicPoint<int64_t>& p)
+	{
+		return p.x >= -Limit && p.x <= Limit && p.y >= -Limit && p.y <= Limit;
+	}
 };
 
-bool operator==(const Point& lhs, const Point& rhs);
+template<typename T>
+bool operator==(const BasicPoint<T>& lhs, const BasicPoint<T>& rhs);
 
-bool operator!= (const Point& lhs, const Point& rhs);
+template<typename T>
+bool operator!= (const BasicPoint<T>& lhs, const BasicPoint<T>& rhs);
 
-std::ostream& operator<<(std::ostream& lhs, const Point& rhs);
+template<typename T>
+std::ostream& operator<<(std::ostream& lhs, const BasicPoint<T>& rhs);
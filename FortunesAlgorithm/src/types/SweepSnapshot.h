@@ -0,0 +1,33 @@
+#pragma once
+#include "Point.h"
+
+#include <utility>
+#include <vector>
+
+// A breakpoint of the beach line, traced by the bisector of the two arcs it separates
+struct SnapshotBreakpoint
+{
+	Point Left;
+	Point Right;
+	Point Start;
+	bool IsVertical;
+	// False while the edge has not been created yet, Start is then not meaningful
+	bool Traced;
+};
+
+// Self-contained copy of the sweep state. The viewer renders these while the
+// algorithm keeps running on its own thread, so nothing in here points back
+// into the beach line or the diagram.
+struct SweepSnapshot
+{
+	double SweepHeight = 0.0;
+	bool Complete = false;
+
+	// Foci of the beach line arcs from left to right, Breakpoints[i] sits between Arcs[i] and Arcs[i + 1]
+	std::vector<Point> Arcs;
+	std::vector<SnapshotBreakpoint> Breakpoints;
+
+	// Completed edges only ever grow, so a snapshot being reused just appends the new ones
+	std::vector<std::pair<Point, Point>> CompletedEdges;
+	std::vector<std::pair<Point, Point>> InfiniteEdges;
+};
@@ -4,39 +4,64 @@
 
 #include "DCELTypes.h"
 #include "Point.h"
+#include "../utils/HilbertCurve.h"
+#include "../utils/Parallel.h"
+#include "../utils/Shoelace.h"
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <limits>
 #include <sstream>
+#include <utility>
 
-std::ostream& operator<<(std::ostream& os, const VoronoiSite& site)
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const BasicVoronoiSite<T>& site)
 {
 	os << "P" << site.index << ": (" << site.point.x << ", " << site.point.y << ")";
 	return os;
 }
 
 
-VoronoiDiagram::VoronoiDiagram(std::vector<Point>& points)
+template<typename T>
+BasicVoronoiDiagram<T>::BasicVoronoiDiagram(std::vector<BasicPoint<T>>& points)
+	: Reallocations(0)
+	, MetricsValid(false)
 {
-	MinX = MinY = _DMAX;
-	MaxX = MaxY = -_DMAX;
+	MinX = MinY = std::numeric_limits<Real>::max();
+	MaxX = MaxY = -std::numeric_limits<Real>::max();
+	Points.reserve(points.size());
+	InputOrder.reserve(points.size());
+	SiteOfInput.reserve(points.size());
+	Sites.reserve(points.size());
 
 	int i = 1;
-	for (const Point& p : points)
+	for (const BasicPoint<T>& p : points)
 	{
 		Points.push_back(p);
+		if (!CoordinateTraits<T>::Holds(p))
+		{
+			SiteOfInput.push_back(0);
+			continue;
+		}
+		InputOrder.push_back(int(Points.size()) - 1);
+		SiteOfInput.push_back(i);
 		UpdateBounds(p);
-		VoronoiSite* s = new VoronoiSite({ p, nullptr, nullptr, i });
+		VoronoiSite* s = new VoronoiSite({ { Real(p.x), Real(p.y) }, nullptr, nullptr, i });
 		Sites.push_back(s);
 		i++;
 	}
 }
 
-VoronoiDiagram::VoronoiDiagram(std::string fileLocation)
+template<typename T>
+BasicVoronoiDiagram<T>::BasicVoronoiDiagram(std::string fileLocation)
+	: Reallocations(0)
+	, MetricsValid(false)
 {
-	MinX = MinY = _DMAX;
-	MaxX = MaxY = -_DMAX;
+	MinX = MinY = std::numeric_limits<Real>::max();
+	MaxX = MaxY = -std::numeric_limits<Real>::max();
 	std::cout << "Reading " << fileLocation << std::endl;
 	std::fstream inputFile;
 	inputFile.open(fileLocation, std::ios::in);
@@ -44,7 +69,7 @@ VoronoiDiagram::VoronoiDiagram(std::string fileLocation)
 	if (inputFile.is_open())
 	{
 		int i = 1;
-		double x, y;
+		T x, y;
 		std::string sa;
 		char discard;
 
@@ -54,10 +79,17 @@ VoronoiDiagram::VoronoiDiagram(std::string fileLocation)
 				continue;
 
 			input >> discard >> x >> discard >> y;
-			Point p = { x, y };
+			BasicPoint<T> p = { x, y };
 			Points.push_back(p);
+			if (!CoordinateTraits<T>::Holds(p))
+			{
+				SiteOfInput.push_back(0);
+				continue;
+			}
+			InputOrder.push_back(int(Points.size()) - 1);
+			SiteOfInput.push_back(i);
 			UpdateBounds(p);
-			VoronoiSite* s = new VoronoiSite({ p, nullptr, nullptr, i });
+			VoronoiSite* s = new VoronoiSite({ { Real(p.x), Real(p.y) }, nullptr, nullptr, i });
 			Sites.push_back(s);
 			i++;
 		}
@@ -67,7 +99,8 @@ VoronoiDiagram::VoronoiDiagram(std::string fileLocation)
 	}
 }
 
-void VoronoiDiagram::PrintToFile(std::string fileLocation)
+template<typename T>
+void BasicVoronoiDiagram<T>::PrintToFile(std::string fileLocation)
 {
 	std::fstream file(fileLocation, std::ios::out);
 	if (file.is_open())
@@ -78,10 +111,11 @@ void VoronoiDiagram::PrintToFile(std::string fileLocation)
 	}
 }
 
-void VoronoiDiagram::PrintVoronoiDCEL(std::ostream& os)
+template<typename T>
+void BasicVoronoiDiagram<T>::PrintVoronoiDCEL(std::ostream& os)
 {
 	os << "****** Voronoi diagram ******" << std::endl;
-	for (DCEL::Vertex* v : Vertices)
+	for (Vertex* v : Vertices)
 	{
 		if (v->box) os << "b";
 		else os << "v";
@@ -95,7 +129,7 @@ void VoronoiDiagram::PrintVoronoiDCEL(std::ostream& os)
 
 	os << std::endl;
 
-	for (DCEL::Face* f : Faces)
+	for (Face* f : Faces)
 	{
 		if (f->Unbounded)
 			os << "uf" << " ";
@@ -112,7 +146,7 @@ void VoronoiDiagram::PrintVoronoiDCEL(std::ostream& os)
 
 	os << std::endl;
 
-	for (DCEL::HalfEdge* h : HalfEdges)
+	for (HalfEdge* h : HalfEdges)
 	{
 		os << *h;
 		os << " ";
@@ -140,10 +174,11 @@ void VoronoiDiagram::PrintVoronoiDCEL(std::ostream& os)
 	}
 }
 
-void VoronoiDiagram::PrintDelaunayTriangulation(std::ostream& os)
+template<typename T>
+void BasicVoronoiDiagram<T>::PrintDelaunayTriangulation(std::ostream& os)
 {
 	os << "****** Delaunay triangulation ******" << std::endl;
-	for (DCEL::Vertex* v : TriangulationVertices)
+	for (Vertex* v : TriangulationVertices)
 	{
 		os << "v" << v->index << " " << v->point << " ";
 		if (nullptr == v->incidentEdge)
@@ -155,7 +190,7 @@ void VoronoiDiagram::PrintDelaunayTriangulation(std::ostream& os)
 
 	os << std::endl;
 
-	for (DCEL::Face* f : TriangulationFaces)
+	for (Face* f : TriangulationFaces)
 	{
 		if (f->Unbounded)
 			os << "uf" << " ";
@@ -172,7 +207,7 @@ void VoronoiDiagram::PrintDelaunayTriangulation(std::ostream& os)
 
 	os << std::endl;
 
-	for (DCEL::HalfEdge* h : TriangulationHalfEdges)
+	for (HalfEdge* h : TriangulationHalfEdges)
 	{
 		os << *h;
 		os << " ";
@@ -199,7 +234,358 @@ void VoronoiDiagram::PrintDelaunayTriangulation(std::ostream& os)
 	}
 }
 
-void VoronoiDiagram::UpdateBounds(const Point& point)
+template<typename T>
+void BasicVoronoiDiagram<T>::ReserveCapacity()
+{
+	const size_t n = Sites.size();
+
+	// With h hull sites there are 2n - 2 - h vertices and 3n - 3 - h edges inside the
+	// box and h + 4 of each on it, the triangulation has 2n - 2 - h faces counting the
+	// unbounded one and both halves of its 3n - 3 - h edges
+	Faces.reserve(n + 1);
+	Vertices.reserve(2 * n + 2);
+	HalfEdges.reserve(2 * (3 * n + 1));
+
+	TriangulationVertices.reserve(n);
+	TriangulationFaces.reserve(2 * n);
+	TriangulationHalfEdges.reserve(2 * 3 * n);
+
+	SeenCapacities.clear();
+	Reallocations = 0;
+	CountReallocations();
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::ShrinkToFit()
+{
+	Points.shrink_to_fit();
+	InputOrder.shrink_to_fit();
+	SiteOfInput.shrink_to_fit();
+	Sites.shrink_to_fit();
+	Faces.shrink_to_fit();
+	Vertices.shrink_to_fit();
+	HalfEdges.shrink_to_fit();
+	TriangulationFaces.shrink_to_fit();
+	TriangulationVertices.shrink_to_fit();
+	TriangulationHalfEdges.shrink_to_fit();
+
+	SeenCapacities.clear();
+	CountReallocations();
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::ClearDCEL()
+{
+	SpareFaces.insert(SpareFaces.end(), Faces.begin(), Faces.end());
+	SpareFaces.insert(SpareFaces.end(), TriangulationFaces.begin(), TriangulationFaces.end());
+	SpareVertices.insert(SpareVertices.end(), Vertices.begin(), Vertices.end());
+	SpareVertices.insert(SpareVertices.end(), TriangulationVertices.begin(), TriangulationVertices.end());
+	SpareHalfEdges.insert(SpareHalfEdges.end(), HalfEdges.begin(), HalfEdges.end());
+	SpareHalfEdges.insert(SpareHalfEdges.end(), TriangulationHalfEdges.begin(), TriangulationHalfEdges.end());
+
+	Faces.clear();
+	Vertices.clear();
+	HalfEdges.clear();
+	TriangulationFaces.clear();
+	TriangulationVertices.clear();
+	TriangulationHalfEdges.clear();
+
+	for (VoronoiSite* site : Sites)
+	{
+		site->face = nullptr;
+		site->triVertex = nullptr;
+	}
+	InvalidateMetrics();
+}
+
+template<typename Record>
+static Record* Recycle(std::vector<Record*>& spares, const Record& record)
+{
+	if (spares.empty())
+		return new Record(record);
+
+	Record* spare = spares.back();
+	spares.pop_back();
+	*spare = record;
+	return spare;
+}
+
+// The record made before this one has been added to its container by now, so a container
+// grows at most once between two looks
+template<typename T>
+typename BasicVoronoiDiagram<T>::Face* BasicVoronoiDiagram<T>::NewFace(const Face& face)
+{
+	CountGrowth(0, Faces.capacity());
+	CountGrowth(3, TriangulationFaces.capacity());
+	return Recycle(SpareFaces, face);
+}
+
+template<typename T>
+typename BasicVoronoiDiagram<T>::Vertex* BasicVoronoiDiagram<T>::NewVertex(const Vertex& vertex)
+{
+	CountGrowth(1, Vertices.capacity());
+	CountGrowth(4, TriangulationVertices.capacity());
+	return Recycle(SpareVertices, vertex);
+}
+
+template<typename T>
+typename BasicVoronoiDiagram<T>::HalfEdge* BasicVoronoiDiagram<T>::NewHalfEdge(const HalfEdge& halfEdge)
+{
+	CountGrowth(2, HalfEdges.capacity());
+	CountGrowth(5, TriangulationHalfEdges.capacity());
+	return Recycle(SpareHalfEdges, halfEdge);
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::CountReallocations()
+{
+	const size_t capacities[] = {
+		Faces.capacity(), Vertices.capacity(), HalfEdges.capacity(),
+		TriangulationFaces.capacity(), TriangulationVertices.capacity(), TriangulationHalfEdges.capacity() };
+	const size_t count = sizeof(capacities) / sizeof(capacities[0]);
+
+	// The first look only records where the containers start
+	if (SeenCapacities.empty())
+	{
+		SeenCapacities.assign(capacities, capacities + count);
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		CountGrowth(i, capacities[i]);
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::CountGrowth(size_t container, size_t capacity)
+{
+	if (SeenCapacities.empty())
+		CountReallocations();
+	if (capacity > SeenCapacities[container])
+		Reallocations++;
+	SeenCapacities[container] = capacity;
+}
+
+template<typename T>
+const typename BasicVoronoiDiagram<T>::CellMetrics& BasicVoronoiDiagram<T>::Metrics(unsigned threads)
+{
+	if (!MetricsValid)
+		ComputeMetrics(threads);
+	return CachedMetrics;
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::InvalidateMetrics()
+{
+	MetricsValid = false;
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::ComputeMetrics(unsigned threads)
+{
+	// Each cell is measured by walking its own boundary, so a thread only ever writes the
+	// entries of the cells it was given. Shoelace terms are taken about the site, inside
+	// its cell, as ExtractCells takes them.
+	const size_t n = Sites.size();
+	const size_t limit = HalfEdges.size();
+
+	CachedMetrics.Area.resize(n);
+	CachedMetrics.Perimeter.resize(n);
+	CachedMetrics.CentroidX.resize(n);
+	CachedMetrics.CentroidY.resize(n);
+	CachedMetrics.Degree.resize(n);
+
+	ParallelFor(n, threads, ParallelThreshold, [&](size_t begin, size_t end)
+	{
+		CellMeasure<Real> measure;
+		for (size_t i = begin; i < end; i++)
+		{
+			const BasicPoint<Real>& site = Sites[i]->point;
+			const bool closed = MeasureCell<T>(Sites[i]->face, site, limit, measure, [](const BasicPoint<Real>&) {});
+
+			CachedMetrics.Degree[i] = closed ? measure.Degree : 0;
+			if (!closed || Real(0) == measure.Sums.TwiceArea)
+			{
+				CachedMetrics.Area[i] = 0;
+				CachedMetrics.Perimeter[i] = 0;
+				CachedMetrics.CentroidX[i] = site.x;
+				CachedMetrics.CentroidY[i] = site.y;
+				continue;
+			}
+			CachedMetrics.Area[i] = std::abs(measure.Sums.TwiceArea) / Real(2);
+			CachedMetrics.Perimeter[i] = measure.Perimeter;
+			CachedMetrics.CentroidX[i] = site.x + measure.Sums.CentroidX();
+			CachedMetrics.CentroidY[i] = site.y + measure.Sums.CentroidY();
+		}
+	});
+
+	MetricsValid = true;
+}
+
+// Moves the contents of the records so the k-th of them sits at the k-th lowest of their
+// addresses, and returns every old address paired with the new one, sorted by old address
+template<typename Record>
+static std::vector<std::pair<Record*, Record*>> PlaceInOrder(std::vector<Record*>& records)
+{
+	std::vector<Record*> addresses(records);
+	std::sort(addresses.begin(), addresses.end());
+	std::vector<Record> contents;
+	contents.reserve(records.size());
+	for (const Record* record : records)
+		contents.push_back(*record);
+
+	std::vector<std::pair<Record*, Record*>> moved(records.size());
+	for (size_t k = 0; k < records.size(); k++)
+	{
+		moved[k] = { records[k], addresses[k] };
+		*addresses[k] = contents[k];
+		records[k] = addresses[k];
+	}
+	std::sort(moved.begin(), moved.end());
+	return moved;
+}
+
+template<typename Record>
+static Record* MovedTo(const std::vector<std::pair<Record*, Record*>>& moved, Record* record)
+{
+	auto it = std::lower_bound(moved.begin(), moved.end(), std::pair<Record*, Record*>(record, nullptr));
+	return (nullptr != record && it != moved.end() && it->first == record) ? it->second : record;
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::ReorderForLocality()
+{
+	InvalidateMetrics();
+
+	// Sites along the curve, renumbered from 1 like the input numbering
+	std::vector<std::pair<uint64_t, VoronoiSite*>> keyedSites;
+	keyedSites.reserve(Sites.size());
+	for (VoronoiSite* site : Sites)
+		keyedSites.push_back({ CurveKey(site->point), site });
+	std::stable_sort(keyedSites.begin(), keyedSites.end(),
+		[](const std::pair<uint64_t, VoronoiSite*>& a, const std::pair<uint64_t, VoronoiSite*>& b) { return a.first < b.first; });
+
+	std::vector<int> newIndex(Sites.size() + 1, 0);
+	std::vector<int> inputOrder(Sites.size());
+	for (size_t i = 0; i < keyedSites.size(); i++)
+	{
+		VoronoiSite* site = keyedSites[i].second;
+		inputOrder[i] = InputOrder[site->index - 1];
+		newIndex[site->index] = int(i) + 1;
+		site->index = int(i) + 1;
+		Sites[i] = site;
+	}
+	InputOrder.swap(inputOrder);
+	for (int& site : SiteOfInput)
+		site = newIndex[site];
+
+	// Delaunay vertices carry the index of their site
+	for (Vertex* v : TriangulationVertices)
+		v->index = newIndex[v->index];
+	std::sort(TriangulationVertices.begin(), TriangulationVertices.end(),
+		[](const Vertex* a, const Vertex* b) { return a->index < b->index; });
+
+	// Cells follow their sites, the unbounded face stays last
+	std::vector<Face*> faces;
+	faces.reserve(Faces.size());
+	for (VoronoiSite* site : Sites)
+		if (site->face) faces.push_back(site->face);
+	for (Face* f : Faces)
+		if (f->Unbounded || nullptr == f->site) faces.push_back(f);
+	Faces.swap(faces);
+
+	// Half-edges cell by cell, each cycle in walking order
+	std::vector<HalfEdge*> halfEdges;
+	halfEdges.reserve(HalfEdges.size());
+	std::vector<bool> placed(HalfEdges.size(), false);
+	std::vector<std::pair<HalfEdge*, size_t>> slots;
+	slots.reserve(HalfEdges.size());
+	for (size_t i = 0; i < HalfEdges.size(); i++)
+		slots.push_back({ HalfEdges[i], i });
+	std::sort(slots.begin(), slots.end());
+	auto slotOf = [&](HalfEdge* h) -> size_t
+	{
+		auto it = std::lower_bound(slots.begin(), slots.end(), std::pair<HalfEdge*, size_t>(h, 0));
+		return (it != slots.end() && it->first == h) ? it->second : HalfEdges.size();
+	};
+	auto walk = [&](HalfEdge* start)
+	{
+		HalfEdge* h = start;
+		while (h)
+		{
+			const size_t slot = slotOf(h);
+			if (slot == HalfEdges.size() || placed[slot]) break;
+			placed[slot] = true;
+			halfEdges.push_back(h);
+			h = h->next;
+		}
+	};
+	for (Face* f : Faces)
+	{
+		walk(f->outerComponent);
+		walk(f->innerComponent);
+	}
+	for (size_t i = 0; i < HalfEdges.size(); i++)
+		if (!placed[i]) halfEdges.push_back(HalfEdges[i]);
+	HalfEdges.swap(halfEdges);
+
+	// Vertices along the curve, the bounding box keeps its own numbering
+	std::vector<std::pair<uint64_t, Vertex*>> keyedVertices;
+	keyedVertices.reserve(Vertices.size());
+	for (Vertex* v : Vertices)
+		keyedVertices.push_back({ CurveKey(v->point), v });
+	std::stable_sort(keyedVertices.begin(), keyedVertices.end(),
+		[](const std::pair<uint64_t, Vertex*>& a, const std::pair<uint64_t, Vertex*>& b) { return a.first < b.first; });
+
+	int numVertices = 0, numBoxVertices = 0;
+	for (size_t i = 0; i < keyedVertices.size(); i++)
+	{
+		Vertex* v = keyedVertices[i].second;
+		v->index = v->box ? ++numBoxVertices : ++numVertices;
+		Vertices[i] = v;
+	}
+
+	// Records come from the heap one at a time, so the order above is put into memory by
+	// moving their contents onto their addresses in ascending order
+	const std::vector<std::pair<VoronoiSite*, VoronoiSite*>> movedSites = PlaceInOrder(Sites);
+	const std::vector<std::pair<Face*, Face*>> movedFaces = PlaceInOrder(Faces);
+	const std::vector<std::pair<Vertex*, Vertex*>> movedVertices = PlaceInOrder(Vertices);
+	const std::vector<std::pair<HalfEdge*, HalfEdge*>> movedHalfEdges = PlaceInOrder(HalfEdges);
+	for (VoronoiSite* site : Sites)
+		site->face = MovedTo(movedFaces, site->face);
+	for (Face* f : Faces)
+	{
+		f->site = MovedTo(movedSites, f->site);
+		f->outerComponent = MovedTo(movedHalfEdges, f->outerComponent);
+		f->innerComponent = MovedTo(movedHalfEdges, f->innerComponent);
+	}
+	for (Vertex* v : Vertices)
+		v->incidentEdge = MovedTo(movedHalfEdges, v->incidentEdge);
+	for (HalfEdge* h : HalfEdges)
+	{
+		h->origin = MovedTo(movedVertices, h->origin);
+		h->dest = MovedTo(movedVertices, h->dest);
+		h->twin = MovedTo(movedHalfEdges, h->twin);
+		h->next = MovedTo(movedHalfEdges, h->next);
+		h->prev = MovedTo(movedHalfEdges, h->prev);
+		h->incidentFace = MovedTo(movedFaces, h->incidentFace);
+	}
+}
+
+template<typename T>
+uint64_t BasicVoronoiDiagram<T>::CurveKey(const BasicPoint<Real>& point) const
+{
+	const Real cells = Real((uint32_t(1) << HilbertOrder) - 1);
+	const Real width = MaxX > MinX ? MaxX - MinX : Real(1);
+	const Real height = MaxY > MinY ? MaxY - MinY : Real(1);
+
+	// Box vertices sit outside the bounds, clamp them onto the edge cells
+	const Real x = std::min(std::max((point.x - MinX) / width, Real(0)), Real(1));
+	const Real y = std::min(std::max((point.y - MinY) / height, Real(0)), Real(1));
+	return HilbertIndex(uint32_t(x * cells), uint32_t(y * cells));
+}
+
+template<typename T>
+void BasicVoronoiDiagram<T>::UpdateBounds(const BasicPoint<T>& point)
 {
 	if (point.y < MinY)
 		MinY = point.y;
@@ -211,4 +597,10 @@ void VoronoiDiagram::UpdateBounds(const Point& point)
 		MaxX = point.x;
 }
 
+template std::ostream& operator<<(std::ostream&, const BasicVoronoiSite<float>&);
+template std::ostream& operator<<(std::ostream&, const BasicVoronoiSite<double>&);
+template std::ostream& operator<<(std::ostream&, const BasicVoronoiSite<int64_t>&);
 
+template class BasicVoronoiDiagram<float>;
+template class BasicVoronoiDiagram<double>;
+template class BasicVoronoiDiagram<int64_t>;
@@ -3,45 +3,132 @@
 #include "DCELTypes.h"
 #include "Point.h"
 
+#include <cstdint>
 #include <vector>
 #include <iostream>
 
-struct VoronoiSite
+template<typename T>
+struct BasicVoronoiSite
 {
-	Point point;
-	DCEL::Face* face;
-	DCEL::Vertex* triVertex;
+	BasicPoint<typename CoordinateTraits<T>::Real> point;
+	DCEL::BasicFace<T>* face;
+	DCEL::BasicVertex<T>* triVertex;
 	int index;
+	// Weight in the power diagram, ApplyWeights gives heavier sites larger cells
+	typename CoordinateTraits<T>::Real weight = 0;
 };
 
-std::ostream& operator<<(std::ostream& os, const VoronoiSite& site);
+typedef BasicVoronoiSite<double> VoronoiSite;
 
-class VoronoiDiagram
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const BasicVoronoiSite<T>& site);
+
+template<typename T> class BasicFortunesAlgorithm;
+
+// Measures of every cell of a finished diagram, one array per measure. Entry i is the
+// cell of site index i + 1.
+template<typename T>
+struct BasicCellMetrics
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+
+	std::vector<Real> Area;
+	std::vector<Real> Perimeter;
+	std::vector<Real> CentroidX;
+	std::vector<Real> CentroidY;
+	// Edges the cell shares with other cells
+	std::vector<int> Degree;
+};
+
+// The input sites keep their coordinate type T, everything the sweep builds from
+// them is in CoordinateTraits<T>::Real.
+template<typename T>
+class BasicVoronoiDiagram
 {
 public:
-	VoronoiDiagram(std::vector<Point>& points);
-	VoronoiDiagram(std::string fileLocation);
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef BasicVoronoiSite<T> VoronoiSite;
+	typedef DCEL::BasicVertex<T> Vertex;
+	typedef DCEL::BasicFace<T> Face;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+	typedef BasicCellMetrics<T> CellMetrics;
+
+	BasicVoronoiDiagram(std::vector<BasicPoint<T>>& points);
+	BasicVoronoiDiagram(std::string fileLocation);
 
-	std::vector<Point> Points;
+	std::vector<BasicPoint<T>> Points;
+	// InputOrder[i] is the position in Points of the input that became Sites[i]
+	std::vector<int> InputOrder;
+	// SiteOfInput[i] is the index of the site standing for Points[i], 0 for an input
+	// outside CoordinateTraits<T>::Holds that no site stands for
+	std::vector<int> SiteOfInput;
 
 	std::vector<VoronoiSite*> Sites;
-	std::vector<DCEL::Face*> Faces;
-	std::vector<DCEL::Vertex*> Vertices;
-	std::vector<DCEL::HalfEdge*> HalfEdges;
+	std::vector<Face*> Faces;
+	std::vector<Vertex*> Vertices;
+	std::vector<HalfEdge*> HalfEdges;
 
-	std::vector<DCEL::Face*> TriangulationFaces;
-	std::vector<DCEL::Vertex*> TriangulationVertices;
-	std::vector<DCEL::HalfEdge*> TriangulationHalfEdges;
+	std::vector<Face*> TriangulationFaces;
+	std::vector<Vertex*> TriangulationVertices;
+	std::vector<HalfEdge*> TriangulationHalfEdges;
+
+	// Sorts the sites along a Hilbert curve over the bounds and renumbers them, then lays
+	// out the faces, vertices and half-edges in the same order so neighbouring cells sit
+	// close in memory. Called before the sweep only the sites move, the sweep then builds
+	// in event order. InputOrder keeps the way back to the input either way. Records keep
+	// their addresses but trade contents, so it must not be called while an algorithm
+	// holds pointers into the diagram.
+	void ReorderForLocality();
+
+	// Reserves every container for the most records the sweep can make from the sites.
+	// By Euler's formula n sites give at most 2n - 5 Voronoi vertices and 3n - 6 edges,
+	// the bounding box adds a vertex and an edge per hull edge plus the four corners.
+	void ReserveCapacity();
+	// Returns the slack left by ReserveCapacity once the diagram is built
+	void ShrinkToFit();
+	// Empties every record container and keeps the sites, so the diagram can be swept
+	// again. The containers keep their capacity and the records are set aside for the
+	// next sweep to fill in rather than deleted.
+	void ClearDCEL();
+
+	// Area, perimeter, centroid and degree of every cell. The first call after the diagram
+	// changes works them out in parallel, one boundary walk per cell, later calls return the
+	// same arrays. A cell whose boundary does not close gets its site as the centroid and
+	// no area, perimeter or degree. The first call must not race another.
+	const CellMetrics& Metrics(unsigned threads = 0);
+	// Drops the cached metrics, for code that edits the DCEL
+	void InvalidateMetrics();
 
 	void PrintToFile(std::string fileLocation);
 	void PrintVoronoiDCEL(std::ostream& os);
 	void PrintDelaunayTriangulation(std::ostream& os);
 
-	double MinX, MinY, MaxX, MaxY;
+	// A record set aside by ClearDCEL, or a new one when none is left. The caller adds it
+	// to its container. Each call also looks for growth in the containers of its type.
+	Face* NewFace(const Face& face);
+	Vertex* NewVertex(const Vertex& vertex);
+	HalfEdge* NewHalfEdge(const HalfEdge& halfEdge);
+
+	Real MinX, MinY, MaxX, MaxY;
+	// Times a record container grew since ReserveCapacity, looked for each time a record
+	// is made and when the sweep finishes
+	size_t Reallocations;
 
 private:
-	void UpdateBounds(const Point& point);
+	void UpdateBounds(const BasicPoint<T>& point);
+	uint64_t CurveKey(const BasicPoint<Real>& point) const;
+	void CountReallocations();
+	void CountGrowth(size_t container, size_t capacity);
+	void ComputeMetrics(unsigned threads);
+	std::vector<Face*> SpareFaces;
+	std::vector<Vertex*> SpareVertices;
+	std::vector<HalfEdge*> SpareHalfEdges;
+	std::vector<size_t> SeenCapacities;
+	CellMetrics CachedMetrics;
+	bool MetricsValid;
+
 
+	friend class BasicFortunesAlgorithm<T>;
+};
 
-	friend class FortunesAlgorithm;
-};
\ No newline at end of file
+typedef BasicVoronoiDiagram<double> VoronoiDiagram;
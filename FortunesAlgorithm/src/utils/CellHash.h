@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+// A cell of a uniform grid laid over the plane, used to hash points that should be
+// found again by position
+struct CellKey
+{
+	int64_t x, y;
+
+	bool operator==(const CellKey& rhs) const { return x == rhs.x && y == rhs.y; }
+};
+
+struct CellKeyHash
+{
+	size_t operator()(const CellKey& key) const
+	{
+		return std::hash<uint64_t>()(uint64_t(key.x) * 73856093u) ^ std::hash<uint64_t>()(uint64_t(key.y) * 19349663u);
+	}
+};
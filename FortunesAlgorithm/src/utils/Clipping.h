@@ -0,0 +1,50 @@
+#pragma once
+
+#include "../types/Point.h"
+
+#include <vector>
+
+// Parameters
+//		polygon : the corners of a convex polygon, replaced by those of the clipped one
+//		scratch : working space, passing the same vector again saves reallocating it
+// Sutherland-Hodgman against each side of the rectangle in turn. A polygon entirely
+// outside comes back empty.
+template<typename Real>
+void ClipToRectangle(std::vector<BasicPoint<Real>>& polygon, std::vector<BasicPoint<Real>>& scratch,
+	Real minX, Real minY, Real maxX, Real maxY)
+{
+	typedef BasicPoint<Real> Point;
+
+	for (int side = 0; side < 4 && !polygon.empty(); side++)
+	{
+		// Signed distance inside the side, non negative when kept
+		auto inside = [=](const Point& p) -> Real
+		{
+			switch (side)
+			{
+			case 0: return p.x - minX;
+			case 1: return maxX - p.x;
+			case 2: return p.y - minY;
+			default: return maxY - p.y;
+			}
+		};
+
+		scratch.clear();
+		for (size_t i = 0; i < polygon.size(); i++)
+		{
+			const Point& a = polygon[i];
+			const Point& b = polygon[(i + 1) % polygon.size()];
+			const Real da = inside(a);
+			const Real db = inside(b);
+
+			if (da >= Real(0))
+				scratch.push_back(a);
+			if ((da >= Real(0)) != (db >= Real(0)))
+			{
+				const Real t = da / (da - db);
+				scratch.push_back(Point(a.x + t * (b.x - a.x), a.y + t * (b.y - a.y)));
+			}
+		}
+		polygon.swap(scratch);
+	}
+}
@@ -1,9 +1,9 @@
 #pragma once
 
-struct Point;
+#include "../types/Point.h"
 
 ///////////////////////////////////////////////////////////
-static class PlaneBounds
+class PlaneBounds
 {
 public:
 	///////////////////////////////////////////////////////////
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <coroutine>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+// Minimal pull based generator for coroutines that co_yield values. The coroutine only
+// runs up to its next co_yield when the iterator is advanced, so values are produced lazily
+// and a consumer can stop early without paying for the remaining work.
+template <typename T>
+class Generator
+{
+public:
+	struct promise_type
+	{
+		const T* Current = nullptr;
+
+		Generator get_return_object() { return Generator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		std::suspend_always yield_value(const T& value) noexcept
+		{
+			Current = std::addressof(value);
+			return {};
+		}
+		void return_void() noexcept {}
+		void unhandled_exception() { throw; }
+	};
+
+	class Iterator
+	{
+	public:
+		using iterator_category = std::input_iterator_tag;
+		using difference_type = std::ptrdiff_t;
+		using value_type = T;
+
+		Iterator() : Handle(nullptr) {}
+		explicit Iterator(std::coroutine_handle<promise_type> handle) : Handle(handle) {}
+
+		const T& operator*() const { return *Handle.promise().Current; }
+		const T* operator->() const { return Handle.promise().Current; }
+
+		Iterator& operator++()
+		{
+			Handle.resume();
+			return *this;
+		}
+		void operator++(int) { ++*this; }
+
+		bool operator==(std::default_sentinel_t) const { return !Handle || Handle.done(); }
+
+	private:
+		std::coroutine_handle<promise_type> Handle;
+	};
+
+	explicit Generator(std::coroutine_handle<promise_type> handle) : Handle(handle) {}
+	Generator(Generator&& other) noexcept : Handle(std::exchange(other.Handle, nullptr)) {}
+	Generator(const Generator&) = delete;
+	Generator& operator=(const Generator&) = delete;
+
+	~Generator()
+	{
+		if (Handle)
+			Handle.destroy();
+	}
+
+	Iterator begin()
+	{
+		Handle.resume();
+		return Iterator(Handle);
+	}
+	std::default_sentinel_t end() { return std::default_sentinel; }
+
+private:
+	std::coroutine_handle<promise_type> Handle;
+};
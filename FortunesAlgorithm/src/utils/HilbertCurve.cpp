@@ -0,0 +1,28 @@
+#include "HilbertCurve.h"
+
+////////////////////////////////////////////////////////////////////
+uint64_t HilbertIndex(uint32_t x, uint32_t y)
+{
+	const uint32_t side = uint32_t(1) << HilbertOrder;
+	uint64_t d = 0;
+	for (uint32_t s = side / 2; s > 0; s /= 2)
+	{
+		const uint32_t rx = (x & s) > 0;
+		const uint32_t ry = (y & s) > 0;
+		d += uint64_t(s) * uint64_t(s) * ((3 * rx) ^ ry);
+
+		// Rotate the quadrant so the sub curve starts and ends where its parent expects
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = side - 1 - x;
+				y = side - 1 - y;
+			}
+			const uint32_t t = x;
+			x = y;
+			y = t;
+		}
+	}
+	return d;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+// Number of bits per axis of the grid the curve is walked over
+const int HilbertOrder = 16;
+
+// Parameters
+//		x, y : the cell on a 2^HilbertOrder by 2^HilbertOrder grid
+// Returns the position of the cell along the Hilbert curve through the grid. Cells
+// close in curve position are close in the plane, so sorting by it keeps neighbours
+// together in memory.
+uint64_t HilbertIndex(uint32_t x, uint32_t y);
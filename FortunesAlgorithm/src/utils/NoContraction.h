@@ -0,0 +1,13 @@
+#pragma once
+
+// Stops the compiler fusing a multiply and add into one FMA in the rest of the file
+// that includes it. The fused form skips a rounding, which breaks the error free sums
+// of the exact predicates and makes the SIMD breakpoint kernels round unlike the
+// scalar functions once the target has FMA.
+#if defined(_MSC_VER)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Below this many items one thread gets through them faster than starting several,
+// the minimum the passes over sites and cells hand to ParallelFor
+const size_t ParallelThreshold = 1 << 12;
+
+// Calls fill(begin, end) over stretches of 0 to count - 1, one stretch per thread and
+// the first on the calling thread. Threads of 0 uses every hardware thread, and below
+// minimum items everything runs on the calling thread.
+template<typename Fill>
+void ParallelFor(size_t count, unsigned threads, size_t minimum, Fill fill)
+{
+	if (0 == threads)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	if (count < minimum)
+		threads = 1;
+
+	std::vector<std::thread> workers;
+	const size_t chunk = (count + threads - 1) / threads;
+	for (unsigned t = 1; t < threads; t++)
+	{
+		const size_t begin = std::min(count, t * chunk);
+		const size_t end = std::min(count, begin + chunk);
+		workers.emplace_back(fill, begin, end);
+	}
+	fill(0, std::min(count, chunk));
+	for (std::thread& worker : workers)
+		worker.join();
+}
@@ -7,25 +7,29 @@
 #include <vector>
 #include <ostream>
 
-PriorityQueue::PriorityQueue() : Elements()
+template<typename T>
+BasicPriorityQueue<T>::BasicPriorityQueue() : Elements()
 {
 
 }
 
-void PriorityQueue::Push(EventPoint* e)
+template<typename T>
+void BasicPriorityQueue<T>::Push(EventPoint* e)
 {
 	Elements.push_back(e);
 	percolateUp(Elements.size() - 1);
 }
 
-EventPoint* PriorityQueue::Peek()
+template<typename T>
+typename BasicPriorityQueue<T>::EventPoint* BasicPriorityQueue<T>::Peek()
 {
 	if (0 >= Elements.size())
 		return nullptr;
 	return Elements.at(0);
 }
 
-EventPoint* PriorityQueue::Pop()
+template<typename T>
+typename BasicPriorityQueue<T>::EventPoint* BasicPriorityQueue<T>::Pop()
 {
 	swap(0, Elements.size() - 1);
 	EventPoint* top = Elements.back();
@@ -34,12 +38,14 @@ EventPoint* PriorityQueue::Pop()
 	return top;
 }
 
-bool PriorityQueue::IsEmpty()
+template<typename T>
+bool BasicPriorityQueue<T>::IsEmpty()
 {
 	return Elements.empty();
 }
 
-void PriorityQueue::percolateUp(size_t index)
+template<typename T>
+void BasicPriorityQueue<T>::percolateUp(size_t index)
 {
 	size_t parent = (index - 1) / 2;
 	while (index > 0 && Elements[index]->isGreater(*Elements[parent]))
@@ -50,7 +56,8 @@ void PriorityQueue::percolateUp(size_t index)
 	}
 }
 
-void PriorityQueue::percolateDown(size_t index)
+template<typename T>
+void BasicPriorityQueue<T>::percolateDown(size_t index)
 {
 	size_t child = 2 * index + 1;
 	while (child < Elements.size())
@@ -70,22 +77,26 @@ void PriorityQueue::percolateDown(size_t index)
 	}
 }
 
-void PriorityQueue::swap(size_t index, size_t swappedIndex)
+template<typename T>
+void BasicPriorityQueue<T>::swap(size_t index, size_t swappedIndex)
 {
 	EventPoint* tmp = std::move(Elements[index]);
 	Elements[index] = std::move(Elements[swappedIndex]);
 	Elements[swappedIndex] = std::move(tmp);
 }
 
-std::ostream& operator<<(std::ostream& os, const PriorityQueue& queue)
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const BasicPriorityQueue<T>& queue)
 {
-	for (EventPoint* e : queue.Elements)
+	for (BasicEventPoint<T>* e : queue.Elements)
 		os << "(" << e->Site->point.x << ", " << e->Site->point.y << ") ";
 	return os;
 }
 
+template class BasicPriorityQueue<float>;
+template class BasicPriorityQueue<double>;
+template class BasicPriorityQueue<int64_t>;
 
-
-
-
-
+template std::ostream& operator<<(std::ostream&, const BasicPriorityQueue<float>&);
+template std::ostream& operator<<(std::ostream&, const BasicPriorityQueue<double>&);
+template std::ostream& operator<<(std::ostream&, const BasicPriorityQueue<int64_t>&);
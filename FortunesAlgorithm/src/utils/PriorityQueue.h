@@ -5,10 +5,13 @@
 #include <ostream>
 #include <vector>
 // 2i+1 and 2i + 2, and its parent's index is floor((i − 1)/2)
-class PriorityQueue
+template<typename T>
+class BasicPriorityQueue
 {
 public:
-	PriorityQueue();
+	typedef BasicEventPoint<T> EventPoint;
+
+	BasicPriorityQueue();
 
 	void Push(EventPoint* e);
 	EventPoint* Peek();
@@ -24,5 +27,8 @@ private:
 	void swap(size_t index, size_t swappedIndex);
 };
 
-std::ostream& operator<<(std::ostream& os, const PriorityQueue& queue);
+typedef BasicPriorityQueue<double> PriorityQueue;
+
+template<typename T>
+std::ostream& operator<<(std::ostream& os, const BasicPriorityQueue<T>& queue);
 
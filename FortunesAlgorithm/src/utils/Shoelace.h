@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../types/DCELTypes.h"
+
+#include <cmath>
+#include <cstddef>
+
+// Shoelace sums of a polygon's area and first moments, taken edge by edge about a
+// point of the caller's choosing. A point inside or on the polygon keeps the products
+// small. The metrics, cell extraction and Lloyd relaxation all measure cells with it.
+template<typename Real>
+struct ShoelaceSums
+{
+	Real TwiceArea = 0;
+	Real MomentX = 0;
+	Real MomentY = 0;
+
+	// The edge from a to b, both relative to the point the sums are taken about
+	void AddEdge(Real ax, Real ay, Real bx, Real by)
+	{
+		const Real cross = ax * by - ay * bx;
+		TwiceArea += cross;
+		MomentX += cross * (ax + bx);
+		MomentY += cross * (ay + by);
+	}
+
+	// Offset of the centroid from that point, only meaningful once TwiceArea is not zero
+	Real CentroidX() const { return MomentX / (Real(3) * TwiceArea); }
+	Real CentroidY() const { return MomentY / (Real(3) * TwiceArea); }
+};
+
+// What one walk of a cell's boundary finds
+template<typename Real>
+struct CellMeasure
+{
+	ShoelaceSums<Real> Sums;
+	Real Perimeter = 0;
+	// Edges shared with other cells
+	int Degree = 0;
+	size_t Corners = 0;
+};
+
+// Walks the face's boundary once, taking the sums about the point given and handing
+// every corner in turn to corner(point). Returns false when the boundary is missing or
+// does not close within limit edges. The metrics and cell extraction both measure with it.
+template<typename T, typename Corner>
+bool MeasureCell(const DCEL::BasicFace<T>* face, const BasicPoint<typename CoordinateTraits<T>::Real>& about, size_t limit,
+	CellMeasure<typename CoordinateTraits<T>::Real>& measure, Corner corner)
+{
+	typedef typename CoordinateTraits<T>::Real Real;
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	measure = CellMeasure<Real>();
+	const HalfEdge* start = face ? face->outerComponent : nullptr;
+	const HalfEdge* edge = start;
+	while (edge && measure.Corners <= limit)
+	{
+		if (nullptr == edge->origin || nullptr == edge->dest || nullptr == edge->next || edge->next->origin != edge->dest)
+			return false;
+
+		corner(edge->origin->point);
+		const Real ax = edge->origin->point.x - about.x, ay = edge->origin->point.y - about.y;
+		const Real bx = edge->dest->point.x - about.x, by = edge->dest->point.y - about.y;
+		measure.Sums.AddEdge(ax, ay, bx, by);
+		measure.Perimeter += std::sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+		measure.Corners++;
+
+		const DCEL::BasicFace<T>* across = edge->twin ? edge->twin->incidentFace : nullptr;
+		if (across && !across->Unbounded && across->site)
+			measure.Degree++;
+
+		edge = edge->next;
+		if (edge == start)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+// Lock free hand off between one producer and one consumer. The producer fills
+// the write slot and publishes it, the consumer always reads the most recently
+// published slot. A third slot sits between the two so that publishing never has
+// to wait for the reader to let go of the front buffer, neither side ever blocks.
+template <typename T>
+class SnapshotBuffer
+{
+public:
+	SnapshotBuffer() : Buffers(), Middle(1), WriteIndex(0), ReadIndex(2)
+	{
+
+	}
+
+	// Producer side
+	T& WriteBuffer() { return Buffers[WriteIndex]; }
+
+	void Publish()
+	{
+		int previous = Middle.exchange(WriteIndex | FreshBit, std::memory_order_acq_rel);
+		WriteIndex = previous & IndexMask;
+	}
+
+	// Consumer side
+	const T& Read()
+	{
+		if (Middle.load(std::memory_order_relaxed) & FreshBit)
+		{
+			int previous = Middle.exchange(ReadIndex, std::memory_order_acq_rel);
+			ReadIndex = previous & IndexMask;
+		}
+		return Buffers[ReadIndex];
+	}
+
+private:
+	static const int IndexMask = 3;
+	static const int FreshBit = 4;
+
+	T Buffers[3];
+	std::atomic<int> Middle;
+	int WriteIndex;
+	int ReadIndex;
+};
@@ -0,0 +1,363 @@
+#pragma once
+
+#include "../types/DCELTypes.h"
+#include "../types/VoronoiDiagram.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Helpers shared by the updates that edit a finished diagram in place
+
+// No vertex of a sound triangulation has more neighbours than this
+const size_t FanLimit = 1 << 12;
+
+// The centre of the circle through a, b and c
+template<typename Real>
+BasicPoint<Real> Circumcentre(const BasicPoint<Real>& a, const BasicPoint<Real>& b, const BasicPoint<Real>& c)
+{
+	const Real bx = b.x - a.x, by = b.y - a.y;
+	const Real cx = c.x - a.x, cy = c.y - a.y;
+	const Real d = Real(2) * (bx * cy - by * cx);
+	const Real bLift = bx * bx + by * by;
+	const Real cLift = cx * cx + cy * cy;
+	return BasicPoint<Real>(a.x + (cy * bLift - by * cLift) / d, a.y + (bx * cLift - cx * bLift) / d);
+}
+
+// The point of equal power from a, b and c, whose weights are aw, bw and cw. With equal
+// weights it is the circumcentre.
+template<typename Real>
+BasicPoint<Real> PowerCentre(const BasicPoint<Real>& a, Real aw, const BasicPoint<Real>& b, Real bw, const BasicPoint<Real>& c, Real cw)
+{
+	const Real bx = b.x - a.x, by = b.y - a.y;
+	const Real cx = c.x - a.x, cy = c.y - a.y;
+	const Real d = Real(2) * (bx * cy - by * cx);
+	const Real bLift = bx * bx + by * by - (bw - aw);
+	const Real cLift = cx * cx + cy * cy - (cw - aw);
+	return BasicPoint<Real>(a.x + (cy * bLift - by * cLift) / d, a.y + (bx * cLift - cx * bLift) / d);
+}
+
+// The sweep leaves the unbounded face last, new faces go in before it
+template<typename Face>
+void AddBounded(std::vector<Face*>& faces, Face* face)
+{
+	if (!faces.empty() && faces.back()->Unbounded)
+		faces.insert(faces.end() - 1, face);
+	else
+		faces.push_back(face);
+}
+
+// A triangle the update took out earlier, it keeps its place and index. Otherwise one
+// from the diagram's records goes in before the unbounded face.
+template<typename T>
+DCEL::BasicFace<T>* NewTriangle(BasicVoronoiDiagram<T>& diagram, std::vector<DCEL::BasicFace<T>*>& spares)
+{
+	typedef DCEL::BasicFace<T> Face;
+
+	if (!spares.empty())
+	{
+		Face* triangle = spares.back();
+		spares.pop_back();
+		const int index = triangle->index;
+		*triangle = Face();
+		triangle->index = index;
+		return triangle;
+	}
+
+	Face* triangle = diagram.NewFace(Face());
+	triangle->index = int(diagram.TriangulationFaces.size()) + 1;
+	AddBounded(diagram.TriangulationFaces, triangle);
+	return triangle;
+}
+
+// A half-edge the update took out earlier, otherwise one from the diagram's records
+template<typename T>
+DCEL::BasicHalfEdge<T>* NewTriangleEdge(BasicVoronoiDiagram<T>& diagram, std::vector<DCEL::BasicHalfEdge<T>*>& spares)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	if (!spares.empty())
+	{
+		HalfEdge* edge = spares.back();
+		spares.pop_back();
+		*edge = HalfEdge();
+		return edge;
+	}
+
+	diagram.TriangulationHalfEdges.push_back(diagram.NewHalfEdge(HalfEdge()));
+	return diagram.TriangulationHalfEdges.back();
+}
+
+// Takes the records out of the container and deletes them. The container is scanned
+// once, so this is only done for records an update could not reuse.
+template<typename Record>
+void DropRecords(std::vector<Record*>& records, std::vector<Record*>& dropped)
+{
+	if (dropped.empty())
+		return;
+
+	std::sort(dropped.begin(), dropped.end());
+	records.erase(std::remove_if(records.begin(), records.end(),
+		[&dropped](Record* record) { return std::binary_search(dropped.begin(), dropped.end(), record); }), records.end());
+	for (Record* record : dropped)
+		delete record;
+	dropped.clear();
+}
+
+// Gives the half-edge's contents to the record at to and points its neighbours there
+template<typename T>
+bool MoveRecord(DCEL::BasicHalfEdge<T>* from, DCEL::BasicHalfEdge<T>* to)
+{
+	*to = *from;
+	if (to->twin && to->twin->twin == from)
+		to->twin->twin = to;
+	if (to->next && to->next->prev == from)
+		to->next->prev = to;
+	if (to->prev && to->prev->next == from)
+		to->prev->next = to;
+	if (to->origin && to->origin->incidentEdge == from)
+		to->origin->incidentEdge = to;
+	if (to->incidentFace && to->incidentFace->outerComponent == from)
+		to->incidentFace->outerComponent = to;
+	if (to->incidentFace && to->incidentFace->innerComponent == from)
+		to->incidentFace->innerComponent = to;
+	return true;
+}
+
+// The same for a vertex, whose fan has to close for every edge at it to be found
+template<typename T>
+bool MoveRecord(DCEL::BasicVertex<T>* from, DCEL::BasicVertex<T>* to)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	HalfEdge* start = from->incidentEdge;
+	HalfEdge* edge = start;
+	size_t steps = 0;
+	while (edge)
+	{
+		if (edge->origin != from || nullptr == edge->prev || ++steps > FanLimit)
+			return false;
+		edge = edge->prev->twin;
+		if (edge == start)
+			break;
+	}
+	if (edge != start)
+		return false;
+
+	*to = *from;
+	edge = start;
+	for (size_t i = 0; i < steps; i++, edge = edge->prev->twin)
+	{
+		edge->origin = to;
+		edge->prev->dest = to;
+	}
+	return true;
+}
+
+// The same for a face, whose boundaries have to close
+template<typename T>
+bool MoveRecord(DCEL::BasicFace<T>* from, DCEL::BasicFace<T>* to)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	auto closes = [from](HalfEdge* start)
+	{
+		HalfEdge* edge = start;
+		for (size_t steps = 0; edge && steps <= FanLimit; steps++)
+		{
+			if (edge->incidentFace != from)
+				return false;
+			edge = edge->next;
+			if (edge == start)
+				return true;
+		}
+		return nullptr == start;
+	};
+	if (!closes(from->outerComponent) || !closes(from->innerComponent))
+		return false;
+
+	*to = *from;
+	HalfEdge* const starts[2] = { to->outerComponent, to->innerComponent };
+	for (HalfEdge* start : starts)
+	{
+		HalfEdge* edge = start;
+		while (edge)
+		{
+			edge->incidentFace = to;
+			edge = edge->next;
+			if (edge == start)
+				break;
+		}
+	}
+	if (to->site && to->site->face == from)
+		to->site->face = to;
+	return true;
+}
+
+template<typename Record>
+bool KeptLast(const Record*) { return false; }
+template<typename T>
+bool KeptLast(const DCEL::BasicFace<T>* face) { return face->Unbounded; }
+
+// Takes the records out of the container and deletes them without scanning it. The last
+// record, or the last before the unbounded face, moves into the slot of each one dropped,
+// trading contents as ReorderForLocality does, and moved(from, to) hears of it. Should
+// the neighbours of a record not be found the rest are dropped by a scan.
+template<typename Record, typename Moved>
+void TakeOutRecords(std::vector<Record*>& records, std::vector<Record*>& dropped, Moved moved)
+{
+	while (!dropped.empty())
+	{
+		const size_t keep = (!records.empty() && KeptLast(records.back())) ? 1 : 0;
+		if (records.size() <= keep)
+			break;
+
+		const size_t tail = records.size() - 1 - keep;
+		Record* last = records[tail];
+		const auto found = std::find(dropped.begin(), dropped.end(), last);
+		if (found != dropped.end())
+		{
+			dropped.erase(found);
+		}
+		else
+		{
+			if (!MoveRecord(last, dropped.back()))
+				break;
+			moved(last, dropped.back());
+			dropped.pop_back();
+		}
+		records.erase(records.begin() + tail);
+		delete last;
+	}
+	DropRecords(records, dropped);
+}
+
+// Makes a, b and c the boundary of the face, in that order
+template<typename T>
+void LinkTriangle(DCEL::BasicHalfEdge<T>* a, DCEL::BasicHalfEdge<T>* b, DCEL::BasicHalfEdge<T>* c, DCEL::BasicFace<T>* face)
+{
+	a->next = b;
+	b->next = c;
+	c->next = a;
+	a->prev = c;
+	b->prev = a;
+	c->prev = b;
+	a->incidentFace = b->incidentFace = c->incidentFace = face;
+	face->outerComponent = a;
+}
+
+// Turns the diagonal of the two triangles either side of the edge. x, y, v and y, x, z
+// become v, x, z and z, y, v, the edge is reused as z to v and its twin as v to z.
+// Both triangles must be bounded and together convex.
+template<typename T>
+void FlipEdge(DCEL::BasicHalfEdge<T>* edge)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	HalfEdge* twin = edge->twin;
+	HalfEdge* yv = edge->next;
+	HalfEdge* vx = edge->prev;
+	HalfEdge* xz = twin->next;
+	HalfEdge* zy = twin->prev;
+	DCEL::BasicVertex<T>* x = edge->origin;
+	DCEL::BasicVertex<T>* y = edge->dest;
+	DCEL::BasicFace<T>* xyv = edge->incidentFace;
+	DCEL::BasicFace<T>* yxz = twin->incidentFace;
+
+	if (x->incidentEdge == edge)
+		x->incidentEdge = xz;
+	if (y->incidentEdge == twin)
+		y->incidentEdge = yv;
+
+	edge->origin = zy->origin;
+	edge->dest = vx->origin;
+	twin->origin = vx->origin;
+	twin->dest = zy->origin;
+	LinkTriangle(vx, xz, edge, xyv);
+	LinkTriangle(zy, yv, twin, yxz);
+}
+
+// Sets the ends and the twin of the half-edge
+template<typename T>
+void Join(DCEL::BasicHalfEdge<T>* edge, DCEL::BasicVertex<T>* origin, DCEL::BasicVertex<T>* dest, DCEL::BasicHalfEdge<T>* twin)
+{
+	edge->origin = origin;
+	edge->dest = dest;
+	edge->twin = twin;
+}
+
+// Splits the triangle a, b, c into a, b, v and b, c, v and c, a, v. New half-edges and
+// triangles come from newEdge and newTriangle.
+template<typename T, typename NewEdge, typename NewTriangle>
+void SplitTriangle(DCEL::BasicFace<T>* triangle, DCEL::BasicVertex<T>* v, NewEdge newEdge, NewTriangle newTriangle)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	HalfEdge* ab = triangle->outerComponent;
+	HalfEdge* bc = ab->next;
+	HalfEdge* ca = bc->next;
+	DCEL::BasicVertex<T>* a = ab->origin;
+	DCEL::BasicVertex<T>* b = bc->origin;
+	DCEL::BasicVertex<T>* c = ca->origin;
+
+	HalfEdge* bv = newEdge();
+	HalfEdge* vb = newEdge();
+	HalfEdge* cv = newEdge();
+	HalfEdge* vc = newEdge();
+	HalfEdge* av = newEdge();
+	HalfEdge* va = newEdge();
+	Join(bv, b, v, vb);
+	Join(vb, v, b, bv);
+	Join(cv, c, v, vc);
+	Join(vc, v, c, cv);
+	Join(av, a, v, va);
+	Join(va, v, a, av);
+
+	LinkTriangle(ab, bv, va, triangle);
+	LinkTriangle(bc, cv, vb, newTriangle());
+	LinkTriangle(ca, av, vc, newTriangle());
+	v->incidentEdge = va;
+}
+
+// Splits a, b, c and b, a, d about v on a to b into v, b, c and v, c, a and v, a, d
+// and v, d, b. The edge and its twin become v to b and b to v.
+template<typename T, typename NewEdge, typename NewTriangle>
+void SplitEdge(DCEL::BasicHalfEdge<T>* edge, DCEL::BasicVertex<T>* v, NewEdge newEdge, NewTriangle newTriangle)
+{
+	typedef DCEL::BasicHalfEdge<T> HalfEdge;
+
+	HalfEdge* twin = edge->twin;
+	HalfEdge* bc = edge->next;
+	HalfEdge* ca = bc->next;
+	HalfEdge* ad = twin->next;
+	HalfEdge* db = ad->next;
+	DCEL::BasicVertex<T>* a = edge->origin;
+	DCEL::BasicVertex<T>* c = ca->origin;
+	DCEL::BasicVertex<T>* d = db->origin;
+	DCEL::BasicFace<T>* abc = edge->incidentFace;
+	DCEL::BasicFace<T>* bad = twin->incidentFace;
+
+	HalfEdge* cv = newEdge();
+	HalfEdge* vc = newEdge();
+	HalfEdge* av = newEdge();
+	HalfEdge* va = newEdge();
+	HalfEdge* dv = newEdge();
+	HalfEdge* vd = newEdge();
+	Join(cv, c, v, vc);
+	Join(vc, v, c, cv);
+	Join(av, a, v, va);
+	Join(va, v, a, av);
+	Join(dv, d, v, vd);
+	Join(vd, v, d, dv);
+
+	if (a->incidentEdge == edge)
+		a->incidentEdge = ad;
+	edge->origin = v;
+	twin->dest = v;
+
+	LinkTriangle(edge, bc, cv, abc);
+	LinkTriangle(vc, ca, av, newTriangle());
+	LinkTriangle(va, ad, dv, bad);
+	LinkTriangle(vd, db, twin, newTriangle());
+	v->incidentEdge = edge;
+}